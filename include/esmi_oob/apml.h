@@ -115,6 +115,7 @@ typedef enum {
 #define SBRMI		"sbrmi"		//!< SBRMI module //
 #define SBTSI		"sbtsi"		//!< SBTSI module //
 #define MAX_DEV_COUNT	8		//!< APML ADDRESSES count
+#define APML_MAX_SOCKETS 32		//!< Max sockets reachable through enumeration
 
 extern const uint16_t sbrmi_addr[MAX_DEV_COUNT];	//!< SBRMI addresses //
 extern const uint16_t sbtsi_addr[MAX_DEV_COUNT];	//!< SBTSI addresses //
@@ -305,11 +306,82 @@ oob_status_t sbrmi_xfer_msg(uint8_t soc_num, struct apml_message *msg);
  */
 oob_status_t sbtsi_xfer_msg(uint8_t soc_num, struct apml_message *msg);
 
+/**
+ *  @brief Writes a batch of messages to RMI device file
+ *
+ *  @details This function opens the RMI device file once and issues
+ *  the messages in order through ioctl, stopping at the first failure.
+ *  No delay is inserted between transfers unless the bus reports busy
+ *  or timeout, then the transfer is retried after a delay derived from
+ *  the measured transfer time. The delay is remembered per socket and
+ *  relaxed as transfers succeed. A mailbox message answered with
+ *  ::OOB_MAILBOX_ADD_ERR_DATA does not stop the batch.
+ *
+ *  @param[in] soc_num  Socket index.
+ *
+ *  @param[inout] msgs array of struct apml_message.
+ *
+ *  @param[in] count number of messages.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t sbrmi_xfer_msgs(uint8_t soc_num, struct apml_message *msgs,
+			     uint32_t count);
+
+/**
+ *  @brief Writes a batch of messages to RMI device file, keeping the
+ *  progress on failure
+ *
+ *  @details This function behaves as sbrmi_xfer_msgs() and reports the
+ *  number of messages completed, so the results before a failure can be
+ *  used. A mailbox message answered with ::OOB_MAILBOX_ADD_ERR_DATA
+ *  counts as completed, its firmware code is left in the message.
+ *
+ *  @param[in] soc_num  Socket index.
+ *
+ *  @param[inout] msgs array of struct apml_message.
+ *
+ *  @param[in] count number of messages.
+ *
+ *  @param[out] done number of messages completed.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t sbrmi_xfer_msgs_partial(uint8_t soc_num,
+				     struct apml_message *msgs,
+				     uint32_t count, uint32_t *done);
+
+/**
+ *  @brief Writes a batch of messages to TSI device file
+ *
+ *  @details This function opens the TSI device file once and issues
+ *  the messages in order through ioctl, stopping at the first failure.
+ *  Transfers are paced the same way as sbrmi_xfer_msgs().
+ *
+ *  @param[in] soc_num  Socket index.
+ *
+ *  @param[inout] msgs array of struct apml_message.
+ *
+ *  @param[in] count number of messages.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t sbtsi_xfer_msgs(uint8_t soc_num, struct apml_message *msgs,
+			     uint32_t count);
+
 /**
  *  @brief Validates sbtsi module is present for the given socket
  *
  *  @details This function will validate sbtsi module is present
  *  for the specified socket.
+ *  The presence map built by apml_present_sockets() is used, the
+ *  device nodes are enumerated on the first call only.
  *
  *  @param[in] soc_num  Socket index.
  *
@@ -326,6 +398,8 @@ oob_status_t validate_sbtsi_module(uint8_t soc_num, bool *is_sbtsi);
  *
  *  @details This function will validate sbrmi module is present
  *  for the specified socket.
+ *  The presence map built by apml_present_sockets() is used, the
+ *  device nodes are enumerated on the first call only.
  *
  *  @param[in] soc_num  Socket index.
  *
@@ -342,6 +416,8 @@ oob_status_t validate_sbrmi_module(uint8_t soc_num, bool *is_sbrmi);
  *
  *  @details This function will validate sbrmi and sbtsi modules are present
  *  for the specified socket.
+ *  The presence map built by apml_present_sockets() is used, the
+ *  device nodes are enumerated on the first call only.
  *
  *  @param[in] soc_num  Socket index.
  *
@@ -0,0 +1,174 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_ALERT_H_
+#define INCLUDE_APML_ALERT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "apml_err.h"
+
+/** \file apml_alert.h
+ *  Header file for the SB-TSI alert event API.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to handle SB-TSI ALERT_L events instead of polling the
+ *  temperature. The caller provides the file descriptor signalling the
+ *  alert, a GPIO line event fd or an eventfd, and the library confirms
+ *  every event with one SBTSI::Status read per socket on that source,
+ *  decodes the threshold crossings and calls the registered callback.
+ *  The thresholds and alert behaviour are configured with
+ *  sbtsi_set_hitemp_threshold(), sbtsi_set_lotemp_threshold(),
+ *  sbtsi_set_alert_threshold(), sbtsi_set_alert_config() and
+ *  sbtsi_set_configwr().
+ */
+
+/**
+ * @brief Alert event of a socket
+ */
+struct apml_alert_event {
+	struct timespec ts;	//!< CLOCK_MONOTONIC time of the status read
+	uint8_t status;		//!< SBTSI::Status value
+	bool hi_alert;		//!< Temperature above the high threshold
+	bool lo_alert;		//!< Temperature below the low threshold
+};
+
+/**
+ * @brief Alert callback, called from apml_alert_dispatch()
+ */
+typedef void (*apml_alert_cb)(uint8_t soc_num,
+			      const struct apml_alert_event *event,
+			      void *data);
+
+/** @defgroup AlertEvents SB-TSI alert events
+ *  Below functions dispatch SB-TSI alert events.
+ *  @{
+ */
+
+/**
+ *  @brief Register the alert source of a socket.
+ *
+ *  @details Sockets sharing a wired-OR ALERT_L line register the same
+ *  @p fd. The descriptor stays owned by the caller.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] fd GPIO line event fd or eventfd, readable on alert.
+ *
+ *  @param[in] cb callback for decoded alerts.
+ *
+ *  @param[in] data pointer passed to @p cb.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_alert_register(uint8_t soc_num, int fd, apml_alert_cb cb,
+				 void *data);
+
+/**
+ *  @brief Unregister the alert source of a socket.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_FOUND is returned if the socket is not registered.
+ *
+ */
+oob_status_t apml_alert_unregister(uint8_t soc_num);
+
+/**
+ *  @brief Wait for alerts and dispatch them.
+ *
+ *  @details This function waits up to @p timeout_ms for an alert source
+ *  to become readable, consumes the pending source events and reads
+ *  SBTSI::Status once for every socket registered on a signalled source.
+ *  The callback is called for sockets with a high or low alert set,
+ *  events without one are counted as spurious and events whose status
+ *  read failed are counted as errors. No bus transaction is
+ *  made while no alert is signalled.
+ *
+ *  @param[in] timeout_ms timeout in ms, -1 waits forever.
+ *
+ *  @param[out] handled number of callbacks called, may be NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_TRY_AGAIN is returned on timeout.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if no source is registered.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_alert_dispatch(int timeout_ms, uint32_t *handled);
+
+/**
+ *  @brief Get the number of spurious alert events.
+ *
+ *  @details An event is spurious when SBTSI::Status showed neither a
+ *  high nor a low alert.
+ *
+ *  @param[out] count spurious events since the first registration.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_alert_spurious(uint64_t *count);
+
+/**
+ *  @brief Get the number of alert events lost to a failed status read.
+ *
+ *  @details The alert was signalled but SBTSI::Status could not be read,
+ *  so the callback was not called.
+ *
+ *  @param[out] count lost events since the first registration.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_alert_errors(uint64_t *count);
+
+/** @} */  // end of AlertEvents
+
+#endif  // INCLUDE_APML_ALERT_H_
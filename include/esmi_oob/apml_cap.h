@@ -0,0 +1,214 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_CAP_H_
+#define INCLUDE_APML_CAP_H_
+
+#include <stdint.h>
+
+#include "apml_err.h"
+
+/** \file apml_cap.h
+ *  Header file for the mailbox capability map of the APML library.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to probe, query and persist the per socket bitmap of
+ *  the mailbox commands supported by the firmware.
+ *  Once a command is known to be unsupported on a socket, the mailbox
+ *  APIs return ::OOB_MAILBOX_CMD_UNKNOWN without accessing the bus.
+ */
+
+#define APML_CAP_CMD_MAX	256	//!< Mailbox command id range tracked //
+#define APML_CAP_WORDS		(APML_CAP_CMD_MAX / 64)	//!< Bitmap words //
+
+/**
+ * @brief Capability state of a mailbox command on a socket
+ */
+typedef enum {
+	APML_CAP_UNKNOWN,	//!< Command not issued or probed yet
+	APML_CAP_SUPPORTED,	//!< Firmware accepted the command
+	APML_CAP_UNSUPPORTED,	//!< Firmware reported unknown command
+} apml_cap_state;
+
+/**
+ * @brief Per socket mailbox capability map.
+ * The map is valid only for the firmware identified by ppin and
+ * smu_fw_ver. Bit N of probed[] is set once the state of mailbox
+ * command N is known, bit N of supported[] holds that state.
+ */
+struct apml_cap_map {
+	uint64_t ppin;				//!< PPIN of the socket
+	uint32_t smu_fw_ver;			//!< SMU firmware version
+	uint64_t probed[APML_CAP_WORDS];	//!< Commands with known state
+	uint64_t supported[APML_CAP_WORDS];	//!< Supported commands
+};
+
+/** @defgroup CapabilityMap Mailbox capability map
+ *  Below functions maintain the mailbox capability map per socket.
+ *  @{
+ */
+
+/**
+ *  @brief Get the capability state of a mailbox command.
+ *
+ *  @details This function returns the cached state of the mailbox
+ *  command for the given socket. No bus access is performed.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] cmd mailbox command.
+ *
+ *  @retval ::apml_cap_state of the command.
+ *
+ */
+apml_cap_state apml_cap_get(uint8_t soc_num, uint32_t cmd);
+
+/**
+ *  @brief Record the outcome of a mailbox command.
+ *
+ *  @details This function updates the capability map from the status
+ *  returned by the firmware for the given command. Transport errors
+ *  leave the map unchanged. The mailbox read/write APIs call this
+ *  function on every transfer.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] cmd mailbox command.
+ *
+ *  @param[in] status status returned by the mailbox transfer.
+ *
+ */
+void apml_cap_record(uint8_t soc_num, uint32_t cmd, oob_status_t status);
+
+/**
+ *  @brief Probe the mailbox capabilities of a socket.
+ *
+ *  @details This function issues every read only mailbox command known
+ *  to the library with a neutral input and records which of them are
+ *  supported. Commands with side effects are never probed, their state
+ *  is learnt the first time they are used.
+ *  The PPIN and SMU firmware version identifying the map are read as
+ *  part of the probe.
+ *
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-19h_Mod-90h-9Fh,
+ *  \ref Fam-1Ah_Mod-00h-0Fh
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_cap_probe(uint8_t soc_num);
+
+/**
+ *  @brief Get a copy of the capability map of a socket.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] map capability map.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_cap_get_map(uint8_t soc_num, struct apml_cap_map *map);
+
+/**
+ *  @brief Install a capability map for a socket.
+ *
+ *  @details This function replaces the capability map of the socket.
+ *  The caller is responsible for the map matching the firmware.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] map capability map.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_cap_set_map(uint8_t soc_num, const struct apml_cap_map *map);
+
+/**
+ *  @brief Forget the capability map of a socket.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ */
+void apml_cap_reset(uint8_t soc_num);
+
+/**
+ *  @brief Save the capability map of a socket to a file.
+ *
+ *  @details The file is replaced atomically. When path is NULL the
+ *  default file under ::APML_CACHE_DIR is used.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] path file path or NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_cap_save(uint8_t soc_num, const char *path);
+
+/**
+ *  @brief Load the capability map of a socket from a file.
+ *
+ *  @details The map is installed only if the PPIN and SMU firmware
+ *  version stored in the file match the ones read from the socket,
+ *  otherwise ::OOB_TRY_AGAIN is returned and the current map is kept.
+ *  When path is NULL the default file under ::APML_CACHE_DIR is used.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] path file path or NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_cap_load(uint8_t soc_num, const char *path);
+
+/** @} */  // end of CapabilityMap
+
+#endif  // INCLUDE_APML_CAP_H_
@@ -53,6 +53,9 @@
 #define shift_left_op(val, bits) ((uint32_t)val << bits) //!< Performs shift left for the specified bits
 
 
+/* Directory holding the run time cache files of the library */
+#define APML_CACHE_DIR		"/run/apml"	//!< Cache directory //
+
 /* Default data for input */
 #define DEFAULT_DATA            0
 #define BIT_LEN			1	//!< Bit length //
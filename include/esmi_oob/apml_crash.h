@@ -0,0 +1,261 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_CRASH_H_
+#define INCLUDE_APML_CRASH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "apml_err.h"
+
+/** \file apml_crash.h
+ *  Header file for the sync flood crash collection.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to collect the crash logs of every socket after a sync
+ *  flood within the reset delay, the binary crash record format and a
+ *  reader of crash record files.
+ *
+ *  A crash record file is append only, records follow each other. A
+ *  record is a struct apml_crash_hdr followed by its sections, every
+ *  section is a struct apml_crash_section followed by its data padded to
+ *  8 bytes. The record length and CRC32 in the header let a reader skip
+ *  records and check them without parsing the sections.
+ */
+
+#define APML_CRASH_MAGIC	0x48535243	//!< "CRSH" //
+#define APML_CRASH_VERSION	2		//!< Record layout version //
+
+#define APML_CRASH_DELAY_SET	(1U << 0)	//!< Reset delay extended //
+#define APML_CRASH_TIMEOUT	(1U << 1)	//!< Budget ran out //
+
+#define APML_CRASH_POST_CODES	8	//!< Post codes cached by the SMU //
+
+/**
+ * @brief Crash record section types
+ */
+typedef enum {
+	APML_CRASH_MCA = 1,	//!< struct apml_mca_dump
+	APML_CRASH_DF,		//!< struct apml_df_log entries
+	APML_CRASH_SOC,		//!< struct apml_crash_soc_info
+	APML_CRASH_RT,		//!< struct apml_crash_rt entries
+} apml_crash_section_type;
+
+/**
+ * @brief Crash record header, followed by the sections
+ */
+struct apml_crash_hdr {
+	uint32_t magic;		//!< ::APML_CRASH_MAGIC
+	uint16_t version;	//!< ::APML_CRASH_VERSION
+	uint16_t sections;	//!< Sections following the header
+	uint32_t len;		//!< Record bytes, header included
+	uint32_t crc;		//!< CRC32 of the record with crc zero
+	uint32_t flags;		//!< APML_CRASH_* flags
+	uint32_t budget_ms;	//!< Collection budget
+	uint64_t time;		//!< CLOCK_REALTIME seconds of the collection
+	uint64_t rtc;		//!< RTC read by read_rtc() on socket 0
+	uint64_t elapsed_us;	//!< Collection time
+};
+
+/**
+ * @brief Crash record section header, followed by len bytes
+ */
+struct apml_crash_section {
+	uint16_t type;		//!< apml_crash_section_type
+	uint8_t soc_num;	//!< Socket index
+	uint8_t reserved;	//!< Reserved
+	int32_t status;		//!< oob_status_t of the collection
+	uint32_t len;		//!< Bytes of data, without the padding
+	uint32_t reserved1;	//!< Reserved
+};
+
+/**
+ * @brief Identity of a socket in a crash record
+ */
+struct apml_crash_soc_info {
+	uint64_t ppin;		//!< PPIN read by read_ppin_fuse()
+	uint32_t ucode;		//!< Microcode revision
+	uint32_t post_code[APML_CRASH_POST_CODES];	//!< Most recent first
+};
+
+/**
+ * @brief Runtime error of a crash record, entries follow each other
+ */
+struct apml_crash_rt {
+	uint8_t category;	//!< apml_rt_err_category
+	uint8_t reserved;	//!< Reserved
+	uint16_t instance;	//!< Valid instance index
+	uint16_t len;		//!< Bytes in @ref data
+	uint16_t reserved1;	//!< Reserved
+	uint32_t data[];	//!< Record dwords
+};
+
+/**
+ * @brief Crash record file mapped by apml_crash_open()
+ */
+struct apml_crash_file {
+	const uint8_t *base;	//!< File mapping
+	size_t size;		//!< File size
+};
+
+/**
+ * @brief Crash collection options
+ */
+struct apml_crash_opts {
+	uint32_t budget_ms;	//!< Collection budget, 0 for no limit
+	uint8_t delay_min;	//!< Reset delay override [5 - 120] minutes,
+				//!< 0 keeps the configured delay
+	bool hold;		//!< Stop the reset delay counter
+	bool no_release;	//!< Do not request the reset at the end
+};
+
+/** @defgroup CrashCollection Sync flood crash collection
+ *  Below functions collect the RAS logs before the sync flood reset.
+ *  @{
+ */
+
+/**
+ *  @brief Collect the crash logs of sockets and write a crash record.
+ *
+ *  @details This function extends the reset delay on sync flood, then
+ *  collects every socket in parallel until the budget runs out: the MCA
+ *  banks with valid status first, then the PPIN, microcode revision and
+ *  post codes, the DF error logs and the runtime errors. The record is
+ *  built in memory and written to @p fd with one sequential write, open
+ *  @p fd with O_APPEND to append to a record file. The reset is then
+ *  requested with reset_on_sync_flood(). The delay override, the reset
+ *  and the RTC are handled by socket 0.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] socs sockets to collect.
+ *
+ *  @param[in] count number of sockets.
+ *
+ *  @param[in] opts collection options.
+ *
+ *  @param[in] fd file descriptor receiving the record.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call, the record
+ *  flags and section status report partial collections.
+ *  @retval ::OOB_NOT_SUPPORTED is returned if the record was written but
+ *  the firmware did not acknowledge the reset.
+ *  @retval Non-zero is returned upon failure, or if the record was
+ *  written but the reset request failed.
+ *
+ */
+oob_status_t apml_crash_collect(const uint8_t *socs, uint8_t count,
+				const struct apml_crash_opts *opts, int fd);
+
+/** @} */  // end of CrashCollection
+
+/** @defgroup CrashRecordReader Crash record reader
+ *  Below functions iterate the records of a mapped crash record file.
+ *  @{
+ */
+
+/**
+ *  @brief Map a crash record file.
+ *
+ *  @param[in] path crash record file.
+ *
+ *  @param[out] file mapping of the file.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_crash_open(const char *path, struct apml_crash_file *file);
+
+/**
+ *  @brief Unmap a crash record file.
+ *
+ *  @param[in] file mapping of the file.
+ *
+ */
+void apml_crash_close(struct apml_crash_file *file);
+
+/**
+ *  @brief Next record of a crash record file.
+ *
+ *  @details Only the record header is checked, a truncated or foreign
+ *  record ends the iteration.
+ *
+ *  @param[in] file mapping of the file.
+ *
+ *  @param[in] prev previous record, NULL for the first one.
+ *
+ *  @retval next record, NULL at the end of the file.
+ *
+ */
+const struct apml_crash_hdr *apml_crash_next(const struct apml_crash_file *file,
+					     const struct apml_crash_hdr *prev);
+
+/**
+ *  @brief Check the CRC32 of a record.
+ *
+ *  @param[in] rec record returned by apml_crash_next().
+ *
+ *  @retval true if the record is intact.
+ *
+ */
+bool apml_crash_verify(const struct apml_crash_hdr *rec);
+
+/**
+ *  @brief Next section of a record.
+ *
+ *  @details The section data follows the section header.
+ *
+ *  @param[in] rec record returned by apml_crash_next().
+ *
+ *  @param[in] prev previous section, NULL for the first one.
+ *
+ *  @retval next section, NULL at the end of the record.
+ *
+ */
+const struct apml_crash_section *
+apml_crash_next_section(const struct apml_crash_hdr *rec,
+			const struct apml_crash_section *prev);
+
+/** @} */  // end of CrashRecordReader
+
+#endif  // INCLUDE_APML_CRASH_H_
@@ -0,0 +1,175 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_ENUM_H_
+#define INCLUDE_APML_ENUM_H_
+
+#include <stdint.h>
+
+#include "apml_err.h"
+
+/** \file apml_enum.h
+ *  Header file for the APML device enumeration.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to enumerate the SBRMI and SBTSI device nodes present
+ *  in the system and to map socket indexes to device nodes.
+ *  Without enumeration, socket N is reached through the fixed address
+ *  table entry N or the /dev/sbrmiN, /dev/sbtsiN nodes.
+ */
+
+#define APML_DEV_PATH_SIZE	32	//!< Max length of a device node path //
+
+/**
+ * @brief APML device node of a socket
+ */
+struct apml_node {
+	char path[APML_DEV_PATH_SIZE];	//!< Device node, e.g. /dev/sbrmi-3c
+	uint16_t addr;			//!< Target address, 0 if unknown
+	int16_t bus;			//!< I2C/I3C bus number, -1 if unknown
+};
+
+/** @defgroup DevEnum Device enumeration
+ *  Below functions enumerate the APML device nodes.
+ *  @{
+ */
+
+/**
+ *  @brief Enumerate the APML device nodes.
+ *
+ *  @details This function scans /dev for all sbrmi and sbtsi nodes and
+ *  resolves their bus and address through /sys/class/misc, then builds
+ *  the socket to node map used by every transfer.
+ *  Nodes at the addresses of the fixed address table keep the socket
+ *  index of the table, nodes named by index keep that index and nodes
+ *  at any other address take the free socket indexes in (bus, address)
+ *  order. A SBTSI node at a custom address is paired with the socket of
+ *  the SBRMI node on the same bus at address - 0x10.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_FOUND is returned when no node is present.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_enumerate(void);
+
+/**
+ *  @brief Forget the enumerated device nodes.
+ *
+ *  @details The socket map is cleared, device nodes are looked up
+ *  through the fixed address table until the next apml_enumerate().
+ *  apml_fini() calls this so that nodes removed while the library was
+ *  down are not used.
+ *
+ */
+void apml_enum_reset(void);
+
+/**
+ *  @brief Get the device node of a socket.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] client DEV_SBRMI[0]/DEV_SBTSI[1] enum: apml_client
+ *
+ *  @param[out] node device node of the socket.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if the nodes have not been
+ *  enumerated.
+ *  @retval ::OOB_FILE_ERROR is returned if the socket has no such node.
+ *
+ */
+oob_status_t apml_get_node(uint8_t soc_num, uint8_t client,
+			   struct apml_node *node);
+
+/**
+ *  @brief Watch the APML device nodes.
+ *
+ *  @details This function returns a non blocking inotify file
+ *  descriptor watching /dev. When it becomes readable the caller
+ *  invokes apml_enum_watch_handle() to refresh the socket map after a
+ *  driver bind or unbind.
+ *
+ *  @param[out] fd inotify file descriptor.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_enum_watch(int *fd);
+
+/**
+ *  @brief Process the pending events of the watch descriptor.
+ *
+ *  @details The socket map is rebuilt if a sbrmi or sbtsi node was
+ *  created or removed.
+ *
+ *  @param[in] fd inotify file descriptor from apml_enum_watch().
+ *
+ *  @param[out] changed set to 1 if the socket map was rebuilt, can be
+ *  NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_enum_watch_handle(int fd, int *changed);
+
+/**
+ *  @brief Get the sockets with SBRMI and SBTSI device nodes.
+ *
+ *  @details Bit N of each mask is set if socket N has the device node.
+ *  The masks are computed by apml_enumerate(), which is run on the
+ *  first call if the nodes were not enumerated yet. Afterwards the call
+ *  is a single memory read, no file system access is performed.
+ *
+ *  @param[out] rmi_mask sockets with a SBRMI node, can be NULL.
+ *
+ *  @param[out] tsi_mask sockets with a SBTSI node, can be NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_present_sockets(uint32_t *rmi_mask, uint32_t *tsi_mask);
+
+/** @} */  // end of DevEnum
+
+#endif  // INCLUDE_APML_ENUM_H_
@@ -0,0 +1,167 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_FREQ_H_
+#define INCLUDE_APML_FREQ_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "apml_err.h"
+#include "esmi_rmi.h"
+
+/** \file apml_freq.h
+ *  Header file for the APERF/MPERF effective frequency sampler.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to sample the effective frequency of every enabled
+ *  thread. A sampler thread per socket reads APERF and MPERF of all
+ *  enabled threads at an interval with esmi_oob_read_msr_multi() and
+ *  turns the counter deltas into an effective frequency and a C0 share
+ *  per thread and per CCX. Results go to a preallocated per socket
+ *  snapshot.
+ */
+
+/**
+ * @brief Threads of a socket covered by a snapshot
+ */
+#define APML_FREQ_MAX_THREADS	(APML_THREAD_MASK_WORDS * 64)
+
+/**
+ * @brief Sampler options
+ */
+struct apml_freq_opts {
+	uint32_t period_ms;	//!< Sampling period, 0 for 1000 ms
+	uint16_t ref_mhz;	//!< MPERF frequency, 0 reads the base
+				//!< frequency with
+				//!< read_bmc_cpu_base_frequency()
+};
+
+/**
+ * @brief Effective frequency of a thread or a CCX over a period
+ */
+struct apml_freq_stat {
+	uint16_t freq_mhz;	//!< Effective frequency while in C0
+	uint16_t threads;	//!< Threads with a valid sample
+	float c0;		//!< Share of the period in C0 [0 - 1]
+};
+
+/**
+ * @brief Effective frequency snapshot of a socket
+ */
+struct apml_freq_snapshot {
+	struct timespec ts;	//!< CLOCK_MONOTONIC middle of the sweep
+	uint64_t seq;		//!< Sequence number, gaps are lost samples
+	uint32_t period_us;	//!< Time covered by the deltas
+	uint16_t ref_mhz;	//!< MPERF frequency
+	uint16_t threads;	//!< Threads of the socket
+	uint16_t threads_per_core;	//!< Threads per core
+	uint16_t threads_per_ccx;	//!< Threads sharing an L3
+	uint16_t ccx_count;	//!< CCXs of the socket
+	struct apml_thread_mask valid;	//!< Threads with a valid sample
+	struct apml_freq_stat thread[APML_FREQ_MAX_THREADS];	//!< Per thread
+	struct apml_freq_stat ccx[APML_FREQ_MAX_THREADS];	//!< Per CCX
+};
+
+/** @defgroup FreqSampler APERF/MPERF frequency sampler
+ *  Below functions sample the effective frequency of the threads.
+ *  @{
+ */
+
+/**
+ *  @brief Start the frequency sampler of a socket.
+ *
+ *  @details This function reads the topology with esmi_get_threads_per_core()
+ *  and read_max_threads_per_l3() and starts a thread sweeping APERF and
+ *  MPERF over the enabled threads once per period. Threads are grouped
+ *  per CCX through the apml_topo_build() map. Without it, thread t is on
+ *  core t % cores, the SMT siblings of a core being cores apart, and the
+ *  core on CCX core / (threads_per_ccx / threads_per_core). The
+ *  effective frequency is
+ *  ref_mhz * dAPERF / dMPERF and the C0 share is dMPERF over the MPERF
+ *  ticks of the period. A counter wrap is absorbed by the unsigned delta,
+ *  a counter going back, as after a reset, invalidates the thread for
+ *  that period. The first snapshot is published after two sweeps.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] opts sampler options or NULL for the defaults.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_TRY_AGAIN is returned if the sampler is running.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_freq_start(uint8_t soc_num,
+			     const struct apml_freq_opts *opts);
+
+/**
+ *  @brief Stop the frequency sampler of a socket.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if the sampler is not
+ *  running.
+ *
+ */
+oob_status_t apml_freq_stop(uint8_t soc_num);
+
+/**
+ *  @brief Read the latest frequency snapshot of a socket.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] snap latest snapshot.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if the sampler is not
+ *  running.
+ *  @retval ::OOB_TRY_AGAIN is returned before the first snapshot.
+ *
+ */
+oob_status_t apml_freq_read(uint8_t soc_num,
+			    struct apml_freq_snapshot *snap);
+
+/** @} */  // end of FreqSampler
+
+#endif  // INCLUDE_APML_FREQ_H_
@@ -0,0 +1,130 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_HWMON_H_
+#define INCLUDE_APML_HWMON_H_
+
+#include <stdint.h>
+
+#include "apml_err.h"
+
+/** \file apml_hwmon.h
+ *  Header file for the hwmon backend of the APML library.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to serve the socket temperature, power and power
+ *  limit from the hwmon attributes of the sbtsi and sbrmi kernel
+ *  drivers. The attributes are kept open and read with pread(), which
+ *  is cheaper than the ioctl path. While the backend is open,
+ *  sbtsi_get_cputemp(), read_socket_power() and read_socket_power_limit()
+ *  use it and fall back to the ioctl path when an attribute is missing.
+ */
+
+/** @defgroup HwmonBackend hwmon backend
+ *  Below functions manage the hwmon backend.
+ *  @{
+ */
+
+/**
+ *  @brief Open the hwmon backend.
+ *
+ *  @details This function scans /sys/class/hwmon for the sbtsi and
+ *  sbrmi devices, maps them to sockets through their bus address and
+ *  keeps their temp1_input, power1_input and power1_cap attributes
+ *  open.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_FOUND is returned when no hwmon device is found.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_hwmon_open(void);
+
+/**
+ *  @brief Close the hwmon backend.
+ */
+void apml_hwmon_close(void);
+
+/**
+ *  @brief Read the CPU temperature from hwmon.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] cpu_temp temperature in degree C.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_SUPPORTED is returned if the attribute is not open.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_hwmon_read_temp(uint8_t soc_num, float *cpu_temp);
+
+/**
+ *  @brief Read the socket power from hwmon.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] power socket power in mW.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_SUPPORTED is returned if the attribute is not open.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_hwmon_read_power(uint8_t soc_num, uint32_t *power);
+
+/**
+ *  @brief Read the socket power limit from hwmon.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] power_limit socket power limit in mW.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_SUPPORTED is returned if the attribute is not open.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_hwmon_read_power_limit(uint8_t soc_num,
+					 uint32_t *power_limit);
+
+/** @} */  // end of HwmonBackend
+
+#endif  // INCLUDE_APML_HWMON_H_
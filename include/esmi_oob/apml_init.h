@@ -0,0 +1,153 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_INIT_H_
+#define INCLUDE_APML_INIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "apml_err.h"
+#include "apml_inventory.h"
+
+/** \file apml_init.h
+ *  Header file for the APML library initialization.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to initialize and release the library state.
+ *  Once initialized, the library keeps the static description of every
+ *  socket (platform, threads, RAPL units, mailbox capabilities) in
+ *  memory instead of rediscovering it inside every API call.
+ *  Without apml_init() the library behaves as before and reads the
+ *  platform on every call.
+ */
+
+/**
+ * @brief Socket discovery modes
+ */
+typedef enum {
+	APML_INIT_LAZY,		//!< Discover a socket on its first use
+	APML_INIT_EAGER,	//!< Discover all present sockets in apml_init()
+} apml_init_mode;
+
+/**
+ * @brief Library initialization options
+ */
+struct apml_init_opts {
+	apml_init_mode mode;	//!< Discovery mode
+	uint8_t num_sockets;	//!< Sockets to manage, 0 for ::APML_MAX_SOCKETS
+	bool use_cache_file;	//!< Use the inventory cache file
+	bool probe_caps;	//!< Probe mailbox capabilities on discovery
+	bool use_hwmon;		//!< Serve temperature and power from hwmon
+};
+
+/** @defgroup LibInit Library initialization
+ *  Below functions initialize and release the library state.
+ *  @{
+ */
+
+/**
+ *  @brief Initialize the APML library.
+ *
+ *  @details The APML device nodes are enumerated, see apml_enumerate().
+ *  In eager mode all present sockets are discovered in
+ *  parallel before returning, in lazy mode a socket is discovered the
+ *  first time an API needs its description. A socket failing eager
+ *  discovery is retried lazily. With use_hwmon the hwmon backend is
+ *  opened, see apml_hwmon_open(). Passing NULL selects lazy mode without
+ *  cache file.
+ *
+ *  @param[in] opts initialization options or NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_FOUND is returned when no socket is present in
+ *  eager mode.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_init(const struct apml_init_opts *opts);
+
+/**
+ *  @brief Release the APML library state.
+ *
+ *  @details After this call the library reads the platform on every
+ *  API call again.
+ *
+ */
+void apml_fini(void);
+
+/**
+ *  @brief Get the inventory of a socket.
+ *
+ *  @details This function returns the in memory inventory of the
+ *  socket, discovering it first if needed.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] inv inventory of the socket.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if apml_init() was not
+ *  called.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_get_inventory(uint8_t soc_num, struct apml_inventory *inv);
+
+/**
+ *  @brief Get the RAPL energy status unit multiplier of a socket.
+ *
+ *  @details The multiplier is 1/2^ESU, read once per socket.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] esu energy status unit multiplier.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if apml_init() was not
+ *  called.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_get_esu_multiplier(uint8_t soc_num, float *esu);
+
+/** @} */  // end of LibInit
+
+#endif  // INCLUDE_APML_INIT_H_
@@ -0,0 +1,156 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_INVENTORY_H_
+#define INCLUDE_APML_INVENTORY_H_
+
+#include <stdint.h>
+
+#include "apml_cap.h"
+#include "apml_err.h"
+#include "esmi_cpuid_msr.h"
+
+/** \file apml_inventory.h
+ *  Header file for the platform inventory cache of the APML library.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to discover the static description of a socket and to
+ *  keep it in a cache file, so that one shot tools can skip the CPUID
+ *  and register transactions needed to identify the platform.
+ */
+
+/**
+ * @brief Static description of a socket.
+ * Fields which could not be read from the platform are left as 0.
+ */
+struct apml_inventory {
+	struct processor_info proc;	//!< Family, model and stepping
+	uint8_t rmi_rev;		//!< SBRMI revision
+	uint8_t p_type;			//!< Platform, enum PROC_DETAILS
+	uint32_t ucode_rev;		//!< Microcode revision, cache key
+	uint32_t threads_per_socket;	//!< Threads per socket
+	uint32_t threads_per_core;	//!< Threads per core
+	uint32_t threads_per_l3;	//!< Threads sharing a L3 cache
+	uint16_t max_cores_per_ccx;	//!< Max cores per CCX
+	uint16_t ccx_instances;		//!< Logical CCX instances
+	struct apml_cap_map caps;	//!< Mailbox capability map
+};
+
+/** @defgroup InventoryCache Platform inventory cache
+ *  Below functions discover and cache the platform inventory.
+ *  @{
+ */
+
+/**
+ *  @brief Get the platform type for a processor.
+ *
+ *  @details This function maps the SBRMI revision and the processor
+ *  family and model to the enum PROC_DETAILS.
+ *
+ *  @param[in] rmi_rev SBRMI revision.
+ *
+ *  @param[in] proc processor family, model and stepping.
+ *
+ *  @retval enum PROC_DETAILS value.
+ *
+ */
+uint8_t apml_get_proc_type(uint8_t rmi_rev, const struct processor_info *proc);
+
+/**
+ *  @brief Discover the inventory of a socket.
+ *
+ *  @details This function reads the full inventory of the socket from
+ *  the platform, bypassing any cache.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] inv inventory of the socket.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_inventory_read(uint8_t soc_num, struct apml_inventory *inv);
+
+/**
+ *  @brief Save the inventory of a socket to a cache file.
+ *
+ *  @details The file is replaced atomically. When path is NULL the
+ *  default file under ::APML_CACHE_DIR is used.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] path file path or NULL.
+ *
+ *  @param[in] inv inventory of the socket.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_inventory_save(uint8_t soc_num, const char *path,
+				 const struct apml_inventory *inv);
+
+/**
+ *  @brief Get the inventory of a socket, using the cache file if valid.
+ *
+ *  @details The cached inventory is validated with a single read, the
+ *  microcode revision when the platform reports one, the SBRMI revision
+ *  otherwise. On a mismatch or a missing file the inventory is read
+ *  from the platform and the cache file is rewritten.
+ *  The capability map of the inventory is installed for the socket.
+ *  When path is NULL the default file under ::APML_CACHE_DIR is used.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] path file path or NULL.
+ *
+ *  @param[out] inv inventory of the socket.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_inventory_get(uint8_t soc_num, const char *path,
+				struct apml_inventory *inv);
+
+/** @} */  // end of InventoryCache
+
+#endif  // INCLUDE_APML_INVENTORY_H_
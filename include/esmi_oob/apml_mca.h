@@ -0,0 +1,209 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_MCA_H_
+#define INCLUDE_APML_MCA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "apml_err.h"
+
+/** \file apml_mca.h
+ *  Header file for the MCA bank decoder.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to decode the MCA registers of a bank, dumped by
+ *  read_bmc_ras_mca_msr_dump() or read with esmi_oob_read_msr(), into
+ *  structured fields. Decoding uses static tables only and never
+ *  allocates.
+ */
+
+/**
+ * @brief MCA MSRs of a bank, in the order of the bank MSR block
+ */
+typedef enum {
+	APML_MCA_CTL = 0,	//!< MCA_CTL
+	APML_MCA_STATUS,	//!< MCA_STATUS
+	APML_MCA_ADDR,		//!< MCA_ADDR
+	APML_MCA_MISC0,		//!< MCA_MISC0
+	APML_MCA_CONFIG,	//!< MCA_CONFIG
+	APML_MCA_IPID,		//!< MCA_IPID
+	APML_MCA_SYND,		//!< MCA_SYND
+	APML_MCA_DESTAT = 8,	//!< MCA_DESTAT
+	APML_MCA_DEADDR,	//!< MCA_DEADDR
+	APML_MCA_MISC1,		//!< MCA_MISC1
+	APML_MCA_MISC2,		//!< MCA_MISC2
+	APML_MCA_MISC3,		//!< MCA_MISC3
+	APML_MCA_MISC4,		//!< MCA_MISC4
+	APML_MCA_REGS = 16,	//!< MSRs in a bank block
+} apml_mca_reg;
+
+/**
+ * @brief MCA bank types, from the hardware ID and MCA type of MCA_IPID
+ */
+typedef enum {
+	APML_MCA_BANK_UNKNOWN = 0,	//!< Not in the platform table
+	APML_MCA_BANK_LS,		//!< Load store unit
+	APML_MCA_BANK_IF,		//!< Instruction fetch unit
+	APML_MCA_BANK_L2,		//!< L2 cache unit
+	APML_MCA_BANK_DE,		//!< Decode unit
+	APML_MCA_BANK_EX,		//!< Execution unit
+	APML_MCA_BANK_FP,		//!< Floating point unit
+	APML_MCA_BANK_L3,		//!< L3 cache unit
+	APML_MCA_BANK_CS,		//!< Coherent slave
+	APML_MCA_BANK_PIE,		//!< Power, interrupts, etc.
+	APML_MCA_BANK_MALL,		//!< Memory attached last level cache
+	APML_MCA_BANK_UMC,		//!< Unified memory controller
+	APML_MCA_BANK_PB,		//!< Parameter block
+	APML_MCA_BANK_PSP,		//!< Platform security processor
+	APML_MCA_BANK_SMU,		//!< System management unit
+	APML_MCA_BANK_MP5,		//!< Microprocessor 5 unit
+	APML_MCA_BANK_MPDMA,		//!< MPDMA unit
+	APML_MCA_BANK_NBIO,		//!< Northbridge IO unit
+	APML_MCA_BANK_PCIE,		//!< PCI express unit
+	APML_MCA_BANK_XGMI_PCS,		//!< xGMI PCS unit
+	APML_MCA_BANK_NBIF,		//!< NBIF unit
+	APML_MCA_BANK_SHUB,		//!< System hub unit
+	APML_MCA_BANK_SATA,		//!< SATA unit
+	APML_MCA_BANK_USB,		//!< USB unit
+	APML_MCA_BANK_GMI_PCS,		//!< GMI PCS unit
+	APML_MCA_BANK_XGMI_PHY,		//!< xGMI PHY unit
+	APML_MCA_BANK_WAFL_PHY,		//!< WAFL PHY unit
+	APML_MCA_BANK_GMI_PHY,		//!< GMI PHY unit
+	APML_MCA_BANK_TYPES,		//!< Number of bank types
+} apml_mca_bank_type;
+
+/**
+ * @brief MCA registers of a bank
+ */
+struct apml_mca_regs {
+	uint64_t reg[APML_MCA_REGS];	//!< MSRs indexed by apml_mca_reg
+};
+
+/**
+ * @brief Decoded MCA bank
+ */
+struct apml_mca_info {
+	apml_mca_bank_type type;	//!< Bank type
+	uint16_t hwid;			//!< MCA_IPID hardware ID
+	uint16_t mca_type;		//!< MCA_IPID MCA type
+	uint32_t instance_id;		//!< MCA_IPID instance ID
+	uint8_t instance_id_hi;		//!< MCA_IPID instance ID high bits
+	uint16_t error_code;		//!< MCA_STATUS error code
+	uint8_t error_code_ext;		//!< MCA_STATUS extended error code
+	uint8_t core_id;		//!< MCA_STATUS error core ID
+	bool valid;			//!< MCA_STATUS Val
+	bool overflow;			//!< MCA_STATUS Overflow
+	bool uc;			//!< MCA_STATUS UC, uncorrected
+	bool en;			//!< MCA_STATUS En
+	bool misc_valid;		//!< MCA_STATUS MiscV
+	bool addr_valid;		//!< MCA_STATUS AddrV
+	bool pcc;			//!< MCA_STATUS PCC, context corrupt
+	bool core_id_valid;		//!< MCA_STATUS ErrCoreIdVal
+	bool tcc;			//!< MCA_STATUS TCC, task corrupt
+	bool synd_valid;		//!< MCA_STATUS SyndV
+	bool deferred;			//!< MCA_STATUS Deferred
+	bool poison;			//!< MCA_STATUS Poison
+	uint64_t addr;			//!< MCA_ADDR error address
+	uint8_t addr_lsb;		//!< MCA_ADDR least significant valid bit
+	uint32_t syndrome;		//!< MCA_SYND syndrome
+	uint8_t synd_len;		//!< MCA_SYND syndrome length in bits
+	uint32_t err_info;		//!< MCA_SYND error information
+};
+
+/** @defgroup MCADecode MCA bank decoder
+ *  Below functions decode MCA bank registers.
+ *  @{
+ */
+
+/**
+ *  @brief Load the registers of a bank from dumped dwords.
+ *
+ *  @details The dump of a bank holds the bank MSRs in block order, the
+ *  low dword of a MSR first. Registers beyond @p bytes are zero.
+ *
+ *  @param[in] data bank dwords, as in struct apml_mca_dump.
+ *
+ *  @param[in] bytes bytes per bank.
+ *
+ *  @param[out] regs bank registers.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_mca_regs_from_dump(const uint32_t *data, uint16_t bytes,
+				     struct apml_mca_regs *regs);
+
+/**
+ *  @brief Decode the registers of a bank.
+ *
+ *  @details The bank type is looked up in the table of the platform,
+ *  MCA_STATUS, MCA_ADDR and MCA_SYND are decoded in @p info.
+ *
+ *  @param[in] p_type platform, enum PROC_DETAILS.
+ *
+ *  @param[in] regs bank registers.
+ *
+ *  @param[out] info decoded fields.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_SUPPORTED is returned for a platform without
+ *  scalable MCA.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_mca_decode(uint8_t p_type, const struct apml_mca_regs *regs,
+			     struct apml_mca_info *info);
+
+/**
+ *  @brief Name of a bank type.
+ *
+ *  @param[in] type bank type.
+ *
+ *  @retval static string naming the bank type.
+ *
+ */
+const char *apml_mca_bank_name(apml_mca_bank_type type);
+
+/** @} */  // end of MCADecode
+
+#endif  // INCLUDE_APML_MCA_H_
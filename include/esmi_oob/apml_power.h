@@ -0,0 +1,200 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_POWER_H_
+#define INCLUDE_APML_POWER_H_
+
+#include <stdint.h>
+
+#include "apml_err.h"
+
+/** \file apml_power.h
+ *  Header file for the streaming power accumulator.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to derive power from energy counters. An accumulator
+ *  is fed raw counter samples, RAPL package or core counters in energy
+ *  status units or the MI300 energy accumulator in 2^-16 J, keeps the
+ *  energy as an integer count of counter units across counter wraps and
+ *  answers the average power over any window of its sample history.
+ *  Conversion to joules happens once, on the final delta.
+ */
+
+#define APML_POWER_HISTORY	64	//!< Samples kept per accumulator //
+
+/**
+ * @brief Energy counter feeding an accumulator
+ */
+typedef enum {
+	APML_POWER_RAPL_PKG,	//!< read_rapl_pckg_energy_raw()
+	APML_POWER_RAPL_CORE,	//!< read_rapl_core_energy_sweep()
+	APML_POWER_MI300,	//!< get_energy_accum_raw()
+} apml_power_source;
+
+/**
+ * @brief Sample of an accumulator history
+ */
+struct apml_power_sample {
+	uint64_t energy;	//!< Counter units since the first sample
+	uint64_t ts_ns;		//!< Time of the sample, CLOCK_MONOTONIC or
+				//!< firmware time for ::APML_POWER_MI300
+};
+
+/**
+ * @brief Streaming power accumulator, set up by apml_power_init()
+ */
+struct apml_power_acc {
+	apml_power_source source;	//!< Counter source
+	uint8_t soc_num;	//!< Socket index
+	uint32_t core_id;	//!< Core of ::APML_POWER_RAPL_CORE
+	double unit_j;		//!< Joules per counter unit
+	uint64_t last_raw;	//!< Last raw counter
+	uint64_t last_fw_ts;	//!< Last raw firmware time stamp
+	int64_t fw_offset_ns;	//!< CLOCK_MONOTONIC minus firmware time,
+				//!< smallest seen
+	uint64_t fw_ns;		//!< Firmware time extended over its wrap
+	uint32_t head;		//!< Samples written
+	struct apml_power_sample hist[APML_POWER_HISTORY];	//!< History
+};
+
+/** @defgroup PowerAccumulator Streaming power accumulator
+ *  Below functions derive power from energy counter samples.
+ *  @{
+ */
+
+/**
+ *  @brief Set up a power accumulator.
+ *
+ *  @details For the RAPL sources the energy status unit of the socket is
+ *  read once and kept in the accumulator.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh, ::APML_POWER_MI300 on
+ *  \ref Fam-19h_Mod-90h-9Fh only.
+ *
+ *  @param[out] acc accumulator.
+ *
+ *  @param[in] source counter source.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] core_id core id of ::APML_POWER_RAPL_CORE, ignored
+ *  otherwise.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_power_init(struct apml_power_acc *acc,
+			     apml_power_source source, uint8_t soc_num,
+			     uint32_t core_id);
+
+/**
+ *  @brief Add a raw counter sample to an accumulator.
+ *
+ *  @details The delta to the previous counter is taken modulo 2^64, so
+ *  a counter wrap costs nothing. The time stamps must not go back.
+ *  This is O(1), the oldest sample is dropped once the history is
+ *  full.
+ *
+ *  @param[inout] acc accumulator.
+ *
+ *  @param[in] raw raw counter.
+ *
+ *  @param[in] ts_ns time of the counter in nanoseconds.
+ *
+ */
+void apml_power_feed(struct apml_power_acc *acc, uint64_t raw,
+		     uint64_t ts_ns);
+
+/**
+ *  @brief Read the counter of an accumulator and add the sample.
+ *
+ *  @details RAPL counters are stamped with CLOCK_MONOTONIC at the read.
+ *  The MI300 accumulator is stamped with the firmware time stamp latched
+ *  with the energy, extended over its 56 bit wrap, so the deltas carry
+ *  no bus latency. Adding fw_offset_ns, the smallest CLOCK_MONOTONIC
+ *  minus firmware time seen, lines these samples up with the other
+ *  sources. A read returning the time stamp of the previous one carries
+ *  no new energy and is dropped.
+ *
+ *  @param[inout] acc accumulator.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_power_sample(struct apml_power_acc *acc);
+
+/**
+ *  @brief Get the average power of an accumulator over a window.
+ *
+ *  @details The window ends at the last sample and starts at the
+ *  newest sample at least @p window_ns older, or at the oldest sample
+ *  in the history. Pass 0 for the last two samples.
+ *
+ *  @param[in] acc accumulator.
+ *
+ *  @param[in] window_ns window in nanoseconds.
+ *
+ *  @param[out] watts average power.
+ *
+ *  @param[out] span_ns time actually covered, may be NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_TRY_AGAIN is returned before two samples.
+ *
+ */
+oob_status_t apml_power_avg(const struct apml_power_acc *acc,
+			    uint64_t window_ns, double *watts,
+			    uint64_t *span_ns);
+
+/**
+ *  @brief Get the energy counted by an accumulator.
+ *
+ *  @param[in] acc accumulator.
+ *
+ *  @retval energy in joules since the first sample.
+ *
+ */
+double apml_power_energy(const struct apml_power_acc *acc);
+
+/** @} */  // end of PowerAccumulator
+
+#endif  // INCLUDE_APML_POWER_H_
@@ -0,0 +1,531 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_RAS_H_
+#define INCLUDE_APML_RAS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "apml_err.h"
+#include "esmi_rmi.h"
+
+/** \file apml_ras.h
+ *  Header file for the RAS collection API.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to watch SBRMI::RASStatus and the SB-RMI alert status
+ *  at a low cost and to run the RAS collection only when they change.
+ */
+
+/**
+ * @brief MCA dump written by apml_ras_dump_mca(), the banks follow the
+ * header back to back
+ */
+struct apml_mca_dump {
+	uint16_t mca_banks;	//!< Banks with valid status
+	uint16_t bytes_per_mca;	//!< Bytes per bank
+	uint16_t banks_done;	//!< Complete banks in @ref data
+	uint16_t add_err;	//!< Set when bank banks_done was answered
+				//!< with additional error data
+	uint32_t add_err_data;	//!< Additional error data, valid with add_err
+	uint32_t data[];	//!< Bank dwords, bank after bank
+};
+
+/**
+ * @brief DF block IDs reported by the DF error validity check
+ */
+#define APML_DF_BLOCK_IDS	256
+
+/**
+ * @brief DF error log of a block instance, logs follow each other in a
+ * buffer
+ */
+struct apml_df_log {
+	uint8_t block_id;	//!< DF block ID
+	uint8_t add_err;	//!< Set when the log stops at additional
+				//!< error data
+	uint16_t instance;	//!< DF block instance
+	uint16_t len;		//!< Bytes in @ref data
+	uint16_t reserved;	//!< Reserved
+	uint32_t add_err_data;	//!< Additional error data, valid with add_err
+	uint32_t data[];	//!< Error log dwords
+};
+
+/**
+ * @brief DF error validity of every DF block
+ */
+struct apml_df_check {
+	uint16_t instances[APML_DF_BLOCK_IDS];	//!< Instances with a log
+	uint16_t log_len[APML_DF_BLOCK_IDS];	//!< Log bytes per instance
+	uint32_t add_err_data[APML_DF_BLOCK_IDS];	//!< Additional error
+							//!< data reported
+	oob_status_t status[APML_DF_BLOCK_IDS];	//!< Check result per block,
+						//!< counts valid on success
+	uint32_t size;		//!< Bytes needed to dump every log
+};
+
+/**
+ * @brief Runtime error categories of the runtime error validity check
+ */
+typedef enum {
+	APML_RT_ERR_MCA = 0,	//!< MCA
+	APML_RT_ERR_DRAM_CECC,	//!< DRAM correctable ECC
+	APML_RT_ERR_PCIE,	//!< PCIe
+	APML_RT_ERR_CATEGORIES,	//!< Number of categories
+} apml_rt_err_category;
+
+/**
+ * @brief Largest runtime error record kept, in bytes
+ */
+#define APML_RT_ERR_MAX_BYTES	256
+
+/**
+ * @brief DRAM CECC counter decoded from the first dword of the record
+ */
+struct apml_cecc_info {
+	uint16_t err_count;	//!< Error count
+	uint8_t channel;	//!< Channel number
+	uint8_t sub_channel;	//!< Sub channel
+	uint8_t chip_select;	//!< Chip select number
+	uint8_t rank_mult;	//!< Rank multiplier number
+};
+
+/**
+ * @brief Runtime error record of a valid instance
+ */
+struct apml_rt_err {
+	struct timespec ts;	//!< CLOCK_MONOTONIC time of the harvest
+	uint8_t soc_num;	//!< Socket index
+	uint8_t category;	//!< apml_rt_err_category
+	uint16_t instance;	//!< Valid instance index
+	uint16_t len;		//!< Bytes in @ref data
+	bool truncated;		//!< Record longer than
+				//!< ::APML_RT_ERR_MAX_BYTES
+	struct apml_cecc_info cecc;	//!< Decoded for DRAM CECC only
+	uint32_t data[APML_RT_ERR_MAX_BYTES / 4];	//!< Record dwords
+};
+
+/**
+ * @brief Lock free queue of runtime error records
+ */
+struct apml_rt_queue;
+
+/**
+ * @brief RAS status change seen by the poller
+ */
+struct apml_ras_event {
+	struct timespec ts;	//!< CLOCK_MONOTONIC time of the read
+	uint8_t ras_status;	//!< SBRMI::RASStatus
+	uint8_t status;		//!< SBRMI::Status
+	uint16_t mca_banks;	//!< MCA banks with valid status
+	uint16_t bytes_per_mca;	//!< Bytes per MCA bank
+	struct apml_thread_mask alert;	//!< Threads with an alert status
+};
+
+/**
+ * @brief Logs collected by the poller on a RAS status change, each
+ * collector reports its own status
+ */
+struct apml_ras_collection {
+	struct apml_mca_dump *mca;	//!< MCA banks, see apml_ras_dump_mca()
+	uint32_t mca_len;		//!< Bytes in @ref mca
+	oob_status_t mca_ret;		//!< MCA dump status
+	void *df;			//!< struct apml_df_log entries
+	uint32_t df_len;		//!< Bytes in @ref df
+	oob_status_t df_ret;		//!< DF dump status
+	uint32_t rt_count;		//!< Runtime error records pushed
+	oob_status_t rt_ret;		//!< Runtime error harvest status
+};
+
+/**
+ * @brief RAS collection callback
+ *
+ * Called from the poller thread on a state change with a non-zero
+ * SBRMI::RASStatus or alert status, after the collection. The buffers
+ * of @p coll are freed when the callback returns, the poller then
+ * clears the reported RASStatus bits.
+ */
+typedef void (*apml_ras_cb)(uint8_t soc_num,
+			    const struct apml_ras_event *event,
+			    const struct apml_ras_collection *coll,
+			    void *data);
+
+/**
+ * @brief RAS poller options
+ */
+struct apml_ras_poll_opts {
+	uint32_t period_ms;	//!< Poll period, 0 for the default
+	apml_ras_cb cb;		//!< Collection callback
+	void *data;		//!< Callback data
+	struct apml_rt_queue *rt_queue;	//!< Runtime error records, NULL
+					//!< skips the harvest
+	bool no_clear;		//!< Keep SBRMI::RASStatus after the callback
+};
+
+/** @defgroup RASPoller RAS status poller
+ *  Below functions watch the RAS status and trigger the collection.
+ *  @{
+ */
+
+/**
+ *  @brief Poll the RAS status of a socket once.
+ *
+ *  @details This function reads SBRMI::RASStatus and SBRMI::Status
+ *  through one device handle and compares them with the previous poll of
+ *  the socket. The alert status registers are read only when
+ *  SBRMI::Status reports a pending alert. On a change with a non-zero
+ *  RASStatus or a thread alert the MCA validity check is read into
+ *  @p event. Nothing else is read in the steady state.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] event status read, valid when @p changed is set.
+ *
+ *  @param[out] changed set when the collection should run.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_ras_poll(uint8_t soc_num, struct apml_ras_event *event,
+			   bool *changed);
+
+/**
+ *  @brief Start the RAS poller of a socket.
+ *
+ *  @details This function starts a thread calling apml_ras_poll() every
+ *  period. On a change the poller runs the collection chain, MCA dump,
+ *  DF error dump and, with a queue in @p opts, the runtime error
+ *  harvest, passes the logs to the callback and clears the reported
+ *  bits with clear_sbrmi_ras_status(). Periods missed during a slow
+ *  collection are skipped.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] opts poller options.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_TRY_AGAIN is returned if the poller is running.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_ras_poll_start(uint8_t soc_num,
+				 const struct apml_ras_poll_opts *opts);
+
+/**
+ *  @brief Stop the RAS poller of a socket.
+ *
+ *  @details A running callback completes before the poller stops.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if the poller is not
+ *  running.
+ *
+ */
+oob_status_t apml_ras_poll_stop(uint8_t soc_num);
+
+/** @} */  // end of RASPoller
+
+/** @defgroup RASCollection RAS bulk collection
+ *  Below functions collect the RAS error logs in bulk.
+ *  @{
+ */
+
+/**
+ *  @brief Check a collection deadline.
+ *
+ *  @param[in] deadline CLOCK_MONOTONIC deadline, NULL for none.
+ *
+ *  @retval true once @p deadline has passed, false otherwise or without
+ *  a deadline.
+ *
+ */
+bool apml_deadline_expired(const struct timespec *deadline);
+
+/**
+ *  @brief Dump every MCA bank with valid status after a fatal error.
+ *
+ *  @details This function reads the MCA validity check, then reads every
+ *  dword of every valid bank in one batch through a single device
+ *  handle into @p buf as a struct apml_mca_dump. The header is written
+ *  even on failure with banks_done set to the banks read completely, so
+ *  a caller under a deadline keeps the banks collected. A dword answered
+ *  with ::OOB_MAILBOX_ADD_ERR_DATA ends the dump, its bank is left out
+ *  and the additional error data is kept in the header.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] buf buffer for the struct apml_mca_dump.
+ *
+ *  @param[in] len size of @p buf in bytes.
+ *
+ *  @param[out] written bytes written to @p buf.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NO_MEMORY is returned if not every bank fits in @p buf,
+ *  the banks fitting are dumped.
+ *  @retval ::OOB_MAILBOX_ADD_ERR_DATA is returned if the dump stopped at
+ *  additional error data.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_ras_dump_mca(uint8_t soc_num, void *buf, uint32_t len,
+			       uint32_t *written);
+
+/**
+ *  @brief Dump the MCA banks with valid status until a deadline.
+ *
+ *  @details This function behaves as apml_ras_dump_mca() but reads a
+ *  few banks per batch and stops once @p deadline has passed, leaving
+ *  the banks read so far in @p buf.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] buf buffer for the struct apml_mca_dump.
+ *
+ *  @param[in] len size of @p buf in bytes.
+ *
+ *  @param[out] written bytes written to @p buf.
+ *
+ *  @param[in] deadline CLOCK_MONOTONIC deadline, NULL for none.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_CMD_TIMEOUT is returned if the deadline passed.
+ *  @retval ::OOB_NO_MEMORY is returned if not every bank fits in @p buf.
+ *  @retval ::OOB_MAILBOX_ADD_ERR_DATA is returned if the dump stopped at
+ *  additional error data.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_ras_dump_mca_until(uint8_t soc_num, void *buf,
+				     uint32_t len, uint32_t *written,
+				     const struct timespec *deadline);
+
+/**
+ *  @brief Read the DF error validity of every DF block.
+ *
+ *  @details This function sends the DF error validity check of every DF
+ *  block ID in one batch. A block answered with
+ *  ::OOB_MAILBOX_ADD_ERR_DATA reports its additional error data instead
+ *  of the log counts. A block ID the firmware rejects gets the error in
+ *  its status and has no log. The batch continues with the next block
+ *  in both cases.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] check validity of every DF block and the dump size.
+ *
+ *  @retval ::OOB_SUCCESS is returned if at least one block was checked.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_ras_df_check(uint8_t soc_num, struct apml_df_check *check);
+
+/**
+ *  @brief Dump the DF error logs reported by a validity check.
+ *
+ *  @details This function reads every log of every DF block instance
+ *  in @p check, one batch per DF block, into @p buf as struct
+ *  apml_df_log entries. Blocks with additional error data get an empty
+ *  log carrying it. A log dword answered with additional error data
+ *  ends the log of that instance, the log keeps the dwords before it
+ *  and carries the data. The dump stops once @p deadline has passed,
+ *  the logs read so far stay in @p buf.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] check validity read by apml_ras_df_check().
+ *
+ *  @param[out] buf buffer for the logs, check->size bytes dump all.
+ *
+ *  @param[in] len size of @p buf in bytes.
+ *
+ *  @param[out] written bytes written to @p buf.
+ *
+ *  @param[in] deadline CLOCK_MONOTONIC deadline, NULL for none.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_CMD_TIMEOUT is returned if the deadline passed.
+ *  @retval ::OOB_NO_MEMORY is returned if not every log fits in @p buf.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_ras_dump_df_until(uint8_t soc_num,
+				    const struct apml_df_check *check,
+				    void *buf, uint32_t len, uint32_t *written,
+				    const struct timespec *deadline);
+
+/**
+ *  @brief Dump every DF error log of a socket.
+ *
+ *  @details This function runs apml_ras_df_check() and
+ *  apml_ras_dump_df_until() without a deadline.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] buf buffer for the struct apml_df_log entries.
+ *
+ *  @param[in] len size of @p buf in bytes.
+ *
+ *  @param[out] written bytes written to @p buf.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NO_MEMORY is returned if not every log fits in @p buf.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_ras_dump_df(uint8_t soc_num, void *buf, uint32_t len,
+			      uint32_t *written);
+
+/** @} */  // end of RASCollection
+
+/** @defgroup RASRuntimeHarvest RAS runtime error harvest
+ *  Below functions harvest the runtime errors into a lock free queue.
+ *  Any number of threads can push and pop the queue concurrently.
+ *  @{
+ */
+
+/**
+ *  @brief Create a runtime error queue.
+ *
+ *  @param[in] depth records held, rounded up to a power of 2.
+ *
+ *  @param[out] queue new queue.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_rt_queue_create(uint32_t depth,
+				  struct apml_rt_queue **queue);
+
+/**
+ *  @brief Destroy a runtime error queue.
+ *
+ *  @param[in] queue queue without users left.
+ *
+ */
+void apml_rt_queue_destroy(struct apml_rt_queue *queue);
+
+/**
+ *  @brief Push a record to the queue without blocking.
+ *
+ *  @param[in] queue runtime error queue.
+ *
+ *  @param[in] err record to copy.
+ *
+ *  @retval true if pushed, false if the queue is full and the record
+ *  was dropped.
+ *
+ */
+bool apml_rt_queue_push(struct apml_rt_queue *queue,
+			const struct apml_rt_err *err);
+
+/**
+ *  @brief Pop the oldest record of the queue without blocking.
+ *
+ *  @param[in] queue runtime error queue.
+ *
+ *  @param[out] err record popped.
+ *
+ *  @retval true if popped, false if the queue is empty.
+ *
+ */
+bool apml_rt_queue_pop(struct apml_rt_queue *queue, struct apml_rt_err *err);
+
+/**
+ *  @brief Number of records dropped on a full queue.
+ *
+ *  @param[in] queue runtime error queue.
+ *
+ *  @retval dropped records.
+ *
+ */
+uint64_t apml_rt_queue_dropped(struct apml_rt_queue *queue);
+
+/**
+ *  @brief Harvest the runtime errors of every category of a socket.
+ *
+ *  @details This function reads the runtime error validity check of
+ *  MCA, DRAM CECC and PCIe, then every dword of every valid instance
+ *  of a category in one batch, and pushes one decoded record per
+ *  instance to @p queue. Records not fitting in the queue are dropped
+ *  and counted.
+ *  Supported platforms: \ref Fam-1Ah_Mod-00h-0Fh
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] interrupt_mode request type of the validity check, false
+ *  for polling mode.
+ *
+ *  @param[in] queue queue receiving the records.
+ *
+ *  @param[out] count records pushed, may be NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure, the records harvested
+ *  before the failure are in the queue.
+ *
+ */
+oob_status_t apml_ras_rt_harvest(uint8_t soc_num, bool interrupt_mode,
+				 struct apml_rt_queue *queue,
+				 uint32_t *count);
+
+/** @} */  // end of RASRuntimeHarvest
+
+#endif  // INCLUDE_APML_RAS_H_
@@ -0,0 +1,161 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_SAMPLER_H_
+#define INCLUDE_APML_SAMPLER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "apml_err.h"
+
+/** \file apml_sampler.h
+ *  Header file for the SB-TSI thermal sampler.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to sample the CPU temperature once per SB-TSI sensor
+ *  update. A sampler thread per socket reads SBTSI::UpdateRate, locks on
+ *  the sensor update phase and reads the temperature right after every
+ *  update into a ring buffer of timestamped samples.
+ */
+
+/**
+ * @brief Sampler options
+ */
+struct apml_sampler_opts {
+	float update_rate;	//!< Rate to set in Hz, 0 keeps the current rate
+	uint32_t depth;		//!< Ring buffer samples, 0 for the default,
+				//!< rounded up to a power of 2
+};
+
+/**
+ * @brief Timestamped temperature sample
+ */
+struct apml_temp_sample {
+	struct timespec ts;	//!< CLOCK_MONOTONIC time of the read
+	uint64_t seq;		//!< Sequence number, gaps are lost samples
+	float temp;		//!< CPU temperature in degree C
+};
+
+/** @defgroup ThermalSampler SB-TSI thermal sampler
+ *  Below functions sample the CPU temperature at the sensor update rate.
+ *  @{
+ */
+
+/**
+ *  @brief Start the thermal sampler of a socket.
+ *
+ *  @details This function optionally sets SBTSI::UpdateRate, reads it
+ *  back and starts a thread reading the CPU temperature once per update
+ *  period. The read is scheduled shortly after the sensor update, found
+ *  by watching for the first temperature change. When the ring buffer
+ *  is full the oldest sample is overwritten.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] opts sampler options or NULL for the defaults.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_TRY_AGAIN is returned if the sampler is running.
+ *  @retval ::OOB_INVALID_INPUT is returned if the update rate read back
+ *  is not a positive rate.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_sampler_start(uint8_t soc_num,
+				const struct apml_sampler_opts *opts);
+
+/**
+ *  @brief Stop the thermal sampler of a socket.
+ *
+ *  @details Samples not read yet are discarded.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if the sampler is not
+ *  running.
+ *
+ */
+oob_status_t apml_sampler_stop(uint8_t soc_num);
+
+/**
+ *  @brief Read samples from the ring buffer of a socket.
+ *
+ *  @details This function moves up to @p max of the oldest samples to
+ *  @p samples without blocking.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] samples array of at least @p max samples.
+ *
+ *  @param[in] max size of @p samples.
+ *
+ *  @param[out] count number of samples read.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if the sampler is not
+ *  running.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_sampler_read(uint8_t soc_num,
+			       struct apml_temp_sample *samples,
+			       uint32_t max, uint32_t *count);
+
+/**
+ *  @brief Get the sampling period of a running sampler.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] period_us sampling period in microseconds.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_INITIALIZED is returned if the sampler is not
+ *  running.
+ *
+ */
+oob_status_t apml_sampler_period(uint8_t soc_num, uint64_t *period_us);
+
+/** @} */  // end of ThermalSampler
+
+#endif  // INCLUDE_APML_SAMPLER_H_
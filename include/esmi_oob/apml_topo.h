@@ -0,0 +1,192 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *                 AMD Research and AMD Software Development
+ *
+ *                 Advanced Micro Devices, Inc.
+ *
+ *                 www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#ifndef INCLUDE_APML_TOPO_H_
+#define INCLUDE_APML_TOPO_H_
+
+#include <stdint.h>
+
+#include "apml_err.h"
+#include "esmi_rmi.h"
+
+/** \file apml_topo.h
+ *  Header file for the socket topology map.
+ *
+ *  @details  This header file contains the following:
+ *  APIs prototype to build the CCD, CCX, core and thread hierarchy of a
+ *  socket from the x2APIC ID of every enabled thread, the APIC ID
+ *  layout reported by CPUID 0xB, 0x8000001D and 0x80000026, and the
+ *  SB-RMI thread enable registers. Once built, the map turns an APML
+ *  thread index into its place in the hierarchy and back in constant
+ *  time, so per core values can be aggregated per CCX and CCD.
+ */
+
+#define APML_TOPO_MAX_THREADS	(APML_THREAD_MASK_WORDS * 64)	//!< Threads //
+#define APML_TOPO_MAX_SMT	2	//!< Threads per core //
+#define APML_TOPO_MAX_CCX	32	//!< CCXs per socket //
+#define APML_TOPO_MAX_CCD	16	//!< CCDs per socket //
+#define APML_TOPO_NONE		0xFFFF	//!< No thread or core //
+
+/**
+ * @brief Place of an APML thread in the hierarchy
+ */
+struct apml_topo_thread {
+	uint32_t apic_id;	//!< x2APIC ID
+	uint16_t core;		//!< Core index in the socket
+	uint8_t ccx;		//!< CCX index in the socket
+	uint8_t ccd;		//!< CCD index in the socket
+	uint8_t core_in_ccx;	//!< Core index in the CCX
+	uint8_t ccx_in_ccd;	//!< CCX index in the CCD
+	uint8_t smt;		//!< Thread index in the core
+	uint8_t enabled;	//!< Thread enabled, the rest is valid
+};
+
+/**
+ * @brief Core of a socket
+ */
+struct apml_topo_core {
+	uint16_t thread[APML_TOPO_MAX_SMT];	//!< APML threads, by SMT index
+	uint8_t threads;	//!< Enabled threads
+	uint8_t ccx;		//!< CCX index in the socket
+};
+
+/**
+ * @brief CCX of a socket, its cores are contiguous
+ */
+struct apml_topo_ccx {
+	uint16_t first_core;	//!< Index of the first core
+	uint16_t cores;		//!< Enabled cores
+	uint8_t ccd;		//!< CCD index in the socket
+};
+
+/**
+ * @brief CCD of a socket, its CCXs are contiguous
+ */
+struct apml_topo_ccd {
+	uint8_t first_ccx;	//!< Index of the first CCX
+	uint8_t ccxs;		//!< CCXs with an enabled core
+};
+
+/**
+ * @brief Topology map of a socket, indexes are dense and follow the
+ * x2APIC ID order
+ */
+struct apml_topo {
+	uint16_t threads;	//!< Enabled threads
+	uint16_t cores;		//!< Enabled cores
+	uint8_t ccxs;		//!< CCXs with an enabled core
+	uint8_t ccds;		//!< CCDs with an enabled core
+	uint8_t threads_per_core;	//!< Threads per core
+	uint8_t ccd_from_cpuid;	//!< CCDs read from CPUID 0x80000026
+	struct apml_topo_thread thread[APML_TOPO_MAX_THREADS];	//!< By thread
+	struct apml_topo_core core[APML_TOPO_MAX_THREADS];	//!< By core
+	struct apml_topo_ccx ccx[APML_TOPO_MAX_CCX];	//!< By CCX
+	struct apml_topo_ccd ccd[APML_TOPO_MAX_CCD];	//!< By CCD
+};
+
+/** @defgroup TopologyMap Socket topology map
+ *  Below functions build and query the topology map of a socket.
+ *  @{
+ */
+
+/**
+ *  @brief Build the topology map of a socket.
+ *
+ *  @details This function reads the enabled threads with
+ *  sbrmi_get_thread_masks(), the APIC ID layout on the first enabled
+ *  thread, then one x2APIC ID per enabled thread. Core, CCX and CCD
+ *  boundaries come from the core, complex and die levels of CPUID
+ *  0x80000026 when the platform has it. Otherwise cores come from CPUID
+ *  0xB, CCX boundaries from the L3 sharing of CPUID 0x8000001D, and
+ *  every CCX is taken as its own CCD.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] topo topology map.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_NOT_SUPPORTED is returned if the socket does not fit
+ *  the map limits.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t apml_topo_build(uint8_t soc_num, struct apml_topo *topo);
+
+/**
+ *  @brief Get the APML thread at a place of the hierarchy.
+ *
+ *  @param[in] topo topology map.
+ *
+ *  @param[in] ccd CCD index in the socket.
+ *
+ *  @param[in] ccx CCX index in the CCD.
+ *
+ *  @param[in] core core index in the CCX.
+ *
+ *  @param[in] smt thread index in the core.
+ *
+ *  @retval APML thread index.
+ *  @retval ::APML_TOPO_NONE is returned if there is no such thread.
+ *
+ */
+uint16_t apml_topo_thread_at(const struct apml_topo *topo, uint8_t ccd,
+			     uint8_t ccx, uint8_t core, uint8_t smt);
+
+/**
+ *  @brief Get the threads of a CCX.
+ *
+ *  @param[in] topo topology map.
+ *
+ *  @param[in] ccx CCX index in the socket.
+ *
+ *  @param[out] mask threads of the CCX.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_INVALID_INPUT is returned if there is no such CCX.
+ *
+ */
+oob_status_t apml_topo_ccx_threads(const struct apml_topo *topo, uint8_t ccx,
+				   struct apml_thread_mask *mask);
+
+/** @} */  // end of TopologyMap
+
+#endif  // INCLUDE_APML_TOPO_H_
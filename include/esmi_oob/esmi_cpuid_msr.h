@@ -41,7 +41,10 @@
 #ifndef INCLUDE_APML_CPUID_MSR_H_
 #define INCLUDE_APML_CPUID_MSR_H_
 
+#include <stdint.h>
+
 #include "apml_err.h"
+#include "esmi_rmi.h"
 
 /** \file esmi_cpuid_msr.h
  *  Header file for the APML library cpuid and msr read functions.
@@ -185,8 +188,50 @@ oob_status_t esmi_oob_read_msr(uint8_t soc_num,
 			       uint32_t thread, uint32_t msraddr,
 			       uint64_t *buffer);
 
+/**
+ *  @brief Read a set of MCA MSR registers on a set of threads.
+ *
+ *  @details The threads are validated once against the socket
+ *  inventory, or the thread count when apml_init() was not called, and
+ *  the disabled threads are skipped. The reads are issued thread after
+ *  thread in ascending order, so the thread selection changes as little
+ *  as possible, and submitted in batches with sbrmi_xfer_msgs_partial().
+ *  Value i of thread t is written to @p out[t * @p n_msr + i], values of
+ *  the threads not read are left untouched.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] msrs MCA MSR registers to read.
+ *
+ *  @param[in] n_msr number of registers in @p msrs.
+ *
+ *  @param[inout] thread_mask threads to read, on return the threads
+ *  read. On failure the threads before the failing one are read.
+ *
+ *  @param[out] out values, (highest thread + 1) * @p n_msr entries.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval None-zero is returned upon failure.
+ */
+oob_status_t esmi_oob_read_msr_multi(uint8_t soc_num, const uint32_t *msrs,
+				     uint32_t n_msr,
+				     struct apml_thread_mask *thread_mask,
+				     uint64_t *out);
+
 /** @} */  // end of ProcessorAccess
 
+/**
+ * @brief CPUID leaf request and result
+ */
+struct esmi_cpuid_leaf {
+	uint32_t fn_eax;	//!< CPUID function
+	uint32_t fn_ecx;	//!< CPUID extended function [0 - 15]
+	uint32_t eax;		//!< Returned eax
+	uint32_t ebx;		//!< Returned ebx
+	uint32_t ecx;		//!< Returned ecx
+	uint32_t edx;		//!< Returned edx
+};
+
 /*****************************************************************************/
 /** @defgroup cpuidAccess SB-RMI CPUID Register Access
  *  Below function provide interface to get the CPUID access via the SBRMI.
@@ -222,6 +267,29 @@ oob_status_t esmi_oob_cpuid(uint8_t soc_num,
 			    uint32_t thread, uint32_t *eax, uint32_t *ebx,
 			    uint32_t *ecx, uint32_t *edx);
 
+/**
+ *  @brief Read a set of CPUID leaves for a particular thread.
+ *
+ *  @details The thread is validated once. Every leaf takes two
+ *  transactions, one returning eax/ebx and one returning ecx/edx, and
+ *  the transactions are submitted in batches with sbrmi_xfer_msgs().
+ *  The extended function is 4 bits wide in the SB-RMI CPUID command.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] thread is a particular thread in the system.
+ *
+ *  @param[inout] leaves leaves to read, the registers are filled in.
+ *
+ *  @param[in] count number of leaves.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval None-zero is returned upon failure.
+ */
+oob_status_t esmi_oob_cpuid_multi(uint8_t soc_num, uint32_t thread,
+				  struct esmi_cpuid_leaf *leaves,
+				  uint32_t count);
+
 /**
  *  @brief Read eax register on CPUID functionality.
  *
@@ -269,6 +269,14 @@ struct max_ddr_bw {
 	uint8_t utilized_pct;		//!< Utliized Bandwidth percentage
 };
 
+/**
+ * @brief RAPL core energy counter read by read_rapl_core_energy_sweep().
+ */
+struct rapl_core_energy {
+	uint64_t counter;	//!< Raw 64 bit energy counter
+	double joules;		//!< Energy in joules
+};
+
 /**
  * @brief MCA bank information.It contains 16 bit Index for MCA Bank
  * and 16 bit offset.
@@ -490,6 +498,7 @@ extern float esu_multiplier;
  *  @details Given socket number and a pointer to a uint32_t
  *  @p buffer, this function will get the current power consumption
  *  (in watts) to the uint32_t pointed to by @p buffer.
+ *  The value is read from hwmon when the backend is open.
  *  Supported platforms: \ref Fam-19h_Mod-00h-0Fh, \ref Fam-19h_Mod-10h-1Fh,
  *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
  *
@@ -509,6 +518,7 @@ oob_status_t read_socket_power(uint8_t soc_num, uint32_t *buffer);
  *
  *  @details This function will return the valid power cap @p buffer for a given
  *  socket, this value will be used for the system to limit the power.
+ *  The value is read from hwmon when the backend is open.
  *  Supported platforms: \ref Fam-19h_Mod-00h-0Fh, \ref Fam-19h_Mod-10h-1Fh,
  *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
  *
@@ -1610,6 +1620,34 @@ oob_status_t read_rapl_core_energy_counters(uint8_t soc_num,
 					    uint32_t core_id,
 					    double *energy_counters);
 
+/**
+ *  @brief Read the RAPL energy counters of a set of cores.
+ *
+ *  @details This function reads the high and low words of every core in
+ *  one batch, high word first. The high word is read again only for the
+ *  cores whose low word is close past the wrap, which is the only case
+ *  where the pair can tear. The energy status unit is read once per
+ *  socket and cached.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] core_ids core ids to read, NULL for 0 to @p count - 1.
+ *
+ *  @param[in] count number of cores.
+ *
+ *  @param[out] energy array of @p count counters.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t read_rapl_core_energy_sweep(uint8_t soc_num,
+					 const uint32_t *core_ids,
+					 uint32_t count,
+					 struct rapl_core_energy *energy);
+
 /**
  *  @brief Read RAPL package energy counters.
  *
@@ -1628,6 +1666,25 @@ oob_status_t read_rapl_core_energy_counters(uint8_t soc_num,
 oob_status_t read_rapl_pckg_energy_counters(uint8_t soc_num,
 					    double *energy_counters);
 
+/**
+ *  @brief Read the raw RAPL package energy counter.
+ *
+ *  @details This function returns the 64 bit package energy counter in
+ *  energy status units, see read_bmc_rapl_units(). The high word is
+ *  read again only when the low word is close past the wrap.
+ *  Supported platforms: \ref Fam-19h_Mod-10h-1Fh, \ref Fam-1Ah_Mod-00h-0Fh
+ *  and \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] counter raw package energy counter.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t read_rapl_pckg_energy_raw(uint8_t soc_num, uint64_t *counter);
+
 /**
  *  @brief Write power efficiency profile policy.
  *
@@ -41,6 +41,8 @@
 #ifndef INCLUDE_APML_RMI_H_
 #define INCLUDE_APML_RMI_H_
 
+#include <stdbool.h>
+
 #include "apml_err.h"
 
 /** \file esmi_rmi.h
@@ -128,6 +130,92 @@ extern const uint8_t alert_status[MAX_ALERT_REG];
  */
 extern const uint8_t alert_mask[MAX_ALERT_REG];
 
+/**
+ * @brief Inbound, outbound and MP0 outbound message registers
+ */
+#define SBRMI_MSG_REGS		8
+
+/**
+ * @brief Register groups of a SB-RMI snapshot, bit N of
+ * sbrmi_regs::valid is set when every register of group N was read
+ */
+typedef enum {
+	SBRMI_REGS_CONTROL = 0,	//!< SBRMI::Control
+	SBRMI_REGS_STATUS,	//!< SBRMI::Status
+	SBRMI_REGS_READSIZE,	//!< SBRMI::ReadSize
+	SBRMI_REGS_THREAD_EN,	//!< Thread enable status registers
+	SBRMI_REGS_ALERT_STATUS, //!< Alert status registers
+	SBRMI_REGS_ALERT_MASK,	//!< Alert mask registers
+	SBRMI_REGS_OUTBOUND,	//!< Outbound message registers
+	SBRMI_REGS_INBOUND,	//!< Inbound message registers
+	SBRMI_REGS_SW_INTERRUPT, //!< SBRMI::SoftwareInterrupt
+	SBRMI_REGS_THREAD_NUM,	//!< Thread number registers
+	SBRMI_REGS_THREAD_CS,	//!< SBRMI::Thread128CS
+	SBRMI_REGS_RAS_STATUS,	//!< SBRMI::RASStatus
+	SBRMI_REGS_MP0,		//!< MP0 outbound message registers
+	SBRMI_REGS_GROUPS	//!< Number of register groups
+} sbrmi_regs_group;
+
+/**
+ * @brief Snapshot of the SB-RMI registers.
+ * The thread enable, alert status and alert mask arrays hold
+ * thread_en_count and alert_count registers, in the order of the
+ * register tables of the revision. Fields of a group missing from
+ * valid are zero.
+ */
+struct sbrmi_regs {
+	uint32_t valid;			//!< Read groups, BIT(::sbrmi_regs_group)
+	uint8_t revision;		//!< SBRMI::Revision
+	uint8_t control;		//!< SBRMI::Control
+	uint8_t status;			//!< SBRMI::Status
+	uint8_t readsize;		//!< SBRMI::ReadSize
+	bool dense;			//!< Fam 1Ah Mod 10h-1Fh register layout
+	uint8_t thread_en_count;	//!< Valid thread_en entries
+	uint8_t thread_en[MAX_THREAD_REG_V21_DENSE]; //!< Thread enable status
+	uint8_t alert_count;		//!< Valid alert_status/mask entries
+	uint8_t alert_status[MAX_ALERT_REG_V21_DENSE]; //!< Alert status
+	uint8_t alert_mask[MAX_ALERT_REG_V21_DENSE]; //!< Alert mask
+	uint8_t outbound_msg[SBRMI_MSG_REGS];	//!< Outbound message
+	uint8_t inbound_msg[SBRMI_MSG_REGS];	//!< Inbound message
+	uint8_t sw_interrupt;		//!< SBRMI::SoftwareInterrupt
+	uint8_t thread_number;		//!< SBRMI::ThreadNumber, rev 0x10
+	uint8_t thread_number_low;	//!< SBRMI::ThreadNumberLow
+	uint8_t thread_number_high;	//!< SBRMI::ThreadNumberHigh
+	uint8_t thread_cs;		//!< SBRMI::Thread128CS[0]
+	uint8_t ras_status;		//!< SBRMI::RASStatus
+	uint8_t mp0_msg[SBRMI_MSG_REGS];	//!< MP0 outbound message
+};
+
+/**
+ * @brief 64 bit words of a thread mask, enough for 384 threads
+ */
+#define APML_THREAD_MASK_WORDS	6
+
+/**
+ * @brief Packed per thread bitmap, bit N is thread N of the socket
+ */
+struct apml_thread_mask {
+	uint64_t bits[APML_THREAD_MASK_WORDS];	//!< Thread bits
+	uint16_t nbits;		//!< Threads covered by the register layout
+};
+
+/**
+ * @brief Thread counts of a socket
+ */
+struct sbrmi_thread_summary {
+	uint16_t online;		//!< Enabled threads
+	uint16_t alerts_pending;	//!< Threads with an alert status set
+	uint16_t alerts_unmasked;	//!< Pending alerts not masked
+	bool smt;			//!< More than one thread per core
+};
+
+/**
+ * @brief Iterate over the set threads of a struct apml_thread_mask
+ */
+#define apml_for_each_thread(thread, mask)				\
+	for ((thread) = apml_thread_mask_next((mask), -1); (thread) >= 0; \
+	     (thread) = apml_thread_mask_next((mask), (thread)))
+
 /*****************************************************************************/
 /** @defgroup SB-RMIRegisterAccess SB-RMI Register Read Byte Protocol
  *  The SB-RMI registers can be read or written from the SMBus interface using
@@ -390,4 +478,135 @@ oob_status_t esmi_get_threads_per_socket(uint8_t soc_num,
 /** @} */  // end of SB-RMI Register access
 /*****************************************************************************/
 
+/** @defgroup SB-RMIRegisterSnapshot SB-RMI register snapshot
+ *  Below function reads the SB-RMI register file in one pass.
+ *  @{
+ */
+
+/**
+ *  @brief Read all SB-RMI registers
+ *
+ *  @details This function reads SBRMI::Revision, selects the register
+ *  layout of the revision and reads every other register once in a
+ *  batch through one device handle, see sbrmi_xfer_msgs_partial().
+ *  Transfers are only paced when the bus reports busy. A register that
+ *  fails to read, not every revision implements all of them, is skipped
+ *  and its group is left out of sbrmi_regs::valid.
+ *  Supported platforms: \ref Fam-19h_Mod-00h-0Fh, \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] regs register snapshot.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call, check
+ *  sbrmi_regs::valid for the groups read.
+ *
+ *  @retval Non-zero is returned upon failure.
+ */
+oob_status_t sbrmi_read_all(uint8_t soc_num, struct sbrmi_regs *regs);
+
+/**
+ *  @brief Pack the thread registers of a snapshot into thread masks
+ *
+ *  @details The thread enable registers hold threads 8 * N to 8 * N + 7
+ *  of register N. The alert registers follow the layout of
+ *  SBRMI::AlertStatus, see the register summary of apml_tool.
+ *
+ *  @param[in] regs register snapshot read by sbrmi_read_all().
+ *
+ *  @param[out] enabled enabled threads, may be NULL.
+ *
+ *  @param[out] alert threads with an alert status set, may be NULL.
+ *
+ *  @param[out] alert_mask threads with the alert masked, may be NULL.
+ *
+ */
+void sbrmi_regs_thread_masks(const struct sbrmi_regs *regs,
+			     struct apml_thread_mask *enabled,
+			     struct apml_thread_mask *alert,
+			     struct apml_thread_mask *alert_mask);
+
+/**
+ *  @brief Read the thread masks of a socket
+ *
+ *  @details This function reads only the thread enable, alert status
+ *  or alert mask registers of the requested masks, in one batch, and
+ *  packs them with sbrmi_regs_thread_masks(). The register layout is
+ *  taken from the socket inventory once the library is initialized. It
+ *  fails if a register of a requested mask could not be read.
+ *  Supported platforms: \ref Fam-19h_Mod-00h-0Fh, \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] enabled enabled threads, may be NULL.
+ *
+ *  @param[out] alert threads with an alert status set, may be NULL.
+ *
+ *  @param[out] alert_mask threads with the alert masked, may be NULL.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *
+ *  @retval Non-zero is returned upon failure.
+ */
+oob_status_t sbrmi_get_thread_masks(uint8_t soc_num,
+				    struct apml_thread_mask *enabled,
+				    struct apml_thread_mask *alert,
+				    struct apml_thread_mask *alert_mask);
+
+/**
+ *  @brief Get the thread counts of a socket
+ *
+ *  @details The counts are popcounts of the thread masks, SMT is read
+ *  from the threads per core.
+ *  Supported platforms: \ref Fam-19h_Mod-00h-0Fh, \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] summary thread counts.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *
+ *  @retval Non-zero is returned upon failure.
+ */
+oob_status_t sbrmi_get_thread_summary(uint8_t soc_num,
+				      struct sbrmi_thread_summary *summary);
+
+/**
+ *  @brief Number of set threads in a mask
+ *
+ *  @param[in] mask thread mask.
+ *
+ *  @retval number of set threads.
+ */
+uint32_t apml_thread_mask_count(const struct apml_thread_mask *mask);
+
+/**
+ *  @brief Test a thread of a mask
+ *
+ *  @param[in] mask thread mask.
+ *
+ *  @param[in] thread thread number.
+ *
+ *  @retval true if the thread is set.
+ */
+bool apml_thread_mask_test(const struct apml_thread_mask *mask,
+			   uint32_t thread);
+
+/**
+ *  @brief Next set thread of a mask
+ *
+ *  @param[in] mask thread mask.
+ *
+ *  @param[in] thread previous thread, -1 to start.
+ *
+ *  @retval next set thread after @p thread, -1 if none.
+ */
+int apml_thread_mask_next(const struct apml_thread_mask *mask, int thread);
+
+/** @} */  // end of SB-RMIRegisterSnapshot
+/*****************************************************************************/
+
 #endif  // INCLUDE_APML_RMI_H_
@@ -41,6 +41,8 @@
 #ifndef INCLUDE_APML_TSI_H_
 #define INCLUDE_APML_TSI_H_
 
+#include <stdbool.h>
+
 #include "apml_err.h"
 
 /** \file esmi_tsi.h
@@ -99,6 +101,50 @@ typedef enum {
 	ALERTMASK_MASK = 0x80
 } sbtsi_config_write;
 
+/**
+ * @brief Snapshot of the SB-TSI registers.
+ * Raw register bytes followed by the values decoded from them.
+ * The HBM fields are valid on \ref Fam-19h_Mod-90h-9Fh only.
+ */
+struct sbtsi_regs {
+	uint8_t cpu_temp_int;		//!< SBTSI::CpuTempInt
+	uint8_t cpu_temp_dec;		//!< SBTSI::CpuTempDec
+	uint8_t status;			//!< SBTSI::Status
+	uint8_t config;			//!< SBTSI::Config
+	uint8_t update_rate;		//!< SBTSI::UpdateRate
+	uint8_t hi_temp_int;		//!< SBTSI::HiTempInt
+	uint8_t hi_temp_dec;		//!< SBTSI::HiTempDec
+	uint8_t lo_temp_int;		//!< SBTSI::LoTempInt
+	uint8_t lo_temp_dec;		//!< SBTSI::LoTempDec
+	uint8_t temp_off_int;		//!< SBTSI::CpuTempOffInt
+	uint8_t temp_off_dec;		//!< SBTSI::CpuTempOffDec
+	uint8_t timeout_config;		//!< SBTSI::TimeoutConfig
+	uint8_t alert_threshold;	//!< SBTSI::AlertThreshold
+	uint8_t alert_config;		//!< SBTSI::AlertConfig
+	uint8_t manuf_id;		//!< SBTSI::ManufId
+	uint8_t revision;		//!< SBTSI::Revision
+	uint8_t hbm_hi_temp_int;	//!< HBM high threshold integer
+	uint8_t hbm_hi_temp_dec;	//!< HBM high threshold decimal
+	uint8_t hbm_lo_temp_int;	//!< HBM low threshold integer
+	uint8_t hbm_lo_temp_dec;	//!< HBM low threshold decimal
+	uint8_t hbm_max_temp_int;	//!< Max HBM temperature integer
+	uint8_t hbm_max_temp_dec;	//!< Max HBM temperature decimal
+	uint8_t hbm_temp_int;		//!< HBM temperature integer
+	uint8_t hbm_temp_dec;		//!< HBM temperature decimal
+	bool hbm_valid;			//!< HBM registers are implemented
+	float cpu_temp;			//!< CPU temperature in °C
+	float hi_temp_thr;		//!< High temperature threshold in °C
+	float lo_temp_thr;		//!< Low temperature threshold in °C
+	float temp_offset;		//!< CPU temperature offset in °C
+	float update_rate_hz;		//!< Update rate in Hz, 0 if invalid
+	uint8_t alert_samples;		//!< Alert threshold in samples
+	float hbm_hi_temp_thr;		//!< HBM high threshold in °C
+	float hbm_lo_temp_thr;		//!< HBM low threshold in °C
+	float hbm_max_temp;		//!< Max HBM temperature in °C
+	float hbm_temp;			//!< HBM temperature in °C
+	uint8_t hbm_alert_samples;	//!< HBM alert threshold in samples
+};
+
 /*****************************************************************************/
 /** @defgroup SB-TSIRegisterAccess SBTSI Register Read Byte Protocol
  *  Below functions provide interface to read one byte from the SB-TSI register
@@ -415,10 +461,38 @@ oob_status_t read_sbtsi_manufid(uint8_t soc_num, uint8_t *man_id);
 oob_status_t read_sbtsi_revision(uint8_t soc_num, uint8_t *rivision);
 
 /* Extra API's for bit parsing */
+/**
+ *  @brief Read an integer/decimal temperature register pair
+ *  Reading the first register latches the second one, so the pair is
+ *  read back to back without delay. The first register is read again
+ *  and the pair is read again if it changed in between.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[in] first register read first.
+ *
+ *  @param[in] second register read second.
+ *
+ *  @param[out] first_val value of the first register.
+ *
+ *  @param[out] second_val value of the second register.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval ::OOB_TRY_AGAIN is returned if the pair kept changing.
+ *
+ *  @retval Non-zero is returned upon failure.
+ */
+oob_status_t sbtsi_read_temp_regs(uint8_t soc_num, uint8_t first,
+				  uint8_t second, uint8_t *first_val,
+				  uint8_t *second_val);
+
 /**
  *  @brief CPU temperature value
  *  The CPU temperature is calculated by adding SBTSI::CpuTempInt
  *  and SBTSI::CpuTempDec combine to return the CPU temperature.
+ *  The value is read from hwmon when the backend is open.
+ *  SBTSI::Config[ReadOrder] is cached per socket and refreshed by
+ *  sbtsi_set_configwr() or when the read is found inconsistent.
  *  Supported platforms: \ref Fam-19h_Mod-00h-0Fh, \ref Fam-19h_Mod-10h-1Fh,
  *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
  *
@@ -703,4 +777,30 @@ oob_status_t sbtsi_set_alert_config(uint8_t soc_num,
 /** @} */  // end of SB-TSI Register access
 /*****************************************************************************/
 
+/** @defgroup SB-TSIRegisterSnapshot SBTSI register snapshot
+ *  Below function reads every SB-TSI register in one pass.
+ *  @{
+ */
+
+/**
+ *  @brief Read all SB-TSI registers
+ *  Every register is read exactly once through one open device handle,
+ *  the temperature register pairs back to back in latch order. The
+ *  derived values are decoded from the same raw bytes.
+ *  Supported platforms: \ref Fam-19h_Mod-00h-0Fh, \ref Fam-19h_Mod-10h-1Fh,
+ *  \ref Fam-19h_Mod-90h-9Fh and \ref Fam-1Ah_Mod-00h-0Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] regs register snapshot.
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *
+ *  @retval Non-zero is returned upon failure.
+ */
+oob_status_t sbtsi_read_all(uint8_t soc_num, struct sbtsi_regs *regs);
+
+/** @} */  // end of SB-TSIRegisterSnapshot
+/*****************************************************************************/
+
 #endif  // INCLUDE_APML_TSI_H_
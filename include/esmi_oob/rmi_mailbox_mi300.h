@@ -372,6 +372,26 @@ oob_status_t get_xcc_idle_residency(uint8_t soc_num, uint32_t *gfx_cores_idle_re
 oob_status_t get_energy_accum_with_timestamp(uint8_t soc_num, uint64_t *energy,
 					     uint64_t *time_stamp);
 
+/**
+ *  @brief Read the raw energy accumulator with time stamp
+ *
+ *  @details This function reads the 64 bit energy accumulator and the
+ *  56 bit time stamp without scaling, so no precision is lost.
+ *  Supported platforms: \ref Fam-19h_Mod-90h-9Fh.
+ *
+ *  @param[in] soc_num Socket index.
+ *
+ *  @param[out] energy accumulator (units: 2^-16 J).
+ *
+ *  @param[out] time_stamp time stamp (units: 10 ns).
+ *
+ *  @retval ::OOB_SUCCESS is returned upon successful call.
+ *  @retval Non-zero is returned upon failure.
+ *
+ */
+oob_status_t get_energy_accum_raw(uint8_t soc_num, uint64_t *energy,
+				  uint64_t *time_stamp);
+
 /**
  *  @brief Read PM alarm status based on enumeration type #alarms_type
  *
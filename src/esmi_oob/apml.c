@@ -47,10 +47,14 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
 #include <sys/ioctl.h>
 
 #include <esmi_oob/apml.h>
+#include <esmi_oob/apml_cap.h>
 #include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_enum.h>
+#include <esmi_oob/apml_recovery.h>
 
 #define SBRMI_CTRL	0x1
 #define SBRMI_STATUS	0x2
@@ -63,6 +67,12 @@
 #define WRITE_MODE		0
 /* DEVICE FILE LENGTH */
 #define DEV_SIZE		14
+/* Retries of a busy transfer in a batch */
+#define XFER_MAX_RETRY		8
+/* Max delay between the transfers of a batch */
+#define XFER_MAX_PACE_US	20000
+/* Register read/write command */
+#define REG_XFER_CMD		0x1002
 
 /* Static address inforamtion is from the PPR */
 const uint16_t sbrmi_addr[MAX_DEV_COUNT] = {0x3c, 0x38, 0x3e, 0x3f,
@@ -70,37 +80,63 @@ const uint16_t sbrmi_addr[MAX_DEV_COUNT] = {0x3c, 0x38, 0x3e, 0x3f,
 const uint16_t sbtsi_addr[MAX_DEV_COUNT] = {0x4c, 0x48, 0x4e, 0x4f,
 					    0x44, 0x45, 0x46, 0x47};	//!< SBTSI Addresses
 
-oob_status_t sbrmi_xfer_msg(uint8_t soc_num, struct apml_message *msg)
+/*
+ * Open the device node of the given client for a socket, through the
+ * enumerated socket map when available, the fixed address table and
+ * the index based node otherwise.
+ */
+static int open_apml_dev(uint8_t soc_num, uint8_t client)
 {
-	int fd = 0, ret = 0;
+	struct apml_node node;
 	char dev_file[DEV_SIZE] = "";
-	uint16_t soc_addr = 0;
+	const uint16_t *addr;
+	const char *module;
+	oob_status_t ret;
+	int fd;
 
-	if (soc_num >= ARRAY_SIZE(sbrmi_addr))
-		return OOB_FILE_ERROR;
-	else
-		soc_addr = sbrmi_addr[soc_num];
+	ret = apml_get_node(soc_num, client, &node);
+	if (ret != OOB_NOT_INITIALIZED)
+		return ret ? -1 : open(node.path, O_RDWR);
+
+	if (soc_num >= MAX_DEV_COUNT)
+		return -1;
+	module = client == DEV_SBRMI ? SBRMI : SBTSI;
+	addr = client == DEV_SBRMI ? sbrmi_addr : sbtsi_addr;
 
-	snprintf(dev_file, DEV_SIZE, "%s%s-%hx", DEV, SBRMI, soc_addr);
+	snprintf(dev_file, DEV_SIZE, "%s%s-%hx", DEV, module, addr[soc_num]);
 	fd = open(dev_file, O_RDWR);
 	if (fd < 0) {
-		snprintf(dev_file, DEV_SIZE, "%s%s%d", DEV, SBRMI, soc_num);
+		snprintf(dev_file, DEV_SIZE, "%s%s%d", DEV, module, soc_num);
 		fd = open(dev_file, O_RDWR);
-		if (fd < 0)
-			return OOB_FILE_ERROR;
 	}
 
+	return fd;
+}
+
+/* Firmware error of a message failed with EPROTOTYPE */
+static int fw_error(const struct apml_message *msg)
+{
+	if (msg->cmd == APML_CPUID || msg->cmd == APML_MCA_MSR)
+		return OOB_CPUID_MSR_ERR_BASE + msg->fw_ret_code;
+
+	return OOB_MAILBOX_ERR_BASE + msg->fw_ret_code;
+}
+
+oob_status_t sbrmi_xfer_msg(uint8_t soc_num, struct apml_message *msg)
+{
+	int fd = 0, ret = 0;
+
+	fd = open_apml_dev(soc_num, DEV_SBRMI);
+	if (fd < 0)
+		return OOB_FILE_ERROR;
+
 	if (ioctl(fd, SBRMI_IOCTL_CMD, msg) < 0)
 		ret = errno;
 
 	close(fd);
 
-	if (ret == EPROTOTYPE) {
-		if (msg->cmd == APML_CPUID || msg->cmd == APML_MCA_MSR)
-			ret = OOB_CPUID_MSR_ERR_BASE + msg->fw_ret_code;
-		else
-			ret = OOB_MAILBOX_ERR_BASE + msg->fw_ret_code;
-	}
+	if (ret == EPROTOTYPE)
+		ret = fw_error(msg);
 
 	return errno_to_oob_status(ret);
 }
@@ -108,22 +144,10 @@ oob_status_t sbrmi_xfer_msg(uint8_t soc_num, struct apml_message *msg)
 oob_status_t sbtsi_xfer_msg(uint8_t soc_num, struct apml_message *msg)
 {
 	int fd = 0, ret = 0;
-	char dev_file[DEV_SIZE] = "";
-	uint16_t soc_addr = 0;
 
-	if (soc_num >= ARRAY_SIZE(sbtsi_addr))
+	fd = open_apml_dev(soc_num, DEV_SBTSI);
+	if (fd < 0)
 		return OOB_FILE_ERROR;
-	else
-		soc_addr = sbtsi_addr[soc_num];
-
-	snprintf(dev_file, DEV_SIZE, "%s%s-%hx", DEV, SBTSI, soc_addr);
-	fd = open(dev_file, O_RDWR);
-	if (fd < 0) {
-		snprintf(dev_file, DEV_SIZE, "%s%s%d", DEV, SBTSI, soc_num);
-		fd = open(dev_file, O_RDWR);
-		if (fd < 0)
-			return OOB_FILE_ERROR;
-	}
 
 	if (ioctl(fd, SBRMI_IOCTL_CMD, msg) < 0)
 		ret = errno;
@@ -133,6 +157,129 @@ oob_status_t sbtsi_xfer_msg(uint8_t soc_num, struct apml_message *msg)
 	return errno_to_oob_status(ret);
 }
 
+/* Inter transfer delay per client and socket, learned from the bus */
+static uint32_t pace_us[DEV_SBTSI + 1][APML_MAX_SOCKETS];
+
+static int64_t elapsed_us(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000000LL +
+	       (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/*
+ * A busy bus never started the transfer. A timed out or failed
+ * transfer may have reached the firmware, only register accesses are
+ * safe to repeat then, a mailbox command may not be idempotent.
+ */
+static bool retryable(const struct apml_message *msg, int err)
+{
+	if (err == EAGAIN || err == EBUSY)
+		return true;
+
+	return (err == ETIMEDOUT || err == EIO) && msg->cmd == REG_XFER_CMD;
+}
+
+/*
+ * Issue a batch of messages through one device handle. No delay is
+ * inserted while the bus keeps up. A transfer failing with a busy
+ * error, or a register access failing with a timeout or I/O error, is
+ * retried after a delay that starts at the measured
+ * transfer time and doubles on every failure. The delay is kept for
+ * the socket and halved after every successful transfer. A mailbox
+ * reporting additional error data completes the message, the caller
+ * finds the firmware code in the message.
+ */
+static oob_status_t xfer_msgs(uint8_t soc_num, uint8_t client,
+			      struct apml_message *msgs, uint32_t count,
+			      uint32_t *done)
+{
+	uint32_t i, retry = 0, pace, *state = NULL;
+	struct timespec start;
+	int64_t avg_us = 0;
+	int fd = 0, ret = 0;
+
+	if (done)
+		*done = 0;
+	if (!msgs)
+		return OOB_ARG_PTR_NULL;
+
+	fd = open_apml_dev(soc_num, client);
+	if (fd < 0)
+		return OOB_FILE_ERROR;
+
+	if (soc_num < APML_MAX_SOCKETS)
+		state = &pace_us[client][soc_num];
+	pace = state ? __atomic_load_n(state, __ATOMIC_RELAXED) : 0;
+
+	for (i = 0; i < count; ) {
+		if (pace)
+			usleep(pace);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if (ioctl(fd, SBRMI_IOCTL_CMD, &msgs[i]) < 0) {
+			ret = errno;
+			if (ret == EPROTOTYPE && client == DEV_SBRMI) {
+				ret = fw_error(&msgs[i]);
+				if (ret != OOB_MAILBOX_ADD_ERR_DATA)
+					break;
+				ret = 0;
+				retry = 0;
+				i++;
+				continue;
+			}
+			if (!retryable(&msgs[i], ret) ||
+			    ++retry > XFER_MAX_RETRY)
+				break;
+			/* Back off from the observed transfer time */
+			if (!pace)
+				pace = avg_us ? avg_us : elapsed_us(&start);
+			pace = pace ? pace * 2 : 1;
+			if (pace > XFER_MAX_PACE_US)
+				pace = XFER_MAX_PACE_US;
+			ret = 0;
+			continue;
+		}
+		/* Running average of the transfer time */
+		avg_us = (avg_us * i + elapsed_us(&start)) / (i + 1);
+		pace /= 2;
+		retry = 0;
+		i++;
+	}
+
+	close(fd);
+	if (state)
+		__atomic_store_n(state, pace, __ATOMIC_RELAXED);
+	if (done)
+		*done = i;
+
+	return errno_to_oob_status(ret);
+}
+
+oob_status_t sbrmi_xfer_msgs(uint8_t soc_num, struct apml_message *msgs,
+			     uint32_t count)
+{
+	return xfer_msgs(soc_num, DEV_SBRMI, msgs, count, NULL);
+}
+
+oob_status_t sbrmi_xfer_msgs_partial(uint8_t soc_num,
+				     struct apml_message *msgs,
+				     uint32_t count, uint32_t *done)
+{
+	if (!done)
+		return OOB_ARG_PTR_NULL;
+
+	return xfer_msgs(soc_num, DEV_SBRMI, msgs, count, done);
+}
+
+oob_status_t sbtsi_xfer_msgs(uint8_t soc_num, struct apml_message *msgs,
+			     uint32_t count)
+{
+	return xfer_msgs(soc_num, DEV_SBTSI, msgs, count, NULL);
+}
+
 oob_status_t esmi_oob_rmi_read_byte(uint8_t soc_num, uint16_t reg_offset,
 				    uint8_t *buffer)
 {
@@ -257,13 +404,21 @@ oob_status_t esmi_oob_write_mailbox(uint8_t soc_num,
                                     uint32_t cmd, uint32_t data)
 {
 	struct apml_message msg = {0};
+	oob_status_t ret;
+
+	/* Fail fast on commands known to be unsupported by the firmware */
+	if (apml_cap_get(soc_num, cmd) == APML_CAP_UNSUPPORTED)
+		return OOB_MAILBOX_CMD_UNKNOWN;
 
 	msg.cmd = cmd;
 	msg.data_in.mb_in[0] = data;
 
 	msg.data_in.mb_in[1] = (uint32_t)WRITE_MODE << 24;
 
-	return sbrmi_xfer_msg(soc_num, &msg);
+	ret = sbrmi_xfer_msg(soc_num, &msg);
+	apml_cap_record(soc_num, cmd, ret);
+
+	return ret;
 }
 
 /*
@@ -279,11 +434,16 @@ oob_status_t esmi_oob_read_mailbox(uint8_t soc_num,
 	if (!buffer)
 		return OOB_ARG_PTR_NULL;
 
+	/* Fail fast on commands known to be unsupported by the firmware */
+	if (apml_cap_get(soc_num, cmd) == APML_CAP_UNSUPPORTED)
+		return OOB_MAILBOX_CMD_UNKNOWN;
+
 	msg.cmd = cmd;
 	msg.data_in.mb_in[0] = input;
 
 	msg.data_in.mb_in[1] = (uint32_t)READ_MODE << 24;
 	ret = sbrmi_xfer_msg(soc_num, &msg);
+	apml_cap_record(soc_num, cmd, ret);
 	if (ret && ret != OOB_MAILBOX_ADD_ERR_DATA)
 		return ret;
 
@@ -293,19 +453,19 @@ oob_status_t esmi_oob_read_mailbox(uint8_t soc_num,
 
 oob_status_t validate_sbtsi_module(uint8_t soc_num, bool *is_sbtsi)
 {
-	char dev_file[DEV_SIZE] = "";
+	uint32_t tsi_mask = 0;
+	oob_status_t ret;
 
 	*is_sbtsi = false;
-	if (soc_num >= ARRAY_SIZE(sbtsi_addr))
+	if (soc_num >= APML_MAX_SOCKETS)
 		return OOB_FILE_ERROR;
 
 	/* check if the sbtsi module is present for the given socket */
-	snprintf(dev_file, DEV_SIZE, "%s%s-%hx", DEV, SBTSI, sbtsi_addr[soc_num]);
-        if (access(dev_file, F_OK) != 0) {
-                snprintf(dev_file, DEV_SIZE, "%s%s%d", DEV, SBTSI, soc_num);
-		if (access(dev_file, F_OK) != 0)
-			return OOB_FILE_ERROR;
-        }
+	ret = apml_present_sockets(NULL, &tsi_mask);
+	if (ret)
+		return ret;
+	if (!(tsi_mask & BIT(soc_num)))
+		return OOB_FILE_ERROR;
 
 	*is_sbtsi = true;
 	return OOB_SUCCESS;
@@ -313,19 +473,19 @@ oob_status_t validate_sbtsi_module(uint8_t soc_num, bool *is_sbtsi)
 
 oob_status_t validate_sbrmi_module(uint8_t soc_num, bool *is_sbrmi)
 {
-	char dev_file[DEV_SIZE] = "";
+	uint32_t rmi_mask = 0;
+	oob_status_t ret;
 
 	*is_sbrmi = false;
-	if (soc_num >= ARRAY_SIZE(sbrmi_addr))
+	if (soc_num >= APML_MAX_SOCKETS)
 		return OOB_FILE_ERROR;
 
 	/* check if the sbrmi module is present for the given socket*/
-	snprintf(dev_file, DEV_SIZE, "%s%s-%hx", DEV, SBRMI, sbrmi_addr[soc_num]);
-	if (access(dev_file, F_OK) != 0) {
-		snprintf(dev_file, DEV_SIZE, "%s%s%d", DEV, SBRMI, soc_num);
-		if (access(dev_file, F_OK) != 0)
-			return OOB_FILE_ERROR;
-	}
+	ret = apml_present_sockets(&rmi_mask, NULL);
+	if (ret)
+		return ret;
+	if (!(rmi_mask & BIT(soc_num)))
+		return OOB_FILE_ERROR;
 
 	*is_sbrmi = true;
 	return OOB_SUCCESS;
@@ -334,16 +494,22 @@ oob_status_t validate_sbrmi_module(uint8_t soc_num, bool *is_sbrmi)
 oob_status_t validate_apml_dependency(uint8_t soc_num, bool *is_sbrmi,
 				      bool *is_sbtsi)
 {
-	char dev_file[DEV_SIZE] = "";
-	uint16_t addr = 0;
-	oob_status_t ret = OOB_SUCCESS;
+	uint32_t rmi_mask = 0, tsi_mask = 0;
+	oob_status_t ret;
 
-	/* validate sbrmi module */
-	ret = validate_sbrmi_module(soc_num, is_sbrmi);
-	/* validate sbtsi module */
-	ret = validate_sbtsi_module(soc_num, is_sbtsi);
+	*is_sbrmi = false;
+	*is_sbtsi = false;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_FILE_ERROR;
+
+	/* validate sbrmi and sbtsi modules with one presence map read */
+	ret = apml_present_sockets(&rmi_mask, &tsi_mask);
+	if (ret)
+		return ret;
+	*is_sbrmi = rmi_mask & BIT(soc_num);
+	*is_sbtsi = tsi_mask & BIT(soc_num);
 
 	if (!*is_sbrmi || !*is_sbtsi)
 		return OOB_FILE_ERROR;
-	return ret;
+	return OOB_SUCCESS;
 }
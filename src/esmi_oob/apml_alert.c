@@ -0,0 +1,203 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_alert.h>
+#include <esmi_oob/esmi_tsi.h>
+
+/* SBTSI::Status [4] high temperature alert, [3] low temperature alert */
+#define STATUS_HI_ALERT		(1 << 4)
+#define STATUS_LO_ALERT		(1 << 3)
+/* Room for several GPIO line events or one eventfd counter */
+#define SRC_BUF_SIZE		256
+
+/* Alert registration of a socket */
+struct alert_reg {
+	bool used;
+	int fd;
+	apml_alert_cb cb;
+	void *data;
+};
+
+static struct alert_reg regs[APML_MAX_SOCKETS];
+static uint64_t spurious;
+/* Alert events lost because SBTSI::Status could not be read */
+static uint64_t read_errors;
+static pthread_mutex_t alert_lock = PTHREAD_MUTEX_INITIALIZER;
+
+oob_status_t apml_alert_register(uint8_t soc_num, int fd, apml_alert_cb cb,
+				 void *data)
+{
+	if (!cb)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS || fd < 0)
+		return OOB_INVALID_INPUT;
+
+	pthread_mutex_lock(&alert_lock);
+	regs[soc_num].used = true;
+	regs[soc_num].fd = fd;
+	regs[soc_num].cb = cb;
+	regs[soc_num].data = data;
+	pthread_mutex_unlock(&alert_lock);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_alert_unregister(uint8_t soc_num)
+{
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	pthread_mutex_lock(&alert_lock);
+	if (regs[soc_num].used)
+		memset(&regs[soc_num], 0, sizeof(regs[soc_num]));
+	else
+		ret = OOB_NOT_FOUND;
+	pthread_mutex_unlock(&alert_lock);
+
+	return ret;
+}
+
+/* Confirm and decode the alert of a socket with one status read */
+static bool handle_socket(uint8_t soc_num, const struct alert_reg *reg)
+{
+	struct apml_alert_event event = {0};
+
+	if (read_sbtsi_status(soc_num, &event.status)) {
+		__atomic_add_fetch(&read_errors, 1, __ATOMIC_RELAXED);
+		return false;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &event.ts);
+	event.hi_alert = event.status & STATUS_HI_ALERT;
+	event.lo_alert = event.status & STATUS_LO_ALERT;
+	if (!event.hi_alert && !event.lo_alert) {
+		__atomic_add_fetch(&spurious, 1, __ATOMIC_RELAXED);
+		return false;
+	}
+	reg->cb(soc_num, &event, reg->data);
+
+	return true;
+}
+
+oob_status_t apml_alert_dispatch(int timeout_ms, uint32_t *handled)
+{
+	struct alert_reg snap[APML_MAX_SOCKETS];
+	struct pollfd pfd[APML_MAX_SOCKETS];
+	char buf[SRC_BUF_SIZE];
+	int nfds = 0, i, ret;
+	uint32_t count = 0;
+	uint8_t soc;
+
+	/* Callbacks run without the lock so they may unregister */
+	pthread_mutex_lock(&alert_lock);
+	memcpy(snap, regs, sizeof(snap));
+	pthread_mutex_unlock(&alert_lock);
+
+	/* One poll entry per distinct source */
+	for (soc = 0; soc < APML_MAX_SOCKETS; soc++) {
+		if (!snap[soc].used)
+			continue;
+		for (i = 0; i < nfds; i++)
+			if (pfd[i].fd == snap[soc].fd)
+				break;
+		if (i < nfds)
+			continue;
+		pfd[nfds].fd = snap[soc].fd;
+		pfd[nfds].events = POLLIN | POLLPRI;
+		pfd[nfds].revents = 0;
+		nfds++;
+	}
+	if (!nfds)
+		return OOB_NOT_INITIALIZED;
+
+	ret = poll(pfd, nfds, timeout_ms);
+	if (ret < 0)
+		return errno_to_oob_status(errno);
+	if (!ret)
+		return OOB_TRY_AGAIN;
+
+	for (i = 0; i < nfds; i++) {
+		if (!pfd[i].revents)
+			continue;
+		/* Consume the line events or the eventfd counter */
+		if (read(pfd[i].fd, buf, sizeof(buf)) < 0 &&
+		    errno != EAGAIN)
+			return errno_to_oob_status(errno);
+		for (soc = 0; soc < APML_MAX_SOCKETS; soc++)
+			if (snap[soc].used && snap[soc].fd == pfd[i].fd &&
+			    handle_socket(soc, &snap[soc]))
+				count++;
+	}
+	if (handled)
+		*handled = count;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_alert_spurious(uint64_t *count)
+{
+	if (!count)
+		return OOB_ARG_PTR_NULL;
+
+	*count = __atomic_load_n(&spurious, __ATOMIC_RELAXED);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_alert_errors(uint64_t *count)
+{
+	if (!count)
+		return OOB_ARG_PTR_NULL;
+
+	*count = __atomic_load_n(&read_errors, __ATOMIC_RELAXED);
+
+	return OOB_SUCCESS;
+}
@@ -0,0 +1,333 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_cap.h>
+#include <esmi_oob/apml_common.h>
+#include <esmi_oob/esmi_mailbox.h>
+#include <esmi_oob/rmi_mailbox_mi300.h>
+
+/* Capability cache file magic "APMC" and layout version */
+#define CAP_FILE_MAGIC		0x434d5041
+#define CAP_FILE_VERSION	1
+/* Max length of the cache file path */
+#define CAP_PATH_SIZE		256
+
+/* On disk layout of the capability cache file */
+struct cap_file {
+	uint32_t magic;
+	uint32_t version;
+	struct apml_cap_map map;
+};
+
+static struct apml_cap_map cap_map[APML_MAX_SOCKETS];
+
+/*
+ * Read only mailbox commands which are safe to issue with input 0 on
+ * any platform. Commands changing the platform state are never probed.
+ */
+static const uint8_t probe_cmds[] = {
+	READ_PACKAGE_POWER_CONSUMPTION, READ_PACKAGE_POWER_LIMIT,
+	READ_MAX_PACKAGE_POWER_LIMIT, READ_TDP, READ_MAX_cTDP, READ_MIN_cTDP,
+	READ_BIOS_BOOST_Fmax, READ_APML_BOOST_LIMIT, READ_DRAM_THROTTLE,
+	READ_PROCHOT_STATUS, READ_PROCHOT_RESIDENCY, READ_IOD_BIST,
+	READ_PACKAGE_CCLK_FREQ_LIMIT, READ_PACKAGE_C0_RESIDENCY,
+	READ_DDR_BANDWIDTH, GET_RTC, READ_PWR_CURRENT_ACTIVE_FREQ_LIMIT_SOCKET,
+	READ_PWR_SVI_TELEMETRY_ALL_RAILS, READ_SOCKET_FREQ_RANGE,
+	READ_CURRENT_DFPSTATE_FREQUENCY, READ_BMC_RAPL_UNITS,
+	READ_BMC_CPU_BASE_FREQUENCY, READ_UCODE_REVISION,
+	GET_BMC_RAS_OOB_CONFIG, GET_PSTATES, GET_CURR_XGMI_PSTATE,
+	GET_XGMI_PSTATES, GET_XCC_IDLE_RESIDENCY, GET_ENERGY_ACCUMULATOR,
+	GET_PSN, GET_ABS_MAX_MIN_GFX_FREQ, GET_ACT_GFX_FREQ_CAP_SELECTED,
+	GET_MAX_OP_TEMP, GET_SLOW_DOWN_TEMP, GET_MAX_MEM_BW_UTILIZATION,
+	GET_HBM_THROTTLE, GET_GFX_CLK_FREQ_LIMITS, GET_FCLK_FREQ_LIMITS,
+	GET_SOCKETS_IN_SYSTEM
+};
+
+apml_cap_state apml_cap_get(uint8_t soc_num, uint32_t cmd)
+{
+	uint64_t bit;
+	uint32_t word;
+
+	if (soc_num >= APML_MAX_SOCKETS || cmd >= APML_CAP_CMD_MAX)
+		return APML_CAP_UNKNOWN;
+
+	word = cmd / 64;
+	bit = (uint64_t)1 << (cmd % 64);
+	if (!(__atomic_load_n(&cap_map[soc_num].probed[word],
+			      __ATOMIC_ACQUIRE) & bit))
+		return APML_CAP_UNKNOWN;
+	if (__atomic_load_n(&cap_map[soc_num].supported[word],
+			    __ATOMIC_RELAXED) & bit)
+		return APML_CAP_SUPPORTED;
+
+	return APML_CAP_UNSUPPORTED;
+}
+
+void apml_cap_record(uint8_t soc_num, uint32_t cmd, oob_status_t status)
+{
+	uint64_t bit;
+	uint32_t word;
+
+	if (soc_num >= APML_MAX_SOCKETS || cmd >= APML_CAP_CMD_MAX)
+		return;
+
+	word = cmd / 64;
+	bit = (uint64_t)1 << (cmd % 64);
+	if (status == OOB_MAILBOX_CMD_UNKNOWN) {
+		__atomic_fetch_and(&cap_map[soc_num].supported[word], ~bit,
+				   __ATOMIC_RELAXED);
+	} else if (status == OOB_SUCCESS ||
+		   (status > OOB_MAILBOX_ERR_START &&
+		    status <= OOB_MAILBOX_ERR_END)) {
+		/* Any other firmware status means the command is known */
+		__atomic_fetch_or(&cap_map[soc_num].supported[word], bit,
+				  __ATOMIC_RELAXED);
+	} else {
+		/* Transport errors say nothing about the firmware */
+		return;
+	}
+	__atomic_fetch_or(&cap_map[soc_num].probed[word], bit,
+			  __ATOMIC_RELEASE);
+}
+
+/*
+ * Read the PPIN and SMU firmware version identifying the capability
+ * map. Platforms without the commands use 0 for the missing key.
+ */
+static oob_status_t read_cap_key(uint8_t soc_num, uint64_t *ppin,
+				 uint32_t *smu_fw_ver)
+{
+	oob_status_t ret;
+
+	*ppin = 0;
+	*smu_fw_ver = 0;
+	ret = read_ppin_fuse(soc_num, ppin);
+	if (ret && ret != OOB_MAILBOX_CMD_UNKNOWN)
+		return ret;
+	ret = read_smu_fw_ver(soc_num, smu_fw_ver);
+	if (ret && ret != OOB_MAILBOX_CMD_UNKNOWN)
+		return ret;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_cap_probe(uint8_t soc_num)
+{
+	uint64_t ppin;
+	uint32_t smu_fw_ver, buffer;
+	oob_status_t ret;
+	uint32_t i;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	apml_cap_reset(soc_num);
+	ret = read_cap_key(soc_num, &ppin, &smu_fw_ver);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < ARRAY_SIZE(probe_cmds); i++) {
+		/* mailbox read records the outcome in the map */
+		ret = esmi_oob_read_mailbox(soc_num, probe_cmds[i],
+					    DEFAULT_DATA, &buffer);
+		if (ret == OOB_SUCCESS || ret == OOB_MAILBOX_CMD_UNKNOWN ||
+		    (ret > OOB_MAILBOX_ERR_START &&
+		     ret <= OOB_MAILBOX_ERR_END))
+			continue;
+		return ret;
+	}
+	cap_map[soc_num].ppin = ppin;
+	cap_map[soc_num].smu_fw_ver = smu_fw_ver;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_cap_get_map(uint8_t soc_num, struct apml_cap_map *map)
+{
+	int i;
+
+	if (!map)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	map->ppin = cap_map[soc_num].ppin;
+	map->smu_fw_ver = cap_map[soc_num].smu_fw_ver;
+	for (i = 0; i < APML_CAP_WORDS; i++) {
+		map->probed[i] = __atomic_load_n(&cap_map[soc_num].probed[i],
+						 __ATOMIC_ACQUIRE);
+		map->supported[i] =
+			__atomic_load_n(&cap_map[soc_num].supported[i],
+					__ATOMIC_RELAXED);
+	}
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_cap_set_map(uint8_t soc_num, const struct apml_cap_map *map)
+{
+	int i;
+
+	if (!map)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	apml_cap_reset(soc_num);
+	cap_map[soc_num].ppin = map->ppin;
+	cap_map[soc_num].smu_fw_ver = map->smu_fw_ver;
+	for (i = 0; i < APML_CAP_WORDS; i++) {
+		__atomic_store_n(&cap_map[soc_num].supported[i],
+				 map->supported[i] & map->probed[i],
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&cap_map[soc_num].probed[i], map->probed[i],
+				 __ATOMIC_RELEASE);
+	}
+
+	return OOB_SUCCESS;
+}
+
+void apml_cap_reset(uint8_t soc_num)
+{
+	int i;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return;
+
+	for (i = 0; i < APML_CAP_WORDS; i++) {
+		__atomic_store_n(&cap_map[soc_num].probed[i], 0,
+				 __ATOMIC_RELEASE);
+		__atomic_store_n(&cap_map[soc_num].supported[i], 0,
+				 __ATOMIC_RELAXED);
+	}
+	cap_map[soc_num].ppin = 0;
+	cap_map[soc_num].smu_fw_ver = 0;
+}
+
+static const char *cap_file_path(uint8_t soc_num, const char *path,
+				 char *buf)
+{
+	if (path)
+		return path;
+
+	mkdir(APML_CACHE_DIR, 0755);
+	snprintf(buf, CAP_PATH_SIZE, "%s/caps-%d", APML_CACHE_DIR, soc_num);
+
+	return buf;
+}
+
+oob_status_t apml_cap_save(uint8_t soc_num, const char *path)
+{
+	char def_path[CAP_PATH_SIZE];
+	char tmp_path[CAP_PATH_SIZE];
+	struct cap_file file = {0};
+	oob_status_t ret;
+	ssize_t len;
+	int fd;
+
+	ret = apml_cap_get_map(soc_num, &file.map);
+	if (ret)
+		return ret;
+	file.magic = CAP_FILE_MAGIC;
+	file.version = CAP_FILE_VERSION;
+
+	path = cap_file_path(soc_num, path, def_path);
+	if ((size_t)snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path)
+	    >= sizeof(tmp_path))
+		return OOB_INVALID_INPUT;
+
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return errno_to_oob_status(errno);
+	len = write(fd, &file, sizeof(file));
+	close(fd);
+	if (len != sizeof(file)) {
+		unlink(tmp_path);
+		return OOB_FILE_ERROR;
+	}
+	if (rename(tmp_path, path) < 0) {
+		ret = errno_to_oob_status(errno);
+		unlink(tmp_path);
+	}
+
+	return ret;
+}
+
+oob_status_t apml_cap_load(uint8_t soc_num, const char *path)
+{
+	char def_path[CAP_PATH_SIZE];
+	struct cap_file file;
+	uint64_t ppin;
+	uint32_t smu_fw_ver;
+	oob_status_t ret;
+	ssize_t len;
+	int fd;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	path = cap_file_path(soc_num, path, def_path);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return errno_to_oob_status(errno);
+	len = read(fd, &file, sizeof(file));
+	close(fd);
+	if (len != sizeof(file) || file.magic != CAP_FILE_MAGIC ||
+	    file.version != CAP_FILE_VERSION)
+		return OOB_UNEXPECTED_SIZE;
+
+	/* The map is only valid for the firmware it was built on */
+	ret = read_cap_key(soc_num, &ppin, &smu_fw_ver);
+	if (ret)
+		return ret;
+	if (ppin != file.map.ppin || smu_fw_ver != file.map.smu_fw_ver)
+		return OOB_TRY_AGAIN;
+
+	return apml_cap_set_map(soc_num, &file.map);
+}
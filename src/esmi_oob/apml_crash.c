@@ -0,0 +1,507 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_crash.h>
+#include <esmi_oob/apml_ras.h>
+#include <esmi_oob/esmi_mailbox.h>
+
+/* Nano seconds in a second */
+#define NSEC_PER_SEC		1000000000LL
+/* Runtime errors kept per socket */
+#define RT_QUEUE_DEPTH		256
+/* Sections of a socket */
+#define SOC_PARTS		4
+/* Section data alignment */
+#define SECTION_ALIGN(len)	(((len) + 7) & ~7U)
+
+/* Section collected for a socket */
+struct crash_part {
+	uint16_t type;
+	oob_status_t ret;
+	void *data;
+	uint32_t len;
+};
+
+/* Collection of a socket */
+struct crash_soc {
+	pthread_t tid;
+	bool started;
+	uint8_t soc_num;
+	const struct timespec *deadline;
+	struct apml_crash_soc_info info;
+	struct crash_part part[SOC_PARTS];
+};
+
+/* CRC32 (IEEE 802.3) a nibble at a time */
+static const uint32_t crc_nibble[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+	0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+	0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static uint32_t crc32(uint32_t crc, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ crc_nibble[crc & 0xF];
+		crc = (crc >> 4) ^ crc_nibble[crc & 0xF];
+	}
+
+	return ~crc;
+}
+
+/* CRC32 of a record computed with the crc field zero */
+static uint32_t record_crc(const struct apml_crash_hdr *rec)
+{
+	const uint8_t *p = (const uint8_t *)rec;
+	size_t off = offsetof(struct apml_crash_hdr, crc);
+	uint32_t zero = 0, crc;
+
+	crc = crc32(0, p, off);
+	crc = crc32(crc, &zero, sizeof(zero));
+
+	return crc32(crc, p + off + sizeof(zero),
+		     rec->len - off - sizeof(zero));
+}
+
+static int64_t ts_diff_us(const struct timespec *end,
+			  const struct timespec *start)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000LL +
+	       (end->tv_nsec - start->tv_nsec) / 1000;
+}
+
+/* Collect one section of a socket */
+typedef oob_status_t (*collect_fn)(struct crash_soc *cs,
+				   struct crash_part *part);
+
+static oob_status_t collect_mca(struct crash_soc *cs, struct crash_part *part)
+{
+	uint16_t bytes_per_mca, mca_banks;
+	uint32_t len;
+	oob_status_t ret;
+
+	ret = read_bmc_ras_mca_validity_check(cs->soc_num, &bytes_per_mca,
+					      &mca_banks);
+	if (ret)
+		return ret;
+
+	len = sizeof(struct apml_mca_dump) +
+	      (uint32_t)mca_banks * bytes_per_mca;
+	part->data = malloc(len);
+	if (!part->data)
+		return OOB_NO_MEMORY;
+
+	return apml_ras_dump_mca_until(cs->soc_num, part->data, len,
+				       &part->len, cs->deadline);
+}
+
+static oob_status_t collect_info(struct crash_soc *cs, struct crash_part *part)
+{
+	struct apml_crash_soc_info *info = &cs->info;
+	oob_status_t ret;
+	uint32_t i;
+
+	if (apml_deadline_expired(cs->deadline))
+		return OOB_CMD_TIMEOUT;
+
+	part->data = info;
+	part->len = sizeof(*info);
+	ret = read_ppin_fuse(cs->soc_num, &info->ppin);
+	if (ret)
+		return ret;
+	ret = read_ucode_revision(cs->soc_num, &info->ucode);
+	if (ret)
+		return ret;
+	/* Offset 0 refreshes the post code cache */
+	for (i = 0; i < APML_CRASH_POST_CODES; i++) {
+		ret = get_post_code(cs->soc_num, i, &info->post_code[i]);
+		if (ret)
+			return ret;
+	}
+
+	return OOB_SUCCESS;
+}
+
+static oob_status_t collect_df(struct crash_soc *cs, struct crash_part *part)
+{
+	struct apml_df_check *check;
+	oob_status_t ret;
+
+	if (apml_deadline_expired(cs->deadline))
+		return OOB_CMD_TIMEOUT;
+
+	check = malloc(sizeof(*check));
+	if (!check)
+		return OOB_NO_MEMORY;
+	ret = apml_ras_df_check(cs->soc_num, check);
+	if (!ret && check->size) {
+		part->data = malloc(check->size);
+		if (part->data)
+			ret = apml_ras_dump_df_until(cs->soc_num, check,
+						     part->data, check->size,
+						     &part->len, cs->deadline);
+		else
+			ret = OOB_NO_MEMORY;
+	}
+	free(check);
+
+	return ret;
+}
+
+static oob_status_t collect_rt(struct crash_soc *cs, struct crash_part *part)
+{
+	struct apml_rt_queue *queue;
+	struct apml_crash_rt *rt;
+	struct apml_rt_err err;
+	oob_status_t ret;
+
+	if (apml_deadline_expired(cs->deadline))
+		return OOB_CMD_TIMEOUT;
+
+	ret = apml_rt_queue_create(RT_QUEUE_DEPTH, &queue);
+	if (ret)
+		return ret;
+	/* Records harvested before a failure are still in the queue */
+	ret = apml_ras_rt_harvest(cs->soc_num, false, queue, NULL);
+	part->data = malloc(RT_QUEUE_DEPTH * (sizeof(*rt) + sizeof(err.data)));
+	if (!part->data) {
+		apml_rt_queue_destroy(queue);
+		return OOB_NO_MEMORY;
+	}
+	/* Entries keep the record bytes only, dword aligned */
+	while (apml_rt_queue_pop(queue, &err)) {
+		rt = (struct apml_crash_rt *)((uint8_t *)part->data +
+					      part->len);
+		memset(rt, 0, sizeof(*rt) + ((err.len + 3) & ~3U));
+		rt->category = err.category;
+		rt->instance = err.instance;
+		rt->len = err.len;
+		memcpy(rt->data, err.data, err.len);
+		part->len += sizeof(*rt) + ((err.len + 3) & ~3U);
+	}
+	apml_rt_queue_destroy(queue);
+
+	return ret;
+}
+
+static void *collect_thread(void *arg)
+{
+	static const collect_fn collect[SOC_PARTS] = {
+		collect_mca, collect_info, collect_df, collect_rt,
+	};
+	static const uint16_t types[SOC_PARTS] = {
+		APML_CRASH_MCA, APML_CRASH_SOC, APML_CRASH_DF, APML_CRASH_RT,
+	};
+	struct crash_soc *cs = arg;
+	uint32_t i;
+
+	/* MCA banks first, they matter most when the budget is short */
+	for (i = 0; i < SOC_PARTS; i++) {
+		cs->part[i].type = types[i];
+		cs->part[i].ret = collect[i](cs, &cs->part[i]);
+	}
+
+	return NULL;
+}
+
+static oob_status_t write_all(int fd, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return OOB_FILE_ERROR;
+		}
+		p += n;
+		len -= n;
+	}
+
+	return OOB_SUCCESS;
+}
+
+/* Lay the record out in memory for a single sequential write */
+static struct apml_crash_hdr *build_record(const struct apml_crash_hdr *hdr,
+					   const struct crash_soc *cs,
+					   uint8_t count)
+{
+	struct apml_crash_section *sec;
+	const struct crash_part *part;
+	struct apml_crash_hdr *rec;
+	uint32_t len = sizeof(*hdr);
+	uint8_t *p;
+	uint8_t i, j;
+
+	for (i = 0; i < count; i++)
+		for (j = 0; j < SOC_PARTS; j++)
+			len += sizeof(*sec) + SECTION_ALIGN(cs[i].part[j].len);
+
+	rec = calloc(1, len);
+	if (!rec)
+		return NULL;
+	*rec = *hdr;
+	rec->len = len;
+	rec->sections = count * SOC_PARTS;
+
+	p = (uint8_t *)(rec + 1);
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < SOC_PARTS; j++) {
+			part = &cs[i].part[j];
+			sec = (struct apml_crash_section *)p;
+			sec->type = part->type;
+			sec->soc_num = cs[i].soc_num;
+			sec->status = part->ret;
+			sec->len = part->len;
+			if (part->len)
+				memcpy(sec + 1, part->data, part->len);
+			p += sizeof(*sec) + SECTION_ALIGN(part->len);
+		}
+	}
+	rec->crc = record_crc(rec);
+
+	return rec;
+}
+
+oob_status_t apml_crash_collect(const uint8_t *socs, uint8_t count,
+				const struct apml_crash_opts *opts, int fd)
+{
+	struct ras_override_delay delay = {0};
+	struct apml_crash_hdr hdr = {0}, *rec;
+	struct timespec start, end, deadline;
+	struct crash_soc *cs;
+	oob_status_t ret = OOB_SUCCESS, rel;
+	uint32_t ack = 0;
+	bool delay_ack;
+	uint8_t i, j;
+
+	if (!socs || !opts)
+		return OOB_ARG_PTR_NULL;
+	if (!count)
+		return OOB_INVALID_INPUT;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	hdr.magic = APML_CRASH_MAGIC;
+	hdr.version = APML_CRASH_VERSION;
+	hdr.budget_ms = opts->budget_ms;
+	hdr.time = time(NULL);
+
+	/* Allocate before the delay, a held reset must reach the release */
+	cs = calloc(count, sizeof(*cs));
+	if (!cs)
+		return OOB_NO_MEMORY;
+
+	/* Extend the reset delay first, the window is short */
+	if (opts->delay_min || opts->hold) {
+		delay.delay_val_override = opts->delay_min;
+		delay.stop_delay_counter = opts->hold;
+		if (!override_delay_reset_on_sync_flood(0, delay, &delay_ack) &&
+		    delay_ack)
+			hdr.flags |= APML_CRASH_DELAY_SET;
+	}
+
+	deadline = start;
+	deadline.tv_sec += opts->budget_ms / 1000;
+	deadline.tv_nsec += (int64_t)(opts->budget_ms % 1000) * 1000000;
+	deadline.tv_sec += deadline.tv_nsec / NSEC_PER_SEC;
+	deadline.tv_nsec %= NSEC_PER_SEC;
+
+	/* Sockets have their own APML bus, collect them in parallel */
+	for (i = 0; i < count; i++) {
+		cs[i].soc_num = socs[i];
+		cs[i].deadline = opts->budget_ms ? &deadline : NULL;
+		cs[i].started = !pthread_create(&cs[i].tid, NULL,
+						collect_thread, &cs[i]);
+		if (!cs[i].started)
+			collect_thread(&cs[i]);
+	}
+	for (i = 0; i < count; i++)
+		if (cs[i].started)
+			pthread_join(cs[i].tid, NULL);
+
+	read_rtc(0, &hdr.rtc);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	hdr.elapsed_us = ts_diff_us(&end, &start);
+	for (i = 0; i < count; i++)
+		for (j = 0; j < SOC_PARTS; j++)
+			if (cs[i].part[j].ret == OOB_CMD_TIMEOUT)
+				hdr.flags |= APML_CRASH_TIMEOUT;
+	rec = build_record(&hdr, cs, count);
+	if (rec) {
+		ret = write_all(fd, rec, rec->len);
+		free(rec);
+	} else {
+		ret = OOB_NO_MEMORY;
+	}
+
+	for (i = 0; i < count; i++) {
+		/* The identity section lives in the socket state */
+		free(cs[i].part[0].data);
+		free(cs[i].part[2].data);
+		free(cs[i].part[3].data);
+	}
+	free(cs);
+
+	/*
+	 * Release the reset once the record is out. The record cannot
+	 * tell the outcome, the caller gets it.
+	 */
+	if (!opts->no_release) {
+		rel = reset_on_sync_flood(0, &ack);
+		if (!rel && ack != 1)
+			rel = OOB_NOT_SUPPORTED;
+		if (!ret)
+			ret = rel;
+	}
+
+	return ret;
+}
+
+oob_status_t apml_crash_open(const char *path, struct apml_crash_file *file)
+{
+	struct stat st;
+	void *base;
+	int fd;
+
+	if (!path || !file)
+		return OOB_ARG_PTR_NULL;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return errno_to_oob_status(errno);
+	if (fstat(fd, &st)) {
+		close(fd);
+		return OOB_FILE_ERROR;
+	}
+	file->size = st.st_size;
+	file->base = NULL;
+	if (file->size) {
+		base = mmap(NULL, file->size, PROT_READ, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED) {
+			close(fd);
+			return OOB_FILE_ERROR;
+		}
+		file->base = base;
+	}
+	/* The mapping stays valid without the descriptor */
+	close(fd);
+
+	return OOB_SUCCESS;
+}
+
+void apml_crash_close(struct apml_crash_file *file)
+{
+	if (file && file->base)
+		munmap((void *)file->base, file->size);
+	if (file) {
+		file->base = NULL;
+		file->size = 0;
+	}
+}
+
+const struct apml_crash_hdr *apml_crash_next(const struct apml_crash_file *file,
+					     const struct apml_crash_hdr *prev)
+{
+	const struct apml_crash_hdr *rec;
+	size_t off;
+
+	if (!file || !file->base)
+		return NULL;
+
+	off = prev ? (const uint8_t *)prev - file->base + prev->len : 0;
+	if (off > file->size || file->size - off < sizeof(*rec))
+		return NULL;
+	rec = (const struct apml_crash_hdr *)(file->base + off);
+	if (rec->magic != APML_CRASH_MAGIC ||
+	    rec->version != APML_CRASH_VERSION ||
+	    rec->len < sizeof(*rec) || rec->len % 8 ||
+	    rec->len > file->size - off)
+		return NULL;
+
+	return rec;
+}
+
+bool apml_crash_verify(const struct apml_crash_hdr *rec)
+{
+	return rec && record_crc(rec) == rec->crc;
+}
+
+const struct apml_crash_section *
+apml_crash_next_section(const struct apml_crash_hdr *rec,
+			const struct apml_crash_section *prev)
+{
+	const uint8_t *base = (const uint8_t *)rec;
+	const struct apml_crash_section *sec;
+	size_t off;
+
+	if (!rec)
+		return NULL;
+
+	off = prev ? (const uint8_t *)prev - base + sizeof(*prev) +
+		     SECTION_ALIGN(prev->len) : sizeof(*rec);
+	if (off > rec->len || rec->len - off < sizeof(*sec))
+		return NULL;
+	sec = (const struct apml_crash_section *)(base + off);
+	if (SECTION_ALIGN(sec->len) > rec->len - off - sizeof(*sec))
+		return NULL;
+
+	return sec;
+}
@@ -0,0 +1,375 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_enum.h>
+#include <esmi_oob/apml_recovery.h>
+
+/* SBRMI/SBTSI DEVICE FILE PATH */
+#define DEV		"/dev/"
+/* sysfs class directory of the misc devices */
+#define MISC_CLASS	"/sys/class/misc/"
+/* Max number of device nodes considered */
+#define MAX_NODES	(2 * APML_MAX_SOCKETS)
+/* SBTSI address offset from the SBRMI address of the same socket */
+#define TSI_ADDR_OFFSET	0x10
+/* Client count, SBRMI and SBTSI */
+#define CLIENT_COUNT	2
+
+/* Device node found while scanning /dev */
+struct node_entry {
+	struct apml_node node;
+	uint8_t client;
+	int index;
+};
+
+static struct apml_node node_map[APML_MAX_SOCKETS][CLIENT_COUNT];
+static bool node_present[APML_MAX_SOCKETS][CLIENT_COUNT];
+static bool enumerated;
+/* Presence bits, SBRMI sockets in the low word and SBTSI in the high word */
+static uint64_t present_mask;
+static pthread_rwlock_t map_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* Resolve the bus and address of a node from its sysfs device link */
+static void read_sysfs_location(const char *name, struct apml_node *node)
+{
+	char link[PATH_MAX], target[PATH_MAX];
+	char *base;
+	int16_t bus;
+	uint16_t addr;
+	ssize_t len;
+
+	snprintf(link, sizeof(link), "%s%s/device", MISC_CLASS, name);
+	len = readlink(link, target, sizeof(target) - 1);
+	if (len < 0)
+		return;
+	target[len] = '\0';
+
+	/* I2C client devices are named <bus>-<4 digit hex address> */
+	base = strrchr(target, '/');
+	base = base ? base + 1 : target;
+	if (sscanf(base, "%hd-%hx", &bus, &addr) == 2) {
+		node->bus = bus;
+		if (!node->addr)
+			node->addr = addr;
+	}
+}
+
+/*
+ * Parse a device node name, the accepted forms are <module>N,
+ * <module>-<addr> and <module>-<bus>-<addr>.
+ */
+static bool parse_node_name(const char *name, struct node_entry *entry)
+{
+	const char *rest;
+	char *end;
+
+	if (!strncmp(name, SBRMI, strlen(SBRMI)))
+		entry->client = DEV_SBRMI;
+	else if (!strncmp(name, SBTSI, strlen(SBTSI)))
+		entry->client = DEV_SBTSI;
+	else
+		return false;
+
+	rest = name + strlen(SBRMI);
+	entry->index = -1;
+	entry->node.addr = 0;
+	entry->node.bus = -1;
+	if (*rest == '-') {
+		if (strchr(rest + 1, '-')) {
+			if (sscanf(rest, "-%hd-%hx", &entry->node.bus,
+				   &entry->node.addr) != 2)
+				return false;
+		} else {
+			entry->node.addr = strtoul(rest + 1, &end, 16);
+			if (*end != '\0' || end == rest + 1)
+				return false;
+		}
+	} else {
+		entry->index = strtol(rest, &end, 10);
+		if (*end != '\0' || end == rest || entry->index < 0)
+			return false;
+	}
+	if (snprintf(entry->node.path, APML_DEV_PATH_SIZE, "%s%s", DEV, name)
+	    >= APML_DEV_PATH_SIZE)
+		return false;
+	read_sysfs_location(name, &entry->node);
+
+	return true;
+}
+
+static int cmp_nodes(const void *a, const void *b)
+{
+	const struct node_entry *x = a, *y = b;
+
+	if (x->node.bus != y->node.bus)
+		return x->node.bus - y->node.bus;
+	if (x->node.addr != y->node.addr)
+		return x->node.addr - y->node.addr;
+
+	return strcmp(x->node.path, y->node.path);
+}
+
+static int fixed_index(const struct node_entry *entry)
+{
+	const uint16_t *table;
+	int i;
+
+	table = entry->client == DEV_SBRMI ? sbrmi_addr : sbtsi_addr;
+	for (i = 0; i < MAX_DEV_COUNT; i++)
+		if (table[i] == entry->node.addr)
+			return i;
+
+	return -1;
+}
+
+static void place_node(struct apml_node map[][CLIENT_COUNT],
+		       bool present[][CLIENT_COUNT], int soc,
+		       struct node_entry *entry)
+{
+	map[soc][entry->client] = entry->node;
+	present[soc][entry->client] = true;
+	entry->index = soc;
+}
+
+/* Socket of the SBRMI node a custom address SBTSI node belongs to */
+static int paired_socket(struct apml_node map[][CLIENT_COUNT],
+			 bool present[][CLIENT_COUNT],
+			 const struct node_entry *entry)
+{
+	int soc;
+
+	for (soc = 0; soc < APML_MAX_SOCKETS; soc++)
+		if (present[soc][DEV_SBRMI] && !present[soc][DEV_SBTSI] &&
+		    map[soc][DEV_SBRMI].bus == entry->node.bus &&
+		    map[soc][DEV_SBRMI].addr + TSI_ADDR_OFFSET ==
+		    entry->node.addr)
+			return soc;
+
+	return -1;
+}
+
+oob_status_t apml_enumerate(void)
+{
+	struct apml_node map[APML_MAX_SOCKETS][CLIENT_COUNT] = {0};
+	bool present[APML_MAX_SOCKETS][CLIENT_COUNT] = {false};
+	struct node_entry *entries;
+	struct dirent *dent;
+	uint64_t mask = 0;
+	int count = 0, i, s, soc, pass;
+	DIR *dir;
+
+	entries = calloc(MAX_NODES, sizeof(*entries));
+	if (!entries)
+		return OOB_NO_MEMORY;
+
+	dir = opendir(DEV);
+	if (!dir) {
+		free(entries);
+		return errno_to_oob_status(errno);
+	}
+	while ((dent = readdir(dir)) && count < MAX_NODES)
+		if (parse_node_name(dent->d_name, &entries[count]))
+			count++;
+	closedir(dir);
+	qsort(entries, count, sizeof(*entries), cmp_nodes);
+
+	/* Nodes named by index and nodes at the fixed addresses first */
+	for (i = 0; i < count; i++) {
+		soc = entries[i].index;
+		if (soc < 0)
+			soc = fixed_index(&entries[i]);
+		if (soc >= 0 && soc < APML_MAX_SOCKETS &&
+		    !present[soc][entries[i].client])
+			place_node(map, present, soc, &entries[i]);
+		else
+			entries[i].index = -1;
+	}
+
+	/* Custom addresses, SBRMI nodes before their SBTSI pairs */
+	for (pass = DEV_SBRMI; pass <= DEV_SBTSI; pass++) {
+		for (i = 0; i < count; i++) {
+			if (entries[i].index >= 0 || entries[i].client != pass)
+				continue;
+			soc = -1;
+			if (pass == DEV_SBTSI)
+				soc = paired_socket(map, present, &entries[i]);
+			for (s = 0; soc < 0 && s < APML_MAX_SOCKETS; s++)
+				if (!present[s][DEV_SBRMI] &&
+				    !present[s][DEV_SBTSI])
+					soc = s;
+			if (soc >= 0)
+				place_node(map, present, soc, &entries[i]);
+		}
+	}
+	free(entries);
+
+	for (soc = 0; soc < APML_MAX_SOCKETS; soc++) {
+		if (present[soc][DEV_SBRMI])
+			mask |= (uint64_t)1 << soc;
+		if (present[soc][DEV_SBTSI])
+			mask |= (uint64_t)1 << (soc + D_WORD_BITS);
+	}
+
+	pthread_rwlock_wrlock(&map_lock);
+	memcpy(node_map, map, sizeof(node_map));
+	memcpy(node_present, present, sizeof(node_present));
+	__atomic_store_n(&present_mask, mask, __ATOMIC_RELEASE);
+	__atomic_store_n(&enumerated, true, __ATOMIC_RELEASE);
+	pthread_rwlock_unlock(&map_lock);
+
+	return count ? OOB_SUCCESS : OOB_NOT_FOUND;
+}
+
+void apml_enum_reset(void)
+{
+	pthread_rwlock_wrlock(&map_lock);
+	memset(node_map, 0, sizeof(node_map));
+	memset(node_present, 0, sizeof(node_present));
+	__atomic_store_n(&present_mask, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&enumerated, false, __ATOMIC_RELEASE);
+	pthread_rwlock_unlock(&map_lock);
+}
+
+oob_status_t apml_get_node(uint8_t soc_num, uint8_t client,
+			   struct apml_node *node)
+{
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (!node)
+		return OOB_ARG_PTR_NULL;
+	if (client >= CLIENT_COUNT)
+		return OOB_INVALID_INPUT;
+
+	pthread_rwlock_rdlock(&map_lock);
+	if (!enumerated)
+		ret = OOB_NOT_INITIALIZED;
+	else if (soc_num >= APML_MAX_SOCKETS || !node_present[soc_num][client])
+		ret = OOB_FILE_ERROR;
+	else
+		*node = node_map[soc_num][client];
+	pthread_rwlock_unlock(&map_lock);
+
+	return ret;
+}
+
+oob_status_t apml_present_sockets(uint32_t *rmi_mask, uint32_t *tsi_mask)
+{
+	uint64_t mask;
+	oob_status_t ret;
+
+	if (!__atomic_load_n(&enumerated, __ATOMIC_ACQUIRE)) {
+		ret = apml_enumerate();
+		if (ret && ret != OOB_NOT_FOUND)
+			return ret;
+	}
+
+	mask = __atomic_load_n(&present_mask, __ATOMIC_ACQUIRE);
+	if (rmi_mask)
+		*rmi_mask = mask & FOUR_BYTE_MASK;
+	if (tsi_mask)
+		*tsi_mask = mask >> D_WORD_BITS;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_enum_watch(int *fd)
+{
+	if (!fd)
+		return OOB_ARG_PTR_NULL;
+
+	*fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (*fd < 0)
+		return errno_to_oob_status(errno);
+	if (inotify_add_watch(*fd, DEV, IN_CREATE | IN_DELETE |
+			      IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+		close(*fd);
+		*fd = -1;
+		return errno_to_oob_status(errno);
+	}
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_enum_watch_handle(int fd, int *changed)
+{
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *event;
+	bool rescan = false;
+	ssize_t len;
+	char *ptr;
+
+	if (changed)
+		*changed = 0;
+
+	while ((len = read(fd, buf, sizeof(buf))) > 0) {
+		for (ptr = buf; ptr < buf + len;
+		     ptr += sizeof(*event) + event->len) {
+			event = (const struct inotify_event *)ptr;
+			if (event->len &&
+			    (!strncmp(event->name, SBRMI, strlen(SBRMI)) ||
+			     !strncmp(event->name, SBTSI, strlen(SBTSI))))
+				rescan = true;
+		}
+	}
+	if (len < 0 && errno != EAGAIN)
+		return errno_to_oob_status(errno);
+	if (!rescan)
+		return OOB_SUCCESS;
+
+	if (changed)
+		*changed = 1;
+	apml_enumerate();
+
+	return OOB_SUCCESS;
+}
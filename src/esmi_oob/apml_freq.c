@@ -0,0 +1,381 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_freq.h>
+#include <esmi_oob/apml_topo.h>
+#include <esmi_oob/esmi_cpuid_msr.h>
+#include <esmi_oob/esmi_mailbox.h>
+#include <esmi_oob/esmi_rmi.h>
+
+/* Default sampling period */
+#define DEFAULT_PERIOD_MS	1000
+/* Nano seconds in a second */
+#define NSEC_PER_SEC		1000000000LL
+/* MPERF and APERF */
+#define MSR_MPERF		0xE7
+#define MSR_APERF		0xE8
+#define FREQ_MSRS		2
+/* Deltas above these multiples of the reference ticks are bogus */
+#define MPERF_SLACK		2
+#define APERF_SLACK		8
+
+/* Frequency sampler state of a socket */
+struct freq_sampler {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t tid;
+	bool running;
+	uint8_t soc_num;
+	int64_t period_ns;
+	/* CCX of every thread */
+	uint8_t ccx_of[APML_FREQ_MAX_THREADS];
+	/* Owned by the sampler thread */
+	struct apml_thread_mask prev_read;
+	int64_t prev_ns;
+	uint64_t cnt[2][APML_FREQ_MAX_THREADS * FREQ_MSRS];
+	uint32_t cur;
+	struct apml_freq_snapshot work;
+	/* Published under the lock */
+	struct apml_freq_snapshot snap;
+};
+
+static struct freq_sampler samplers[APML_MAX_SOCKETS] = {
+	[0 ... APML_MAX_SOCKETS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+static const uint32_t freq_msrs[FREQ_MSRS] = { MSR_MPERF, MSR_APERF };
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/*
+ * Wait until the absolute time, called with the lock held.
+ * Returns false when the sampler is stopped.
+ */
+static bool wait_until(struct freq_sampler *sp, int64_t deadline)
+{
+	struct timespec ts;
+
+	ts.tv_sec = deadline / NSEC_PER_SEC;
+	ts.tv_nsec = deadline % NSEC_PER_SEC;
+	while (sp->running) {
+		if (pthread_cond_timedwait(&sp->cond, &sp->lock, &ts) ==
+		    ETIMEDOUT)
+			break;
+	}
+
+	return sp->running;
+}
+
+/* Fold the deltas of a sweep into the work snapshot */
+static void compute(struct freq_sampler *sp,
+		    const struct apml_thread_mask *read, int64_t ns)
+{
+	struct apml_freq_snapshot *snap = &sp->work;
+	const uint64_t *cur = sp->cnt[sp->cur];
+	const uint64_t *prev = sp->cnt[sp->cur ^ 1];
+	uint64_t ccx_m[APML_FREQ_MAX_THREADS] = {0};
+	uint64_t ccx_a[APML_FREQ_MAX_THREADS] = {0};
+	uint64_t dm, da, ticks;
+	uint32_t c, i;
+	int t;
+
+	snap->period_us = (ns - sp->prev_ns) / 1000;
+	ticks = (uint64_t)snap->ref_mhz * snap->period_us;
+	memset(&snap->valid, 0, sizeof(snap->valid));
+	snap->valid.nbits = snap->threads;
+	memset(snap->thread, 0, sizeof(snap->thread));
+	memset(snap->ccx, 0, sizeof(snap->ccx));
+
+	apml_for_each_thread(t, read) {
+		if (!apml_thread_mask_test(&sp->prev_read, t))
+			continue;
+		/* Unsigned deltas absorb a 64 bit wrap */
+		dm = cur[t * FREQ_MSRS] - prev[t * FREQ_MSRS];
+		da = cur[t * FREQ_MSRS + 1] - prev[t * FREQ_MSRS + 1];
+		/* A counter that went back shows up as a huge delta */
+		if (!ticks || dm > ticks * MPERF_SLACK ||
+		    da > ticks * APERF_SLACK)
+			continue;
+
+		snap->valid.bits[t / 64] |= 1ULL << (t % 64);
+		snap->thread[t].threads = 1;
+		if (dm)
+			snap->thread[t].freq_mhz = snap->ref_mhz * da / dm;
+		snap->thread[t].c0 = dm >= ticks ? 1 : (float)dm / ticks;
+
+		c = sp->ccx_of[t];
+		ccx_m[c] += dm;
+		ccx_a[c] += da;
+		snap->ccx[c].threads++;
+		snap->ccx[c].c0 += snap->thread[t].c0;
+	}
+
+	for (i = 0; i < snap->ccx_count; i++) {
+		if (!snap->ccx[i].threads)
+			continue;
+		/* MPERF weighted, idle threads do not dilute the frequency */
+		if (ccx_m[i])
+			snap->ccx[i].freq_mhz = snap->ref_mhz * ccx_a[i] /
+						ccx_m[i];
+		snap->ccx[i].c0 /= snap->ccx[i].threads;
+	}
+}
+
+static void *freq_thread(void *arg)
+{
+	struct freq_sampler *sp = arg;
+	struct apml_thread_mask read;
+	int64_t next, start, end;
+	oob_status_t ret;
+	uint32_t i;
+
+	pthread_mutex_lock(&sp->lock);
+	next = now_ns();
+	while (wait_until(sp, next)) {
+		pthread_mutex_unlock(&sp->lock);
+		/* Every thread of the socket, the disabled ones are dropped */
+		memset(&read, 0, sizeof(read));
+		read.nbits = sp->work.threads;
+		for (i = 0; i < sp->work.threads; i++)
+			read.bits[i / 64] |= 1ULL << (i % 64);
+		start = now_ns();
+		ret = esmi_oob_read_msr_multi(sp->soc_num, freq_msrs,
+					      FREQ_MSRS, &read,
+					      sp->cnt[sp->cur]);
+		end = now_ns();
+		/* Counters of a thread are read close to the middle */
+		end = start + (end - start) / 2;
+		if (!ret && sp->prev_ns)
+			compute(sp, &read, end);
+		if (!ret) {
+			sp->prev_read = read;
+			sp->prev_ns = end;
+			sp->cur ^= 1;
+		}
+		pthread_mutex_lock(&sp->lock);
+		if (!ret && sp->work.period_us) {
+			sp->work.ts.tv_sec = end / NSEC_PER_SEC;
+			sp->work.ts.tv_nsec = end % NSEC_PER_SEC;
+			sp->work.seq++;
+			sp->snap = sp->work;
+		}
+
+		/* Skip the periods missed while the sweep ran long */
+		next += sp->period_ns;
+		while (next <= now_ns())
+			next += sp->period_ns;
+	}
+	pthread_mutex_unlock(&sp->lock);
+
+	return NULL;
+}
+
+/*
+ * CCX of every thread from the topology map. Without the map, the SMT
+ * siblings of a core are numbered cores apart and a CCX holds
+ * per_ccx / per_core consecutive cores.
+ */
+static uint32_t map_ccx(uint8_t soc_num, uint32_t threads, uint32_t per_core,
+			uint32_t per_ccx, uint8_t *ccx_of)
+{
+	struct apml_topo *topo;
+	uint32_t cores, cores_per_ccx, t, count = 0;
+
+	topo = malloc(sizeof(*topo));
+	if (topo && !apml_topo_build(soc_num, topo)) {
+		for (t = 0; t < threads; t++)
+			ccx_of[t] = topo->thread[t].enabled ?
+				    topo->thread[t].ccx : 0;
+		count = topo->ccxs;
+	}
+	free(topo);
+	if (count)
+		return count;
+
+	if (!per_core || per_core > per_ccx)
+		per_core = 1;
+	cores = (threads + per_core - 1) / per_core;
+	cores_per_ccx = per_ccx / per_core;
+	for (t = 0; t < threads; t++)
+		ccx_of[t] = (t % cores) / cores_per_ccx;
+
+	return (cores + cores_per_ccx - 1) / cores_per_ccx;
+}
+
+oob_status_t apml_freq_start(uint8_t soc_num,
+			     const struct apml_freq_opts *opts)
+{
+	uint8_t ccx_of[APML_FREQ_MAX_THREADS] = {0};
+	uint32_t ccx_count;
+	struct apml_freq_opts def = {0};
+	uint32_t threads, per_core, per_ccx;
+	pthread_condattr_t attr;
+	struct freq_sampler *sp;
+	uint16_t ref_mhz;
+	oob_status_t ret;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+	if (!opts)
+		opts = &def;
+
+	ret = esmi_get_threads_per_socket(soc_num, &threads);
+	if (ret)
+		return ret;
+	ret = esmi_get_threads_per_core(soc_num, &per_core);
+	if (ret)
+		return ret;
+	ret = read_max_threads_per_l3(soc_num, &per_ccx);
+	if (ret)
+		return ret;
+	ref_mhz = opts->ref_mhz;
+	if (!ref_mhz) {
+		ret = read_bmc_cpu_base_frequency(soc_num, &ref_mhz);
+		if (ret)
+			return ret;
+	}
+	if (!threads || !per_ccx || !ref_mhz)
+		return OOB_INVALID_INPUT;
+	if (threads > APML_FREQ_MAX_THREADS)
+		threads = APML_FREQ_MAX_THREADS;
+	ccx_count = map_ccx(soc_num, threads, per_core, per_ccx, ccx_of);
+
+	sp = &samplers[soc_num];
+	pthread_mutex_lock(&sp->lock);
+	if (sp->running) {
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_TRY_AGAIN;
+	}
+	sp->soc_num = soc_num;
+	sp->period_ns = (int64_t)(opts->period_ms ? opts->period_ms :
+				  DEFAULT_PERIOD_MS) * 1000000;
+	sp->prev_ns = 0;
+	sp->cur = 0;
+	memset(&sp->work, 0, sizeof(sp->work));
+	sp->work.ref_mhz = ref_mhz;
+	sp->work.threads = threads;
+	sp->work.threads_per_core = per_core;
+	sp->work.threads_per_ccx = per_ccx;
+	sp->work.ccx_count = ccx_count;
+	memcpy(sp->ccx_of, ccx_of, sizeof(sp->ccx_of));
+	sp->snap.seq = 0;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sp->cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	sp->running = true;
+	if (pthread_create(&sp->tid, NULL, freq_thread, sp)) {
+		sp->running = false;
+		pthread_cond_destroy(&sp->cond);
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_NO_MEMORY;
+	}
+	pthread_mutex_unlock(&sp->lock);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_freq_stop(uint8_t soc_num)
+{
+	struct freq_sampler *sp;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	sp = &samplers[soc_num];
+	pthread_mutex_lock(&sp->lock);
+	if (!sp->running) {
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_NOT_INITIALIZED;
+	}
+	sp->running = false;
+	pthread_cond_signal(&sp->cond);
+	pthread_mutex_unlock(&sp->lock);
+
+	pthread_join(sp->tid, NULL);
+
+	pthread_mutex_lock(&sp->lock);
+	pthread_cond_destroy(&sp->cond);
+	pthread_mutex_unlock(&sp->lock);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_freq_read(uint8_t soc_num,
+			    struct apml_freq_snapshot *snap)
+{
+	struct freq_sampler *sp;
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (!snap)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	sp = &samplers[soc_num];
+	pthread_mutex_lock(&sp->lock);
+	if (!sp->running)
+		ret = OOB_NOT_INITIALIZED;
+	else if (!sp->snap.seq)
+		ret = OOB_TRY_AGAIN;
+	else
+		*snap = sp->snap;
+	pthread_mutex_unlock(&sp->lock);
+
+	return ret;
+}
@@ -0,0 +1,275 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_enum.h>
+#include <esmi_oob/apml_hwmon.h>
+#include <esmi_oob/apml_recovery.h>
+
+/* hwmon class directory */
+#define HWMON_CLASS	"/sys/class/hwmon/"
+/* Max length of a hwmon attribute value */
+#define ATTR_SIZE	32
+/* millidegree to degree and microwatt to milliwatt */
+#define MILLI		1000
+
+/* hwmon attributes served by the backend */
+typedef enum {
+	ATTR_TEMP,
+	ATTR_POWER,
+	ATTR_POWER_CAP,
+	ATTR_COUNT
+} hwmon_attr;
+
+static const char * const attr_name[ATTR_COUNT] = {
+	"temp1_input", "power1_input", "power1_cap"
+};
+
+/* Open attribute file descriptors per socket, -1 if not available */
+static int attr_fd[APML_MAX_SOCKETS][ATTR_COUNT] = {
+	[0 ... APML_MAX_SOCKETS - 1] = {[0 ... ATTR_COUNT - 1] = -1}
+};
+
+/* Read a sysfs attribute of a hwmon device into buf */
+static int read_hwmon_file(const char *dir, const char *file, char *buf,
+			   int size)
+{
+	char path[PATH_MAX];
+	ssize_t len;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s%s/%s", HWMON_CLASS, dir, file);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	len = read(fd, buf, size - 1);
+	close(fd);
+	if (len <= 0)
+		return -1;
+	buf[len] = '\0';
+
+	return 0;
+}
+
+/* Socket of the APML device at the given bus and address */
+static int socket_of(uint8_t client, int16_t bus, uint16_t addr)
+{
+	struct apml_node node;
+	const uint16_t *table;
+	oob_status_t ret;
+	int soc;
+
+	for (soc = 0; soc < APML_MAX_SOCKETS; soc++) {
+		ret = apml_get_node(soc, client, &node);
+		if (ret == OOB_NOT_INITIALIZED)
+			break;
+		if (!ret && node.addr == addr &&
+		    (node.bus < 0 || node.bus == bus))
+			return soc;
+	}
+	if (soc < APML_MAX_SOCKETS) {
+		/* Not enumerated, use the fixed address table */
+		table = client == DEV_SBRMI ? sbrmi_addr : sbtsi_addr;
+		for (soc = 0; soc < MAX_DEV_COUNT; soc++)
+			if (table[soc] == addr)
+				return soc;
+	}
+
+	return -1;
+}
+
+static void open_attr(const char *dir, int soc, hwmon_attr attr)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s%s/%s", HWMON_CLASS, dir,
+		 attr_name[attr]);
+	attr_fd[soc][attr] = open(path, O_RDONLY | O_CLOEXEC);
+}
+
+oob_status_t apml_hwmon_open(void)
+{
+	char name[ATTR_SIZE], link[PATH_MAX], target[PATH_MAX];
+	struct dirent *dent;
+	uint16_t addr;
+	int16_t bus;
+	uint8_t client;
+	ssize_t len;
+	char *base;
+	int soc, found = 0;
+	DIR *dir;
+
+	apml_hwmon_close();
+	dir = opendir(HWMON_CLASS);
+	if (!dir)
+		return errno_to_oob_status(errno);
+
+	while ((dent = readdir(dir))) {
+		if (dent->d_name[0] == '.' ||
+		    read_hwmon_file(dent->d_name, "name", name, sizeof(name)))
+			continue;
+		if (!strncmp(name, SBTSI, strlen(SBTSI)))
+			client = DEV_SBTSI;
+		else if (!strncmp(name, SBRMI, strlen(SBRMI)))
+			client = DEV_SBRMI;
+		else
+			continue;
+
+		/* The parent I2C client is named <bus>-<4 digit hex address> */
+		snprintf(link, sizeof(link), "%s%s/device", HWMON_CLASS,
+			 dent->d_name);
+		len = readlink(link, target, sizeof(target) - 1);
+		if (len < 0)
+			continue;
+		target[len] = '\0';
+		base = strrchr(target, '/');
+		base = base ? base + 1 : target;
+		if (sscanf(base, "%hd-%hx", &bus, &addr) != 2)
+			continue;
+
+		soc = socket_of(client, bus, addr);
+		if (soc < 0)
+			continue;
+		if (client == DEV_SBTSI) {
+			open_attr(dent->d_name, soc, ATTR_TEMP);
+		} else {
+			open_attr(dent->d_name, soc, ATTR_POWER);
+			open_attr(dent->d_name, soc, ATTR_POWER_CAP);
+		}
+		found++;
+	}
+	closedir(dir);
+
+	return found ? OOB_SUCCESS : OOB_NOT_FOUND;
+}
+
+void apml_hwmon_close(void)
+{
+	int soc, attr;
+
+	for (soc = 0; soc < APML_MAX_SOCKETS; soc++) {
+		for (attr = 0; attr < ATTR_COUNT; attr++) {
+			if (attr_fd[soc][attr] >= 0)
+				close(attr_fd[soc][attr]);
+			attr_fd[soc][attr] = -1;
+		}
+	}
+}
+
+static oob_status_t read_attr(uint8_t soc_num, hwmon_attr attr, long *value)
+{
+	char buf[ATTR_SIZE];
+	ssize_t len;
+	char *end;
+	int fd;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_NOT_SUPPORTED;
+	fd = attr_fd[soc_num][attr];
+	if (fd < 0)
+		return OOB_NOT_SUPPORTED;
+
+	/* sysfs attributes are regenerated on every read from offset 0 */
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (len <= 0)
+		return len < 0 ? errno_to_oob_status(errno) : OOB_UNEXPECTED_SIZE;
+	buf[len] = '\0';
+	*value = strtol(buf, &end, 10);
+	if (end == buf)
+		return OOB_UNEXPECTED_SIZE;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_hwmon_read_temp(uint8_t soc_num, float *cpu_temp)
+{
+	oob_status_t ret;
+	long value;
+
+	if (!cpu_temp)
+		return OOB_ARG_PTR_NULL;
+
+	ret = read_attr(soc_num, ATTR_TEMP, &value);
+	if (!ret)
+		*cpu_temp = (float)value / MILLI;
+
+	return ret;
+}
+
+oob_status_t apml_hwmon_read_power(uint8_t soc_num, uint32_t *power)
+{
+	oob_status_t ret;
+	long value;
+
+	if (!power)
+		return OOB_ARG_PTR_NULL;
+
+	ret = read_attr(soc_num, ATTR_POWER, &value);
+	if (!ret)
+		*power = value / MILLI;
+
+	return ret;
+}
+
+oob_status_t apml_hwmon_read_power_limit(uint8_t soc_num,
+					 uint32_t *power_limit)
+{
+	oob_status_t ret;
+	long value;
+
+	if (!power_limit)
+		return OOB_ARG_PTR_NULL;
+
+	ret = read_attr(soc_num, ATTR_POWER_CAP, &value);
+	if (!ret)
+		*power_limit = value / MILLI;
+
+	return ret;
+}
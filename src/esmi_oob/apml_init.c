@@ -0,0 +1,248 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_cap.h>
+#include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_enum.h>
+#include <esmi_oob/apml_hwmon.h>
+#include <esmi_oob/apml_init.h>
+#include <esmi_oob/apml_inventory.h>
+#include <esmi_oob/esmi_mailbox.h>
+
+/* In memory state of a socket */
+struct soc_state {
+	pthread_mutex_t lock;
+	bool discovered;
+	bool esu_valid;
+	float esu;
+	struct apml_inventory inv;
+};
+
+static struct soc_state soc_state[APML_MAX_SOCKETS] = {
+	[0 ... APML_MAX_SOCKETS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+static struct apml_init_opts init_opts;
+static bool initialized;
+/*
+ * Set while the calling thread discovers a socket, the APIs used for the
+ * discovery must then read the platform instead of the inventory.
+ */
+static __thread bool discovering;
+
+static bool caps_known(const struct apml_cap_map *map)
+{
+	int i;
+
+	for (i = 0; i < APML_CAP_WORDS; i++)
+		if (map->probed[i])
+			return true;
+
+	return false;
+}
+
+/* Discover a socket, called with the socket lock held */
+static oob_status_t discover_socket(uint8_t soc_num)
+{
+	struct soc_state *st = &soc_state[soc_num];
+	oob_status_t ret;
+
+	discovering = true;
+	if (init_opts.use_cache_file)
+		ret = apml_inventory_get(soc_num, NULL, &st->inv);
+	else
+		ret = apml_inventory_read(soc_num, &st->inv);
+	if (!ret && init_opts.probe_caps && !caps_known(&st->inv.caps)) {
+		if (!apml_cap_probe(soc_num)) {
+			apml_cap_get_map(soc_num, &st->inv.caps);
+			if (init_opts.use_cache_file)
+				apml_inventory_save(soc_num, NULL, &st->inv);
+		}
+	}
+	discovering = false;
+	if (!ret)
+		st->discovered = true;
+
+	return ret;
+}
+
+/* Read the RAPL units of a socket, called with the socket lock held */
+static oob_status_t read_esu(uint8_t soc_num)
+{
+	struct soc_state *st = &soc_state[soc_num];
+	uint8_t tu_value, esu_value;
+	oob_status_t ret;
+
+	ret = read_bmc_rapl_units(soc_num, &tu_value, &esu_value);
+	if (ret)
+		return ret;
+	st->esu = ldexpf(1.0f, -esu_value);
+	st->esu_valid = true;
+
+	return OOB_SUCCESS;
+}
+
+static void *eager_discover(void *arg)
+{
+	uint8_t soc_num = (uintptr_t)arg;
+	struct soc_state *st = &soc_state[soc_num];
+
+	pthread_mutex_lock(&st->lock);
+	/* Failures are retried lazily on first use */
+	if (!discover_socket(soc_num))
+		read_esu(soc_num);
+	pthread_mutex_unlock(&st->lock);
+
+	return NULL;
+}
+
+oob_status_t apml_init(const struct apml_init_opts *opts)
+{
+	pthread_t tid[APML_MAX_SOCKETS];
+	bool started[APML_MAX_SOCKETS] = {false};
+	uint32_t rmi_mask = 0;
+	uint8_t soc_num;
+	int present = 0;
+
+	if (__atomic_load_n(&initialized, __ATOMIC_ACQUIRE))
+		apml_fini();
+
+	memset(&init_opts, 0, sizeof(init_opts));
+	if (opts)
+		init_opts = *opts;
+	if (!init_opts.num_sockets || init_opts.num_sockets > APML_MAX_SOCKETS)
+		init_opts.num_sockets = APML_MAX_SOCKETS;
+	__atomic_store_n(&initialized, true, __ATOMIC_RELEASE);
+
+	/* Map sockets to device nodes once */
+	apml_enumerate();
+	if (init_opts.use_hwmon)
+		apml_hwmon_open();
+	if (init_opts.mode != APML_INIT_EAGER)
+		return OOB_SUCCESS;
+
+	/* Discover every present socket in parallel */
+	apml_present_sockets(&rmi_mask, NULL);
+	for (soc_num = 0; soc_num < init_opts.num_sockets; soc_num++) {
+		if (!(rmi_mask & BIT(soc_num)))
+			continue;
+		present++;
+		if (!pthread_create(&tid[soc_num], NULL, eager_discover,
+				    (void *)(uintptr_t)soc_num))
+			started[soc_num] = true;
+		else
+			eager_discover((void *)(uintptr_t)soc_num);
+	}
+	for (soc_num = 0; soc_num < init_opts.num_sockets; soc_num++)
+		if (started[soc_num])
+			pthread_join(tid[soc_num], NULL);
+
+	return present ? OOB_SUCCESS : OOB_NOT_FOUND;
+}
+
+void apml_fini(void)
+{
+	int i;
+
+	__atomic_store_n(&initialized, false, __ATOMIC_RELEASE);
+	apml_hwmon_close();
+	apml_enum_reset();
+	for (i = 0; i < APML_MAX_SOCKETS; i++) {
+		pthread_mutex_lock(&soc_state[i].lock);
+		soc_state[i].discovered = false;
+		soc_state[i].esu_valid = false;
+		memset(&soc_state[i].inv, 0, sizeof(soc_state[i].inv));
+		pthread_mutex_unlock(&soc_state[i].lock);
+	}
+}
+
+oob_status_t apml_get_inventory(uint8_t soc_num, struct apml_inventory *inv)
+{
+	struct soc_state *st;
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (!inv)
+		return OOB_ARG_PTR_NULL;
+	if (!__atomic_load_n(&initialized, __ATOMIC_ACQUIRE))
+		return OOB_NOT_INITIALIZED;
+	if (soc_num >= init_opts.num_sockets)
+		return OOB_INVALID_INPUT;
+	if (discovering)
+		return OOB_TRY_AGAIN;
+
+	st = &soc_state[soc_num];
+	pthread_mutex_lock(&st->lock);
+	if (!st->discovered)
+		ret = discover_socket(soc_num);
+	if (!ret)
+		*inv = st->inv;
+	pthread_mutex_unlock(&st->lock);
+
+	return ret;
+}
+
+oob_status_t apml_get_esu_multiplier(uint8_t soc_num, float *esu)
+{
+	struct soc_state *st;
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (!esu)
+		return OOB_ARG_PTR_NULL;
+	if (!__atomic_load_n(&initialized, __ATOMIC_ACQUIRE))
+		return OOB_NOT_INITIALIZED;
+	if (soc_num >= init_opts.num_sockets)
+		return OOB_INVALID_INPUT;
+
+	st = &soc_state[soc_num];
+	pthread_mutex_lock(&st->lock);
+	if (!st->esu_valid)
+		ret = read_esu(soc_num);
+	if (!ret)
+		*esu = st->esu;
+	pthread_mutex_unlock(&st->lock);
+
+	return ret;
+}
@@ -0,0 +1,277 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_inventory.h>
+#include <esmi_oob/esmi_cpuid_msr.h>
+#include <esmi_oob/esmi_mailbox.h>
+#include <esmi_oob/esmi_rmi.h>
+
+/* Inventory cache file magic "APMI" and layout version */
+#define INV_FILE_MAGIC		0x494d5041
+#define INV_FILE_VERSION	1
+/* Max length of the cache file path */
+#define INV_PATH_SIZE		256
+/* SBRMI revision of the legacy platforms */
+#define LEGACY_RMI_REV		0x10
+/* Legacy platforms(Milan & Rome) threads per socket */
+#define LEGACY_PLAT_THREADS_PER_SOC 128
+
+/* On disk layout of the inventory cache file */
+struct inv_file {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t soc_num;
+	struct apml_inventory inv;
+};
+
+static bool caps_known(const struct apml_cap_map *map)
+{
+	int i;
+
+	for (i = 0; i < APML_CAP_WORDS; i++)
+		if (map->probed[i])
+			return true;
+
+	return false;
+}
+
+uint8_t apml_get_proc_type(uint8_t rmi_rev, const struct processor_info *proc)
+{
+	if (rmi_rev == LEGACY_RMI_REV)
+		return LEGACY_PLATFORMS;
+
+	/* Family 1A and Model in 00 - 0Fh */
+	if (proc->family == 0x1A) {
+		switch (proc->model) {
+		case 0x00 ... 0x0F:
+			return FAM_1A_MOD_00;
+		case 0x10 ... 0x1F:
+			return FAM_1A_MOD_10;
+		default:
+			return LEGACY_PLATFORMS;
+		}
+	} else if (proc->family == 0x19) {
+		switch (proc->model) {
+		case 0x10 ... 0x1F:
+			return FAM_19_MOD_10;
+		case 0x90 ... 0x9F:
+			return FAM_19_MOD_90;
+		case 0xA0 ... 0xAF:
+			return FAM_19_MOD_A0;
+		default:
+			return LEGACY_PLATFORMS;
+		}
+	}
+
+	return LEGACY_PLATFORMS;
+}
+
+oob_status_t apml_inventory_read(uint8_t soc_num, struct apml_inventory *inv)
+{
+	oob_status_t ret;
+
+	if (!inv)
+		return OOB_ARG_PTR_NULL;
+
+	memset(inv, 0, sizeof(*inv));
+	ret = read_sbrmi_revision(soc_num, &inv->rmi_rev);
+	if (ret)
+		return ret;
+
+	if (inv->rmi_rev == LEGACY_RMI_REV) {
+		/* CPUID based discovery is not available on legacy platforms */
+		inv->p_type = LEGACY_PLATFORMS;
+		inv->threads_per_socket = LEGACY_PLAT_THREADS_PER_SOC;
+	} else {
+		ret = esmi_get_processor_info(soc_num, &inv->proc);
+		if (ret)
+			return ret;
+		inv->p_type = apml_get_proc_type(inv->rmi_rev, &inv->proc);
+
+		ret = esmi_get_threads_per_socket(soc_num,
+						  &inv->threads_per_socket);
+		if (ret)
+			return ret;
+		ret = esmi_get_threads_per_core(soc_num, &inv->threads_per_core);
+		if (ret)
+			return ret;
+
+		/* CCX layout is optional, not all platforms report L3 sharing */
+		if (!read_max_threads_per_l3(soc_num, &inv->threads_per_l3) &&
+		    inv->threads_per_core && inv->threads_per_l3) {
+			inv->max_cores_per_ccx = inv->threads_per_l3 /
+						 inv->threads_per_core;
+			inv->ccx_instances = inv->threads_per_socket /
+					     inv->threads_per_l3;
+		}
+	}
+
+	ret = read_ucode_revision(soc_num, &inv->ucode_rev);
+	if (ret && ret != OOB_MAILBOX_CMD_UNKNOWN)
+		return ret;
+
+	/* Pick up a capability map persisted by an earlier probe */
+	apml_cap_get_map(soc_num, &inv->caps);
+	if (!caps_known(&inv->caps) && !apml_cap_load(soc_num, NULL))
+		apml_cap_get_map(soc_num, &inv->caps);
+
+	return OOB_SUCCESS;
+}
+
+static const char *inv_file_path(uint8_t soc_num, const char *path, char *buf)
+{
+	if (path)
+		return path;
+
+	mkdir(APML_CACHE_DIR, 0755);
+	snprintf(buf, INV_PATH_SIZE, "%s/inventory-%d", APML_CACHE_DIR,
+		 soc_num);
+
+	return buf;
+}
+
+oob_status_t apml_inventory_save(uint8_t soc_num, const char *path,
+				 const struct apml_inventory *inv)
+{
+	char def_path[INV_PATH_SIZE];
+	char tmp_path[INV_PATH_SIZE];
+	struct inv_file file = {0};
+	oob_status_t ret = OOB_SUCCESS;
+	ssize_t len;
+	int fd;
+
+	if (!inv)
+		return OOB_ARG_PTR_NULL;
+
+	file.magic = INV_FILE_MAGIC;
+	file.version = INV_FILE_VERSION;
+	file.soc_num = soc_num;
+	file.inv = *inv;
+
+	path = inv_file_path(soc_num, path, def_path);
+	if ((size_t)snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path)
+	    >= sizeof(tmp_path))
+		return OOB_INVALID_INPUT;
+
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return errno_to_oob_status(errno);
+	len = write(fd, &file, sizeof(file));
+	close(fd);
+	if (len != sizeof(file)) {
+		unlink(tmp_path);
+		return OOB_FILE_ERROR;
+	}
+	if (rename(tmp_path, path) < 0) {
+		ret = errno_to_oob_status(errno);
+		unlink(tmp_path);
+	}
+
+	return ret;
+}
+
+/*
+ * Validate a cached inventory with a single read. The microcode revision
+ * changes with any BIOS update, platforms without it fall back to the
+ * SBRMI revision register.
+ */
+static bool inventory_valid(uint8_t soc_num, const struct apml_inventory *inv)
+{
+	uint32_t ucode_rev = 0;
+	uint8_t rev = 0;
+
+	if (inv->ucode_rev) {
+		if (read_ucode_revision(soc_num, &ucode_rev))
+			return false;
+		return ucode_rev == inv->ucode_rev;
+	}
+	if (read_sbrmi_revision(soc_num, &rev))
+		return false;
+
+	return rev == inv->rmi_rev;
+}
+
+oob_status_t apml_inventory_get(uint8_t soc_num, const char *path,
+				struct apml_inventory *inv)
+{
+	char def_path[INV_PATH_SIZE];
+	const char *file_path;
+	struct inv_file file;
+	oob_status_t ret;
+	ssize_t len = 0;
+	int fd;
+
+	if (!inv)
+		return OOB_ARG_PTR_NULL;
+
+	file_path = inv_file_path(soc_num, path, def_path);
+	fd = open(file_path, O_RDONLY);
+	if (fd >= 0) {
+		len = read(fd, &file, sizeof(file));
+		close(fd);
+	}
+	if (len == sizeof(file) && file.magic == INV_FILE_MAGIC &&
+	    file.version == INV_FILE_VERSION && file.soc_num == soc_num &&
+	    inventory_valid(soc_num, &file.inv)) {
+		*inv = file.inv;
+		if (caps_known(&inv->caps))
+			apml_cap_set_map(soc_num, &inv->caps);
+		return OOB_SUCCESS;
+	}
+
+	/* Missing or stale cache, rebuild it from the platform */
+	ret = apml_inventory_read(soc_num, inv);
+	if (ret)
+		return ret;
+	apml_inventory_save(soc_num, file_path, inv);
+
+	return OOB_SUCCESS;
+}
@@ -0,0 +1,266 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_mca.h>
+
+/* Platforms of a bank type, bits of enum PROC_DETAILS */
+#define PLAT_ALL	(BIT(LEGACY_PLATFORMS) | PLAT_V2)
+#define PLAT_V2		(BIT(FAM_19_MOD_10) | BIT(FAM_19_MOD_90) | \
+			 BIT(FAM_1A_MOD_00) | BIT(FAM_1A_MOD_10) | \
+			 BIT(FAM_19_MOD_A0))
+
+/* Table key of a hardware ID and MCA type */
+#define MCA_KEY(hwid, type)	((uint32_t)(hwid) << 16 | (type))
+
+/* MCA_STATUS fields */
+#define STATUS_VAL		63
+#define STATUS_OVERFLOW		62
+#define STATUS_UC		61
+#define STATUS_EN		60
+#define STATUS_MISCV		59
+#define STATUS_ADDRV		58
+#define STATUS_PCC		57
+#define STATUS_CORE_ID_VAL	56
+#define STATUS_TCC		55
+#define STATUS_SYNDV		53
+#define STATUS_DEFERRED		44
+#define STATUS_POISON		43
+#define STATUS_CORE_ID_POS	32
+#define STATUS_CORE_ID_MASK	0x3F
+#define STATUS_EXT_POS		16
+#define STATUS_EXT_MASK		0x3F
+/* MCA_IPID fields */
+#define IPID_TYPE_POS		48
+#define IPID_INST_HI_POS	44
+#define IPID_INST_HI_MASK	0xF
+#define IPID_HWID_POS		32
+#define IPID_HWID_MASK		0xFFF
+/* MCA_ADDR fields */
+#define ADDR_MASK		((1ULL << 56) - 1)
+#define ADDR_LSB_POS		56
+#define ADDR_LSB_MASK		0x3F
+/* MCA_SYND fields */
+#define SYND_POS		32
+#define SYND_LEN_POS		18
+#define SYND_LEN_MASK		0x3F
+#define SYND_INFO_MASK		0x3FFFF
+
+/* Bank type of a hardware ID and MCA type on the platforms */
+struct mca_bank_entry {
+	uint32_t key;
+	uint8_t type;
+	uint8_t plat;
+};
+
+/* Sorted by key for the binary search */
+static const struct mca_bank_entry mca_banks[] = {
+	{ MCA_KEY(0x01, 0x0),	APML_MCA_BANK_SMU,	PLAT_ALL },
+	{ MCA_KEY(0x01, 0x1),	APML_MCA_BANK_SMU,	PLAT_V2 },
+	{ MCA_KEY(0x01, 0x2),	APML_MCA_BANK_MP5,	PLAT_ALL },
+	{ MCA_KEY(0x01, 0x3),	APML_MCA_BANK_MPDMA,	PLAT_V2 },
+	{ MCA_KEY(0x05, 0x0),	APML_MCA_BANK_PB,	PLAT_ALL },
+	{ MCA_KEY(0x18, 0x0),	APML_MCA_BANK_NBIO,	PLAT_ALL },
+	{ MCA_KEY(0x2E, 0x0),	APML_MCA_BANK_CS,	PLAT_ALL },
+	{ MCA_KEY(0x2E, 0x1),	APML_MCA_BANK_PIE,	PLAT_ALL },
+	{ MCA_KEY(0x2E, 0x2),	APML_MCA_BANK_CS,	PLAT_ALL },
+	{ MCA_KEY(0x2E, 0x4),	APML_MCA_BANK_MALL,	PLAT_V2 },
+	{ MCA_KEY(0x46, 0x0),	APML_MCA_BANK_PCIE,	PLAT_ALL },
+	{ MCA_KEY(0x46, 0x1),	APML_MCA_BANK_PCIE,	PLAT_V2 },
+	{ MCA_KEY(0x50, 0x0),	APML_MCA_BANK_XGMI_PCS,	PLAT_ALL },
+	{ MCA_KEY(0x6C, 0x0),	APML_MCA_BANK_NBIF,	PLAT_ALL },
+	{ MCA_KEY(0x80, 0x0),	APML_MCA_BANK_SHUB,	PLAT_ALL },
+	{ MCA_KEY(0x96, 0x0),	APML_MCA_BANK_UMC,	PLAT_ALL },
+	{ MCA_KEY(0x96, 0x1),	APML_MCA_BANK_UMC,	PLAT_V2 },
+	{ MCA_KEY(0xA8, 0x0),	APML_MCA_BANK_SATA,	PLAT_ALL },
+	{ MCA_KEY(0xAA, 0x0),	APML_MCA_BANK_USB,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x0),	APML_MCA_BANK_LS,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x1),	APML_MCA_BANK_IF,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x2),	APML_MCA_BANK_L2,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x3),	APML_MCA_BANK_DE,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x5),	APML_MCA_BANK_EX,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x6),	APML_MCA_BANK_FP,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x7),	APML_MCA_BANK_L3,	PLAT_ALL },
+	{ MCA_KEY(0xB0, 0x10),	APML_MCA_BANK_LS,	PLAT_V2 },
+	{ MCA_KEY(0xFF, 0x0),	APML_MCA_BANK_PSP,	PLAT_ALL },
+	{ MCA_KEY(0xFF, 0x1),	APML_MCA_BANK_PSP,	PLAT_V2 },
+	{ MCA_KEY(0x241, 0x0),	APML_MCA_BANK_GMI_PCS,	PLAT_ALL },
+	{ MCA_KEY(0x259, 0x0),	APML_MCA_BANK_XGMI_PHY,	PLAT_ALL },
+	{ MCA_KEY(0x267, 0x0),	APML_MCA_BANK_WAFL_PHY,	PLAT_ALL },
+	{ MCA_KEY(0x269, 0x0),	APML_MCA_BANK_GMI_PHY,	PLAT_ALL },
+};
+
+static const char * const mca_bank_names[APML_MCA_BANK_TYPES] = {
+	[APML_MCA_BANK_UNKNOWN]		= "Unknown",
+	[APML_MCA_BANK_LS]		= "Load Store Unit",
+	[APML_MCA_BANK_IF]		= "Instruction Fetch Unit",
+	[APML_MCA_BANK_L2]		= "L2 Cache",
+	[APML_MCA_BANK_DE]		= "Decode Unit",
+	[APML_MCA_BANK_EX]		= "Execution Unit",
+	[APML_MCA_BANK_FP]		= "Floating Point Unit",
+	[APML_MCA_BANK_L3]		= "L3 Cache",
+	[APML_MCA_BANK_CS]		= "Coherent Slave",
+	[APML_MCA_BANK_PIE]		= "Power, Interrupts, etc.",
+	[APML_MCA_BANK_MALL]		= "Memory Attached Last Level Cache",
+	[APML_MCA_BANK_UMC]		= "Unified Memory Controller",
+	[APML_MCA_BANK_PB]		= "Parameter Block",
+	[APML_MCA_BANK_PSP]		= "Platform Security Processor",
+	[APML_MCA_BANK_SMU]		= "System Management Unit",
+	[APML_MCA_BANK_MP5]		= "Microprocessor 5 Unit",
+	[APML_MCA_BANK_MPDMA]		= "MPDMA Unit",
+	[APML_MCA_BANK_NBIO]		= "Northbridge IO Unit",
+	[APML_MCA_BANK_PCIE]		= "PCI Express Unit",
+	[APML_MCA_BANK_XGMI_PCS]	= "xGMI PCS Unit",
+	[APML_MCA_BANK_NBIF]		= "NBIF Unit",
+	[APML_MCA_BANK_SHUB]		= "System Hub Unit",
+	[APML_MCA_BANK_SATA]		= "SATA Unit",
+	[APML_MCA_BANK_USB]		= "USB Unit",
+	[APML_MCA_BANK_GMI_PCS]		= "GMI PCS Unit",
+	[APML_MCA_BANK_XGMI_PHY]	= "xGMI PHY Unit",
+	[APML_MCA_BANK_WAFL_PHY]	= "WAFL PHY Unit",
+	[APML_MCA_BANK_GMI_PHY]		= "GMI PHY Unit",
+};
+
+static apml_mca_bank_type lookup_bank(uint8_t p_type, uint32_t key)
+{
+	uint32_t lo = 0, hi = ARRAY_SIZE(mca_banks), mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (mca_banks[mid].key < key) {
+			lo = mid + 1;
+		} else if (mca_banks[mid].key > key) {
+			hi = mid;
+		} else {
+			if (mca_banks[mid].plat & BIT(p_type))
+				return mca_banks[mid].type;
+			break;
+		}
+	}
+
+	return APML_MCA_BANK_UNKNOWN;
+}
+
+static bool status_bit(uint64_t status, uint8_t pos)
+{
+	return (status >> pos) & 1;
+}
+
+oob_status_t apml_mca_regs_from_dump(const uint32_t *data, uint16_t bytes,
+				     struct apml_mca_regs *regs)
+{
+	uint32_t i, dwords;
+
+	if (!data || !regs)
+		return OOB_ARG_PTR_NULL;
+
+	memset(regs, 0, sizeof(*regs));
+	dwords = bytes / sizeof(uint32_t);
+	if (dwords > 2 * APML_MCA_REGS)
+		dwords = 2 * APML_MCA_REGS;
+	/* Low dword of a MSR first */
+	for (i = 0; i < dwords; i++)
+		regs->reg[i / 2] |= (uint64_t)data[i] << (32 * (i % 2));
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_mca_decode(uint8_t p_type, const struct apml_mca_regs *regs,
+			     struct apml_mca_info *info)
+{
+	uint64_t status, ipid, addr, synd;
+
+	if (!regs || !info)
+		return OOB_ARG_PTR_NULL;
+	/* Scalable MCA platforms only */
+	if (p_type == NOT_SUPPORTED || p_type > FAM_19_MOD_A0)
+		return OOB_NOT_SUPPORTED;
+
+	status = regs->reg[APML_MCA_STATUS];
+	ipid = regs->reg[APML_MCA_IPID];
+	addr = regs->reg[APML_MCA_ADDR];
+	synd = regs->reg[APML_MCA_SYND];
+
+	info->mca_type = ipid >> IPID_TYPE_POS;
+	info->instance_id_hi = (ipid >> IPID_INST_HI_POS) & IPID_INST_HI_MASK;
+	info->hwid = (ipid >> IPID_HWID_POS) & IPID_HWID_MASK;
+	info->instance_id = ipid & FOUR_BYTE_MASK;
+	info->type = lookup_bank(p_type, MCA_KEY(info->hwid, info->mca_type));
+
+	info->error_code = status & TWO_BYTE_MASK;
+	info->error_code_ext = (status >> STATUS_EXT_POS) & STATUS_EXT_MASK;
+	info->core_id = (status >> STATUS_CORE_ID_POS) & STATUS_CORE_ID_MASK;
+	info->valid = status_bit(status, STATUS_VAL);
+	info->overflow = status_bit(status, STATUS_OVERFLOW);
+	info->uc = status_bit(status, STATUS_UC);
+	info->en = status_bit(status, STATUS_EN);
+	info->misc_valid = status_bit(status, STATUS_MISCV);
+	info->addr_valid = status_bit(status, STATUS_ADDRV);
+	info->pcc = status_bit(status, STATUS_PCC);
+	info->core_id_valid = status_bit(status, STATUS_CORE_ID_VAL);
+	info->tcc = status_bit(status, STATUS_TCC);
+	info->synd_valid = status_bit(status, STATUS_SYNDV);
+	info->deferred = status_bit(status, STATUS_DEFERRED);
+	info->poison = status_bit(status, STATUS_POISON);
+
+	/* Address and syndrome are meaningful only when flagged valid */
+	info->addr = info->addr_valid ? addr & ADDR_MASK : 0;
+	info->addr_lsb = info->addr_valid ?
+			 (addr >> ADDR_LSB_POS) & ADDR_LSB_MASK : 0;
+	info->syndrome = info->synd_valid ? synd >> SYND_POS : 0;
+	info->synd_len = info->synd_valid ?
+			 (synd >> SYND_LEN_POS) & SYND_LEN_MASK : 0;
+	info->err_info = info->synd_valid ? synd & SYND_INFO_MASK : 0;
+
+	return OOB_SUCCESS;
+}
+
+const char *apml_mca_bank_name(apml_mca_bank_type type)
+{
+	if (type >= APML_MCA_BANK_TYPES)
+		type = APML_MCA_BANK_UNKNOWN;
+
+	return mca_bank_names[type];
+}
@@ -0,0 +1,237 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <esmi_oob/apml_power.h>
+#include <esmi_oob/esmi_mailbox.h>
+#include <esmi_oob/rmi_mailbox_mi300.h>
+
+/* Nano seconds in a second */
+#define NSEC_PER_SEC		1000000000LL
+/* MI300 energy accumulator unit 2^-16 J */
+#define MI300_ENERGY_SHIFT	16
+/* MI300 time stamp, 56 bits of 10 ns */
+#define MI300_TS_MASK		((1ULL << 56) - 1)
+#define MI300_TS_NS		10
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static const struct apml_power_sample *
+hist_at(const struct apml_power_acc *acc, uint32_t i)
+{
+	return &acc->hist[i % APML_POWER_HISTORY];
+}
+
+oob_status_t apml_power_init(struct apml_power_acc *acc,
+			     apml_power_source source, uint8_t soc_num,
+			     uint32_t core_id)
+{
+	uint8_t tu_value, esu_value;
+	oob_status_t ret;
+
+	if (!acc)
+		return OOB_ARG_PTR_NULL;
+
+	memset(acc, 0, sizeof(*acc));
+	acc->source = source;
+	acc->soc_num = soc_num;
+	acc->core_id = core_id;
+	switch (source) {
+	case APML_POWER_RAPL_PKG:
+	case APML_POWER_RAPL_CORE:
+		/* The unit is static, read it once */
+		ret = read_bmc_rapl_units(soc_num, &tu_value, &esu_value);
+		if (ret)
+			return ret;
+		acc->unit_j = ldexp(1.0, -esu_value);
+		break;
+	case APML_POWER_MI300:
+		acc->unit_j = ldexp(1.0, -MI300_ENERGY_SHIFT);
+		break;
+	default:
+		return OOB_INVALID_INPUT;
+	}
+
+	return OOB_SUCCESS;
+}
+
+void apml_power_feed(struct apml_power_acc *acc, uint64_t raw,
+		     uint64_t ts_ns)
+{
+	struct apml_power_sample *smp = &acc->hist[acc->head %
+						   APML_POWER_HISTORY];
+	uint64_t energy = 0;
+
+	/* Modulo 2^64 delta, a wrap needs no special case */
+	if (acc->head)
+		energy = hist_at(acc, acc->head - 1)->energy +
+			 (raw - acc->last_raw);
+	smp->energy = energy;
+	smp->ts_ns = ts_ns;
+	acc->last_raw = raw;
+	acc->head++;
+}
+
+static oob_status_t sample_mi300(struct apml_power_acc *acc)
+{
+	uint64_t energy, fw_ts, start, host;
+	int64_t offset;
+	oob_status_t ret;
+
+	start = now_ns();
+	ret = get_energy_accum_raw(acc->soc_num, &energy, &fw_ts);
+	if (ret)
+		return ret;
+	host = start + (now_ns() - start) / 2;
+
+	if (acc->head) {
+		/* Same latch as the previous read, nothing new */
+		if (fw_ts == acc->last_fw_ts)
+			return OOB_SUCCESS;
+		acc->fw_ns += ((fw_ts - acc->last_fw_ts) & MI300_TS_MASK) *
+			      MI300_TS_NS;
+	} else {
+		acc->fw_ns = fw_ts * MI300_TS_NS;
+	}
+	acc->last_fw_ts = fw_ts;
+
+	/* The smallest offset has the least bus latency in it */
+	offset = host - acc->fw_ns;
+	if (!acc->head || offset < acc->fw_offset_ns)
+		acc->fw_offset_ns = offset;
+	apml_power_feed(acc, energy, acc->fw_ns);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_power_sample(struct apml_power_acc *acc)
+{
+	struct rapl_core_energy core;
+	uint64_t raw, start;
+	oob_status_t ret;
+
+	if (!acc)
+		return OOB_ARG_PTR_NULL;
+
+	start = now_ns();
+	switch (acc->source) {
+	case APML_POWER_RAPL_PKG:
+		ret = read_rapl_pckg_energy_raw(acc->soc_num, &raw);
+		break;
+	case APML_POWER_RAPL_CORE:
+		ret = read_rapl_core_energy_sweep(acc->soc_num, &acc->core_id,
+						  1, &core);
+		raw = core.counter;
+		break;
+	case APML_POWER_MI300:
+		return sample_mi300(acc);
+	default:
+		return OOB_INVALID_INPUT;
+	}
+	if (ret)
+		return ret;
+
+	/* Stamp the middle of the read */
+	apml_power_feed(acc, raw, start + (now_ns() - start) / 2);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_power_avg(const struct apml_power_acc *acc,
+			    uint64_t window_ns, double *watts,
+			    uint64_t *span_ns)
+{
+	const struct apml_power_sample *last, *first;
+	uint32_t lo, hi, mid;
+	uint64_t span;
+
+	if (!acc || !watts)
+		return OOB_ARG_PTR_NULL;
+	if (acc->head < 2)
+		return OOB_TRY_AGAIN;
+
+	last = hist_at(acc, acc->head - 1);
+	lo = acc->head > APML_POWER_HISTORY ?
+	     acc->head - APML_POWER_HISTORY : 0;
+	hi = acc->head - 2;
+	/* Newest sample at least window_ns before the last one */
+	if (window_ns && last->ts_ns - hist_at(acc, lo)->ts_ns > window_ns) {
+		while (lo < hi) {
+			mid = lo + (hi - lo + 1) / 2;
+			if (last->ts_ns - hist_at(acc, mid)->ts_ns >= window_ns)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+	} else if (!window_ns) {
+		lo = hi;
+	}
+	first = hist_at(acc, lo);
+
+	span = last->ts_ns - first->ts_ns;
+	if (!span)
+		return OOB_TRY_AGAIN;
+	/* Integer delta first, one conversion to joules */
+	*watts = (last->energy - first->energy) * acc->unit_j * NSEC_PER_SEC /
+		 span;
+	if (span_ns)
+		*span_ns = span;
+
+	return OOB_SUCCESS;
+}
+
+double apml_power_energy(const struct apml_power_acc *acc)
+{
+	if (!acc || !acc->head)
+		return 0;
+
+	return hist_at(acc, acc->head - 1)->energy * acc->unit_j;
+}
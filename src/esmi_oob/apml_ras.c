@@ -0,0 +1,859 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_cap.h>
+#include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_ras.h>
+#include <esmi_oob/esmi_mailbox.h>
+#include <esmi_oob/esmi_rmi.h>
+
+/* Default poll period in milli seconds */
+#define DEFAULT_PERIOD_MS	100
+/* Nano seconds in a second */
+#define NSEC_PER_SEC		1000000000LL
+/* Last polled state, RASStatus << 8 | Status, with a valid bit */
+#define STATE_VALID		(1U << 16)
+/* SBRMI::Status[0] AlertSts, a thread alert is pending */
+#define STATUS_ALERT_STS	(1U << 0)
+
+/* Banks per batch when dumping against a deadline */
+#define MCA_DEADLINE_BANKS	4
+/* Firmware code of a mailbox answered with additional error data */
+#define FW_ADD_ERR_DATA	(OOB_MAILBOX_ADD_ERR_DATA - OOB_MAILBOX_ERR_BASE)
+/* Max runtime error queue depth */
+#define RT_QUEUE_MAX_DEPTH	(1 << 16)
+/* DRAM CECC counter fields of the first record dword */
+#define CECC_CH_POS		16
+#define CECC_SUB_CH_POS		20
+#define CECC_CHIP_SEL_POS	21
+#define CECC_RANK_MUL_POS	23
+/* Mailbox read mode in data_in[7] */
+#define MB_READ_MODE		1
+
+/* Queue slot, seq tells whether it is free or filled for a position */
+struct rt_slot {
+	uint64_t seq;
+	struct apml_rt_err err;
+};
+
+/*
+ * Bounded multi producer multi consumer queue. A producer claims the
+ * slot of the enqueue position when its seq equals the position and
+ * publishes it with seq = position + 1, a consumer frees it with
+ * seq = position + depth.
+ */
+struct apml_rt_queue {
+	uint32_t mask;
+	uint64_t head __attribute__((aligned(64)));
+	uint64_t tail __attribute__((aligned(64)));
+	uint64_t dropped __attribute__((aligned(64)));
+	struct rt_slot slots[];
+};
+
+/* Poller state of a socket */
+struct ras_poller {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t tid;
+	bool running;
+	uint8_t soc_num;
+	struct apml_ras_poll_opts opts;
+};
+
+static struct ras_poller pollers[APML_MAX_SOCKETS] = {
+	[0 ... APML_MAX_SOCKETS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+/* Last polled state and alert status of a socket */
+struct ras_state {
+	pthread_mutex_t lock;
+	uint32_t state;
+	struct apml_thread_mask alert;
+};
+
+static struct ras_state last_state[APML_MAX_SOCKETS] = {
+	[0 ... APML_MAX_SOCKETS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+static void read_msg_init(struct apml_message *msg, uint16_t reg)
+{
+	memset(msg, 0, sizeof(*msg));
+	/* Read/Write register command is 0x1002 */
+	msg->cmd = 0x1002;
+	msg->data_in.mb_in[0] = reg;
+	/* Assign 1 to the msg.data_in[7] for the read operation */
+	msg->data_in.reg_in[7] = 1;
+}
+
+static void mailbox_msg_init(struct apml_message *msg, uint32_t cmd,
+			     uint32_t input)
+{
+	memset(msg, 0, sizeof(*msg));
+	msg->cmd = cmd;
+	msg->data_in.mb_in[0] = input;
+	msg->data_in.mb_in[1] = (uint32_t)MB_READ_MODE << 24;
+}
+
+/*
+ * Read a batch of mailbox messages of one command, honouring the cached
+ * command support. Returns the messages completed in done.
+ */
+static oob_status_t mailbox_batch(uint8_t soc_num, uint32_t cmd,
+				  struct apml_message *msgs, uint32_t count,
+				  uint32_t *done)
+{
+	oob_status_t ret;
+
+	*done = 0;
+	if (apml_cap_get(soc_num, cmd) == APML_CAP_UNSUPPORTED)
+		return OOB_MAILBOX_CMD_UNKNOWN;
+
+	ret = sbrmi_xfer_msgs_partial(soc_num, msgs, count, done);
+	if (*done || ret >= OOB_MAILBOX_ERR_BASE)
+		apml_cap_record(soc_num, cmd, *done ? OOB_SUCCESS : ret);
+
+	return ret;
+}
+
+static bool mask_empty(const struct apml_thread_mask *mask)
+{
+	uint32_t i;
+
+	for (i = 0; i < APML_THREAD_MASK_WORDS; i++)
+		if (mask->bits[i])
+			return false;
+
+	return true;
+}
+
+oob_status_t apml_ras_poll(uint8_t soc_num, struct apml_ras_event *event,
+			   bool *changed)
+{
+	struct apml_message msgs[2];
+	struct ras_state *last;
+	oob_status_t ret;
+	uint32_t state;
+	bool same;
+
+	if (!event || !changed)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	*changed = false;
+	memset(event, 0, sizeof(*event));
+	read_msg_init(&msgs[0], SBRMI_RASSTATUS);
+	read_msg_init(&msgs[1], SBRMI_STATUS);
+	ret = sbrmi_xfer_msgs(soc_num, msgs, ARRAY_SIZE(msgs));
+	if (ret)
+		return ret;
+
+	clock_gettime(CLOCK_MONOTONIC, &event->ts);
+	event->ras_status = msgs[0].data_out.reg_out[0];
+	event->status = msgs[1].data_out.reg_out[0];
+	/* Sweep the per-thread alert status only on a pending alert */
+	if (event->status & STATUS_ALERT_STS) {
+		ret = sbrmi_get_thread_masks(soc_num, NULL, &event->alert,
+					     NULL);
+		if (ret)
+			return ret;
+	}
+
+	state = STATE_VALID | event->ras_status << 8 | event->status;
+	last = &last_state[soc_num];
+	pthread_mutex_lock(&last->lock);
+	same = last->state == state &&
+	       !memcmp(last->alert.bits, event->alert.bits,
+		       sizeof(last->alert.bits));
+	last->state = state;
+	last->alert = event->alert;
+	pthread_mutex_unlock(&last->lock);
+	if (same || (!event->ras_status && mask_empty(&event->alert)))
+		return OOB_SUCCESS;
+
+	/* Collection is needed, tell how much there is to dump */
+	*changed = true;
+	read_bmc_ras_mca_validity_check(soc_num, &event->bytes_per_mca,
+					&event->mca_banks);
+
+	return OOB_SUCCESS;
+}
+
+/* Check and dump the DF error logs into a buffer sized by the check */
+static oob_status_t collect_df(uint8_t soc_num, void **buf, uint32_t *len)
+{
+	struct apml_df_check *check;
+	oob_status_t ret;
+
+	*buf = NULL;
+	*len = 0;
+	check = malloc(sizeof(*check));
+	if (!check)
+		return OOB_NO_MEMORY;
+	ret = apml_ras_df_check(soc_num, check);
+	if (!ret && check->size) {
+		*buf = malloc(check->size);
+		ret = *buf ? apml_ras_dump_df_until(soc_num, check, *buf,
+						    check->size, len, NULL) :
+		      OOB_NO_MEMORY;
+	}
+	free(check);
+
+	return ret;
+}
+
+/* Run the collection chain of a RAS status change */
+static void ras_collect(struct ras_poller *rp,
+			const struct apml_ras_event *event,
+			struct apml_ras_collection *coll)
+{
+	uint32_t len;
+
+	memset(coll, 0, sizeof(*coll));
+
+	/* MCA banks first, a reset may follow a fatal error */
+	len = sizeof(struct apml_mca_dump) +
+	      (uint32_t)event->mca_banks * event->bytes_per_mca;
+	coll->mca = malloc(len);
+	coll->mca_ret = coll->mca ?
+			apml_ras_dump_mca(rp->soc_num, coll->mca, len,
+					  &coll->mca_len) : OOB_NO_MEMORY;
+
+	coll->df_ret = collect_df(rp->soc_num, &coll->df, &coll->df_len);
+
+	if (rp->opts.rt_queue)
+		coll->rt_ret = apml_ras_rt_harvest(rp->soc_num, false,
+						   rp->opts.rt_queue,
+						   &coll->rt_count);
+}
+
+/* Next period start after now, periods missed are skipped */
+static void next_period(struct timespec *next, uint32_t period_ms)
+{
+	int64_t period = (int64_t)period_ms * 1000000, late;
+	struct timespec now;
+
+	next->tv_nsec += period;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	late = (now.tv_sec - next->tv_sec) * NSEC_PER_SEC +
+	       now.tv_nsec - next->tv_nsec;
+	if (late >= 0)
+		next->tv_nsec += (late / period + 1) * period;
+	next->tv_sec += next->tv_nsec / NSEC_PER_SEC;
+	next->tv_nsec %= NSEC_PER_SEC;
+}
+
+static void *poller_thread(void *arg)
+{
+	struct ras_poller *rp = arg;
+	struct apml_ras_collection coll;
+	struct apml_ras_event event;
+	struct timespec next;
+	bool changed;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	pthread_mutex_lock(&rp->lock);
+	while (rp->running) {
+		pthread_mutex_unlock(&rp->lock);
+		if (!apml_ras_poll(rp->soc_num, &event, &changed) && changed) {
+			ras_collect(rp, &event, &coll);
+			if (rp->opts.cb)
+				rp->opts.cb(rp->soc_num, &event, &coll,
+					    rp->opts.data);
+			free(coll.mca);
+			free(coll.df);
+			/* RASStatus bits are write 1 to clear */
+			if (!rp->opts.no_clear && event.ras_status)
+				clear_sbrmi_ras_status(rp->soc_num,
+						       event.ras_status);
+		}
+		pthread_mutex_lock(&rp->lock);
+
+		next_period(&next, rp->opts.period_ms);
+		while (rp->running &&
+		       pthread_cond_timedwait(&rp->cond, &rp->lock, &next) !=
+		       ETIMEDOUT)
+			;
+	}
+	pthread_mutex_unlock(&rp->lock);
+
+	return NULL;
+}
+
+oob_status_t apml_ras_poll_start(uint8_t soc_num,
+				 const struct apml_ras_poll_opts *opts)
+{
+	pthread_condattr_t attr;
+	struct ras_poller *rp;
+
+	if (!opts)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	rp = &pollers[soc_num];
+	pthread_mutex_lock(&rp->lock);
+	if (rp->running) {
+		pthread_mutex_unlock(&rp->lock);
+		return OOB_TRY_AGAIN;
+	}
+	rp->soc_num = soc_num;
+	rp->opts = *opts;
+	if (!rp->opts.period_ms)
+		rp->opts.period_ms = DEFAULT_PERIOD_MS;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&rp->cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	rp->running = true;
+	if (pthread_create(&rp->tid, NULL, poller_thread, rp)) {
+		rp->running = false;
+		pthread_cond_destroy(&rp->cond);
+		pthread_mutex_unlock(&rp->lock);
+		return OOB_NO_MEMORY;
+	}
+	pthread_mutex_unlock(&rp->lock);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_ras_poll_stop(uint8_t soc_num)
+{
+	struct ras_poller *rp;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	rp = &pollers[soc_num];
+	pthread_mutex_lock(&rp->lock);
+	if (!rp->running) {
+		pthread_mutex_unlock(&rp->lock);
+		return OOB_NOT_INITIALIZED;
+	}
+	rp->running = false;
+	pthread_cond_signal(&rp->cond);
+	pthread_mutex_unlock(&rp->lock);
+
+	pthread_join(rp->tid, NULL);
+
+	pthread_mutex_lock(&rp->lock);
+	pthread_cond_destroy(&rp->cond);
+	pthread_mutex_unlock(&rp->lock);
+
+	return OOB_SUCCESS;
+}
+
+bool apml_deadline_expired(const struct timespec *deadline)
+{
+	struct timespec now;
+
+	if (!deadline)
+		return false;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec > deadline->tv_sec ||
+	       (now.tv_sec == deadline->tv_sec &&
+		now.tv_nsec >= deadline->tv_nsec);
+}
+
+oob_status_t apml_ras_dump_mca_until(uint8_t soc_num, void *buf,
+				     uint32_t len, uint32_t *written,
+				     const struct timespec *deadline)
+{
+	struct apml_mca_dump *dump = buf;
+	struct apml_message *msgs;
+	uint32_t dwords, banks, chunk, count, done, bank, i;
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (!buf || !written)
+		return OOB_ARG_PTR_NULL;
+	*written = 0;
+	if (len < sizeof(*dump))
+		return OOB_INVALID_INPUT;
+
+	memset(dump, 0, sizeof(*dump));
+	ret = read_bmc_ras_mca_validity_check(soc_num, &dump->bytes_per_mca,
+					      &dump->mca_banks);
+	if (ret)
+		return ret;
+	*written = sizeof(*dump);
+	if (!dump->mca_banks || !dump->bytes_per_mca)
+		return OOB_SUCCESS;
+	if (dump->bytes_per_mca % sizeof(uint32_t))
+		return OOB_UNEXPECTED_SIZE;
+
+	/* Banks fitting in the buffer */
+	dwords = dump->bytes_per_mca / sizeof(uint32_t);
+	banks = (len - sizeof(*dump)) / dump->bytes_per_mca;
+	if (banks > dump->mca_banks)
+		banks = dump->mca_banks;
+	if (!banks)
+		return OOB_NO_MEMORY;
+
+	/* One batch, or a few banks at a time to check the deadline */
+	chunk = deadline ? MCA_DEADLINE_BANKS : banks;
+	if (chunk > banks)
+		chunk = banks;
+	msgs = malloc(chunk * dwords * sizeof(*msgs));
+	if (!msgs)
+		return OOB_NO_MEMORY;
+
+	for (bank = 0; bank < banks; bank += chunk) {
+		if (apml_deadline_expired(deadline)) {
+			ret = OOB_CMD_TIMEOUT;
+			break;
+		}
+		if (chunk > banks - bank)
+			chunk = banks - bank;
+		count = chunk * dwords;
+		for (i = 0; i < count; i++)
+			mailbox_msg_init(&msgs[i], READ_BMC_RAS_MCA_MSR_DUMP,
+					 (bank + i / dwords) << 16 |
+					 (i % dwords) * 4);
+
+		ret = mailbox_batch(soc_num, READ_BMC_RAS_MCA_MSR_DUMP, msgs,
+				    count, &done);
+		/* Additional error data instead of a dword ends the dump */
+		for (i = 0; i < done; i++) {
+			if (msgs[i].fw_ret_code != FW_ADD_ERR_DATA)
+				continue;
+			dump->add_err = 1;
+			dump->add_err_data = msgs[i].data_out.mb_out[0];
+			ret = OOB_MAILBOX_ADD_ERR_DATA;
+			done = i;
+			break;
+		}
+		/* Keep the complete banks only */
+		done -= done % dwords;
+		for (i = 0; i < done; i++)
+			dump->data[bank * dwords + i] =
+				msgs[i].data_out.mb_out[0];
+		dump->banks_done += done / dwords;
+		*written += done * sizeof(uint32_t);
+		if (ret)
+			break;
+	}
+	free(msgs);
+
+	if (!ret && banks < dump->mca_banks)
+		ret = OOB_NO_MEMORY;
+
+	return ret;
+}
+
+oob_status_t apml_ras_dump_mca(uint8_t soc_num, void *buf, uint32_t len,
+			       uint32_t *written)
+{
+	return apml_ras_dump_mca_until(soc_num, buf, len, written, NULL);
+}
+
+/* Decode the validity check answer of a DF block */
+static void df_check_block(struct apml_df_check *check, uint32_t id,
+			   const struct apml_message *msg)
+{
+	uint32_t out = msg->data_out.mb_out[0];
+
+	if (msg->fw_ret_code == FW_ADD_ERR_DATA) {
+		/* Additional error data replaces the counts */
+		check->status[id] = OOB_MAILBOX_ADD_ERR_DATA;
+		check->add_err_data[id] = out;
+		check->size += sizeof(struct apml_df_log);
+		return;
+	}
+	/* Instances in bits 0 - 8, log bytes in 16 - 24 */
+	check->instances[id] = out & 0x1FF;
+	check->log_len[id] = (out >> 16) & 0x1FC;
+	check->size += check->instances[id] *
+		       (sizeof(struct apml_df_log) + check->log_len[id]);
+}
+
+oob_status_t apml_ras_df_check(uint8_t soc_num, struct apml_df_check *check)
+{
+	struct apml_message *msgs;
+	uint32_t id, done, i, answered = 0;
+	oob_status_t ret;
+
+	if (!check)
+		return OOB_ARG_PTR_NULL;
+
+	msgs = malloc(APML_DF_BLOCK_IDS * sizeof(*msgs));
+	if (!msgs)
+		return OOB_NO_MEMORY;
+	for (id = 0; id < APML_DF_BLOCK_IDS; id++)
+		mailbox_msg_init(&msgs[id], READ_RAS_LAST_TRANS_ADDR_CHK, id);
+
+	memset(check, 0, sizeof(*check));
+	for (id = 0; id < APML_DF_BLOCK_IDS; ) {
+		ret = mailbox_batch(soc_num, READ_RAS_LAST_TRANS_ADDR_CHK,
+				    &msgs[id], APML_DF_BLOCK_IDS - id, &done);
+		for (i = id; i < id + done; i++)
+			df_check_block(check, i, &msgs[i]);
+		answered += done;
+		id += done;
+		if (!ret)
+			break;
+		/* Only a block ID rejected by the firmware is skipped */
+		if (ret == OOB_MAILBOX_CMD_UNKNOWN ||
+		    ret <= OOB_MAILBOX_ERR_START || ret > OOB_MAILBOX_ERR_END)
+			break;
+		check->status[id++] = ret;
+		ret = OOB_SUCCESS;
+	}
+	free(msgs);
+
+	/* Every block rejected, report why */
+	if (!ret && !answered)
+		for (id = 0; id < APML_DF_BLOCK_IDS && !ret; id++)
+			ret = check->status[id];
+
+	return ret;
+}
+
+oob_status_t apml_ras_dump_df_until(uint8_t soc_num,
+				    const struct apml_df_check *check,
+				    void *buf, uint32_t len, uint32_t *written,
+				    const struct timespec *deadline)
+{
+	struct apml_message *msgs, *msg;
+	union ras_df_err_dump df_err;
+	struct apml_df_log *log;
+	uint32_t id, inst, dwords, count, done, n, i, max = 0;
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (!check || !buf || !written)
+		return OOB_ARG_PTR_NULL;
+	*written = 0;
+
+	for (id = 0; id < APML_DF_BLOCK_IDS; id++)
+		if (check->instances[id] * check->log_len[id] > max)
+			max = check->instances[id] * check->log_len[id];
+	msgs = malloc((max ? max / sizeof(uint32_t) : 1) * sizeof(*msgs));
+	if (!msgs)
+		return OOB_NO_MEMORY;
+
+	for (id = 0; id < APML_DF_BLOCK_IDS; id++) {
+		if (check->status[id] == OOB_MAILBOX_ADD_ERR_DATA) {
+			if (len - *written < sizeof(*log)) {
+				ret = OOB_NO_MEMORY;
+				break;
+			}
+			log = (struct apml_df_log *)((uint8_t *)buf + *written);
+			memset(log, 0, sizeof(*log));
+			log->block_id = id;
+			log->add_err = 1;
+			log->add_err_data = check->add_err_data[id];
+			*written += sizeof(*log);
+			continue;
+		}
+		if (!check->instances[id] || !check->log_len[id])
+			continue;
+		if (apml_deadline_expired(deadline)) {
+			ret = OOB_CMD_TIMEOUT;
+			break;
+		}
+
+		/* Every dword of every instance of the block in one batch */
+		dwords = check->log_len[id] / sizeof(uint32_t);
+		count = check->instances[id] * dwords;
+		for (i = 0; i < count; i++) {
+			df_err.input[0] = (i % dwords) * 4;
+			df_err.input[1] = id;
+			df_err.input[2] = i / dwords;
+			df_err.input[3] = 0;
+			mailbox_msg_init(&msgs[i],
+					 READ_RAS_LAST_TRANS_ADDR_DUMP,
+					 df_err.data_in);
+		}
+		ret = mailbox_batch(soc_num, READ_RAS_LAST_TRANS_ADDR_DUMP,
+				    msgs, count, &done);
+
+		/* Assemble the logs read, the last one may be partial */
+		for (inst = 0; inst * dwords < done; inst++) {
+			n = done - inst * dwords;
+			if (n > dwords)
+				n = dwords;
+			if (len - *written <
+			    sizeof(*log) + n * sizeof(uint32_t)) {
+				ret = OOB_NO_MEMORY;
+				break;
+			}
+			log = (struct apml_df_log *)((uint8_t *)buf + *written);
+			memset(log, 0, sizeof(*log));
+			log->block_id = id;
+			log->instance = inst;
+			msg = &msgs[inst * dwords];
+			for (i = 0; i < n; i++) {
+				/* Additional error data ends the log */
+				if (msg[i].fw_ret_code == FW_ADD_ERR_DATA) {
+					log->add_err = 1;
+					log->add_err_data =
+						msg[i].data_out.mb_out[0];
+					break;
+				}
+				log->data[i] = msg[i].data_out.mb_out[0];
+			}
+			log->len = i * sizeof(uint32_t);
+			*written += sizeof(*log) + log->len;
+		}
+		if (ret)
+			break;
+	}
+	free(msgs);
+
+	return ret;
+}
+
+oob_status_t apml_ras_dump_df(uint8_t soc_num, void *buf, uint32_t len,
+			      uint32_t *written)
+{
+	struct apml_df_check *check;
+	oob_status_t ret;
+
+	if (!buf || !written)
+		return OOB_ARG_PTR_NULL;
+	*written = 0;
+
+	check = malloc(sizeof(*check));
+	if (!check)
+		return OOB_NO_MEMORY;
+	ret = apml_ras_df_check(soc_num, check);
+	if (!ret)
+		ret = apml_ras_dump_df_until(soc_num, check, buf, len,
+					     written, NULL);
+	free(check);
+
+	return ret;
+}
+
+oob_status_t apml_rt_queue_create(uint32_t depth,
+				  struct apml_rt_queue **queue)
+{
+	struct apml_rt_queue *q;
+	uint32_t i;
+
+	if (!queue)
+		return OOB_ARG_PTR_NULL;
+	if (!depth || depth > RT_QUEUE_MAX_DEPTH)
+		return OOB_INVALID_INPUT;
+
+	while (depth & (depth - 1))
+		depth = (depth | (depth - 1)) + 1;
+	if (posix_memalign((void **)&q, 64,
+			   sizeof(*q) + depth * sizeof(q->slots[0])))
+		return OOB_NO_MEMORY;
+
+	q->mask = depth - 1;
+	q->head = 0;
+	q->tail = 0;
+	q->dropped = 0;
+	for (i = 0; i < depth; i++)
+		q->slots[i].seq = i;
+	*queue = q;
+
+	return OOB_SUCCESS;
+}
+
+void apml_rt_queue_destroy(struct apml_rt_queue *queue)
+{
+	free(queue);
+}
+
+bool apml_rt_queue_push(struct apml_rt_queue *queue,
+			const struct apml_rt_err *err)
+{
+	struct rt_slot *slot;
+	uint64_t pos, seq;
+
+	pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+	for (;;) {
+		slot = &queue->slots[pos & queue->mask];
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq == pos) {
+			if (__atomic_compare_exchange_n(&queue->head, &pos,
+							pos + 1, true,
+							__ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if ((int64_t)(seq - pos) < 0) {
+			/* Slot still holds a record one lap behind */
+			__atomic_fetch_add(&queue->dropped, 1,
+					   __ATOMIC_RELAXED);
+			return false;
+		} else {
+			pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+		}
+	}
+	slot->err = *err;
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+bool apml_rt_queue_pop(struct apml_rt_queue *queue, struct apml_rt_err *err)
+{
+	struct rt_slot *slot;
+	uint64_t pos, seq;
+
+	pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+	for (;;) {
+		slot = &queue->slots[pos & queue->mask];
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq == pos + 1) {
+			if (__atomic_compare_exchange_n(&queue->tail, &pos,
+							pos + 1, true,
+							__ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if ((int64_t)(seq - (pos + 1)) < 0) {
+			/* Not published yet */
+			return false;
+		} else {
+			pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+		}
+	}
+	*err = slot->err;
+	__atomic_store_n(&slot->seq, pos + queue->mask + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+uint64_t apml_rt_queue_dropped(struct apml_rt_queue *queue)
+{
+	return __atomic_load_n(&queue->dropped, __ATOMIC_RELAXED);
+}
+
+static void decode_cecc(struct apml_rt_err *err)
+{
+	uint32_t d_out = err->data[0];
+
+	err->cecc.err_count = d_out & TWO_BYTE_MASK;
+	err->cecc.channel = (d_out >> CECC_CH_POS) & NIBBLE_MASK;
+	err->cecc.sub_channel = (d_out >> CECC_SUB_CH_POS) & 1;
+	err->cecc.chip_select = (d_out >> CECC_CHIP_SEL_POS) & 0x3;
+	err->cecc.rank_mult = (d_out >> CECC_RANK_MUL_POS) & 0x7;
+}
+
+oob_status_t apml_ras_rt_harvest(uint8_t soc_num, bool interrupt_mode,
+				 struct apml_rt_queue *queue,
+				 uint32_t *count)
+{
+	struct apml_message chk[APML_RT_ERR_CATEGORIES];
+	struct apml_message *msgs = NULL, *msg, *tmp;
+	uint32_t cat, inst, insts, dwords, keep, total, done, max = 0, i;
+	struct apml_rt_err err;
+	oob_status_t ret;
+
+	if (!queue)
+		return OOB_ARG_PTR_NULL;
+	if (count)
+		*count = 0;
+
+	/* Validity of every category in one batch */
+	for (cat = 0; cat < APML_RT_ERR_CATEGORIES; cat++)
+		mailbox_msg_init(&chk[cat],
+				 GET_BMC_RAS_RUNTIME_ERR_VALIDITY_CHECK,
+				 cat | (uint32_t)interrupt_mode << 31);
+	ret = mailbox_batch(soc_num, GET_BMC_RAS_RUNTIME_ERR_VALIDITY_CHECK,
+			    chk, APML_RT_ERR_CATEGORIES, &done);
+	if (ret)
+		return ret;
+
+	for (cat = 0; cat < APML_RT_ERR_CATEGORIES; cat++) {
+		/* Instances in bits 0 - 15, bytes per instance in 16 - 31 */
+		insts = chk[cat].data_out.mb_out[0] & TWO_BYTE_MASK;
+		dwords = (chk[cat].data_out.mb_out[0] >> 16) / 4;
+		if (!insts || !dwords)
+			continue;
+		keep = dwords < ARRAY_SIZE(err.data) ? dwords :
+		       ARRAY_SIZE(err.data);
+
+		/* Every kept dword of every instance in one batch */
+		total = insts * keep;
+		if (total > max) {
+			tmp = realloc(msgs, total * sizeof(*msgs));
+			if (!tmp) {
+				ret = OOB_NO_MEMORY;
+				break;
+			}
+			msgs = tmp;
+			max = total;
+		}
+		for (i = 0; i < total; i++)
+			mailbox_msg_init(&msgs[i], GET_BMC_RAS_RUNTIME_ERR_INFO,
+					 (i / keep) << 16 | cat << 8 |
+					 (i % keep) * 4);
+		ret = mailbox_batch(soc_num, GET_BMC_RAS_RUNTIME_ERR_INFO,
+				    msgs, total, &done);
+
+		/* Push the complete records */
+		for (inst = 0; (inst + 1) * keep <= done; inst++) {
+			memset(&err, 0, sizeof(err));
+			clock_gettime(CLOCK_MONOTONIC, &err.ts);
+			err.soc_num = soc_num;
+			err.category = cat;
+			err.instance = inst;
+			err.len = keep * 4;
+			err.truncated = keep < dwords;
+			msg = &msgs[inst * keep];
+			for (i = 0; i < keep; i++)
+				err.data[i] = msg[i].data_out.mb_out[0];
+			if (cat == APML_RT_ERR_DRAM_CECC)
+				decode_cecc(&err);
+			if (apml_rt_queue_push(queue, &err) && count)
+				(*count)++;
+		}
+		if (ret)
+			break;
+	}
+	free(msgs);
+
+	return ret;
+}
@@ -0,0 +1,337 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <esmi_oob/apml.h>
+#include <esmi_oob/apml_sampler.h>
+#include <esmi_oob/esmi_tsi.h>
+
+/* Default and max ring buffer depth in samples */
+#define DEFAULT_DEPTH		1024
+#define MAX_DEPTH		(1 << 20)
+/* Nano seconds in a second */
+#define NSEC_PER_SEC		1000000000LL
+/* Probes per update period while locking on the update phase */
+#define LOCK_PROBES		8
+/* Update periods to watch for a temperature change */
+#define LOCK_PERIODS		2
+
+/* Sampler state of a socket */
+struct sampler {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t tid;
+	bool running;
+	uint8_t soc_num;
+	int64_t period_ns;
+	struct apml_temp_sample *ring;
+	uint32_t mask;
+	uint64_t head;		/* samples written */
+	uint64_t tail;		/* samples read */
+};
+
+static struct sampler samplers[APML_MAX_SOCKETS] = {
+	[0 ... APML_MAX_SOCKETS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+static int64_t ts_to_ns(const struct timespec *ts)
+{
+	return ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static struct timespec ns_to_ts(int64_t ns)
+{
+	struct timespec ts;
+
+	ts.tv_sec = ns / NSEC_PER_SEC;
+	ts.tv_nsec = ns % NSEC_PER_SEC;
+
+	return ts;
+}
+
+static int64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts_to_ns(&ts);
+}
+
+/*
+ * Wait until the absolute time, called with the lock held.
+ * Returns false when the sampler is stopped.
+ */
+static bool wait_until(struct sampler *sp, int64_t deadline)
+{
+	struct timespec ts = ns_to_ts(deadline);
+
+	while (sp->running) {
+		if (pthread_cond_timedwait(&sp->cond, &sp->lock, &ts) ==
+		    ETIMEDOUT)
+			break;
+	}
+
+	return sp->running;
+}
+
+static void push_sample(struct sampler *sp, float temp, int64_t ts)
+{
+	struct apml_temp_sample *smp = &sp->ring[sp->head & sp->mask];
+
+	smp->ts = ns_to_ts(ts);
+	smp->seq = sp->head;
+	smp->temp = temp;
+	sp->head++;
+	/* Full, drop the oldest sample */
+	if (sp->head - sp->tail > sp->mask + 1)
+		sp->tail = sp->head - (sp->mask + 1);
+}
+
+/*
+ * Find the sensor update phase by probing faster than the update rate
+ * until the temperature changes. Returns the time of the first read
+ * after the change, or the current time if the temperature was steady.
+ */
+static int64_t lock_phase(struct sampler *sp)
+{
+	int64_t step = sp->period_ns / LOCK_PROBES;
+	int64_t next = now_ns();
+	float first, temp;
+	int probe;
+
+	if (sbtsi_get_cputemp(sp->soc_num, &first))
+		return next;
+	for (probe = 0; probe < LOCK_PROBES * LOCK_PERIODS; probe++) {
+		next += step;
+		if (!wait_until(sp, next))
+			break;
+		pthread_mutex_unlock(&sp->lock);
+		if (sbtsi_get_cputemp(sp->soc_num, &temp))
+			temp = first;
+		pthread_mutex_lock(&sp->lock);
+		if (temp != first)
+			return next;
+	}
+
+	return now_ns();
+}
+
+static void *sampler_thread(void *arg)
+{
+	struct sampler *sp = arg;
+	oob_status_t ret;
+	int64_t next, now;
+	float temp;
+
+	pthread_mutex_lock(&sp->lock);
+	/* One probe step after the update edge leaves margin for jitter */
+	next = lock_phase(sp) + sp->period_ns + sp->period_ns / LOCK_PROBES;
+	while (wait_until(sp, next)) {
+		pthread_mutex_unlock(&sp->lock);
+		ret = sbtsi_get_cputemp(sp->soc_num, &temp);
+		now = now_ns();
+		pthread_mutex_lock(&sp->lock);
+		if (!ret)
+			push_sample(sp, temp, now);
+
+		/* Skip the updates missed while the bus was busy */
+		next += sp->period_ns;
+		while (next <= now)
+			next += sp->period_ns;
+	}
+	pthread_mutex_unlock(&sp->lock);
+
+	return NULL;
+}
+
+oob_status_t apml_sampler_start(uint8_t soc_num,
+				const struct apml_sampler_opts *opts)
+{
+	struct apml_sampler_opts def = {0};
+	pthread_condattr_t attr;
+	struct sampler *sp;
+	oob_status_t ret;
+	uint32_t depth;
+	float rate;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+	if (!opts)
+		opts = &def;
+
+	if (opts->update_rate) {
+		ret = write_sbtsi_updaterate(soc_num, opts->update_rate);
+		if (ret)
+			return ret;
+	}
+	ret = read_sbtsi_updaterate(soc_num, &rate);
+	if (ret)
+		return ret;
+	/* Also rejects NaN, the period must be a positive integer */
+	if (!(rate > 0 && rate <= NSEC_PER_SEC))
+		return OOB_INVALID_INPUT;
+
+	/* Power of 2 depth for the index mask */
+	depth = opts->depth ? opts->depth : DEFAULT_DEPTH;
+	if (depth > MAX_DEPTH)
+		depth = MAX_DEPTH;
+	while (depth & (depth - 1))
+		depth = (depth | (depth - 1)) + 1;
+
+	sp = &samplers[soc_num];
+	pthread_mutex_lock(&sp->lock);
+	if (sp->running) {
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_TRY_AGAIN;
+	}
+	sp->ring = calloc(depth, sizeof(*sp->ring));
+	if (!sp->ring) {
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_NO_MEMORY;
+	}
+	sp->mask = depth - 1;
+	sp->head = 0;
+	sp->tail = 0;
+	sp->soc_num = soc_num;
+	sp->period_ns = NSEC_PER_SEC / rate;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sp->cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	sp->running = true;
+	if (pthread_create(&sp->tid, NULL, sampler_thread, sp)) {
+		sp->running = false;
+		pthread_cond_destroy(&sp->cond);
+		free(sp->ring);
+		sp->ring = NULL;
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_NO_MEMORY;
+	}
+	pthread_mutex_unlock(&sp->lock);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_sampler_stop(uint8_t soc_num)
+{
+	struct sampler *sp;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	sp = &samplers[soc_num];
+	pthread_mutex_lock(&sp->lock);
+	if (!sp->running) {
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_NOT_INITIALIZED;
+	}
+	sp->running = false;
+	pthread_cond_signal(&sp->cond);
+	pthread_mutex_unlock(&sp->lock);
+
+	pthread_join(sp->tid, NULL);
+
+	pthread_mutex_lock(&sp->lock);
+	pthread_cond_destroy(&sp->cond);
+	free(sp->ring);
+	sp->ring = NULL;
+	pthread_mutex_unlock(&sp->lock);
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_sampler_read(uint8_t soc_num,
+			       struct apml_temp_sample *samples,
+			       uint32_t max, uint32_t *count)
+{
+	struct sampler *sp;
+	uint32_t n = 0;
+
+	if (!samples || !count)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	sp = &samplers[soc_num];
+	pthread_mutex_lock(&sp->lock);
+	if (!sp->running) {
+		pthread_mutex_unlock(&sp->lock);
+		return OOB_NOT_INITIALIZED;
+	}
+	while (n < max && sp->tail < sp->head) {
+		samples[n++] = sp->ring[sp->tail & sp->mask];
+		sp->tail++;
+	}
+	pthread_mutex_unlock(&sp->lock);
+	*count = n;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_sampler_period(uint8_t soc_num, uint64_t *period_us)
+{
+	struct sampler *sp;
+	oob_status_t ret = OOB_SUCCESS;
+
+	if (!period_us)
+		return OOB_ARG_PTR_NULL;
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+
+	sp = &samplers[soc_num];
+	pthread_mutex_lock(&sp->lock);
+	if (sp->running)
+		*period_us = sp->period_ns / 1000;
+	else
+		ret = OOB_NOT_INITIALIZED;
+	pthread_mutex_unlock(&sp->lock);
+
+	return ret;
+}
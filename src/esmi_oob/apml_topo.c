@@ -0,0 +1,288 @@
+/*
+ * University of Illinois/NCSA Open Source License
+ *
+ * Copyright (c) 2024, Advanced Micro Devices, Inc.
+ * All rights reserved.
+ *
+ * Developed by:
+ *
+ *		AMD Research and AMD Software Development
+ *
+ *		Advanced Micro Devices, Inc.
+ *
+ *		www.amd.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal with the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimers.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimers in
+ *    the documentation and/or other materials provided with the distribution.
+ *  - Neither the names of <Name of Development Group, Name of Institution>,
+ *    nor the names of its contributors may be used to endorse or promote
+ *    products derived from this Software without specific prior written
+ *    permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS WITH THE SOFTWARE.
+ *
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esmi_oob/apml_topo.h>
+#include <esmi_oob/esmi_cpuid_msr.h>
+#include <esmi_oob/esmi_rmi.h>
+
+/* CPUID 0x80000026 level types */
+#define LEVEL_CORE		1
+#define LEVEL_COMPLEX		2
+#define LEVEL_DIE		3
+/* CPUID 0x80000026 levels read */
+#define EXT_TOPO_LEVELS		4
+
+/* APIC ID shifts of the hierarchy levels */
+struct topo_shift {
+	uint8_t smt;
+	uint8_t ccx;
+	uint8_t ccd;
+	bool ccd_from_cpuid;
+	uint8_t threads_per_core;
+};
+
+/* Bits needed to count n */
+static uint8_t order_base_2(uint32_t n)
+{
+	uint8_t bits = 0;
+
+	while ((1U << bits) < n)
+		bits++;
+
+	return bits;
+}
+
+/* Read the APIC ID layout on one thread */
+static oob_status_t read_shifts(uint8_t soc_num, uint32_t thread,
+				struct topo_shift *shift)
+{
+	struct esmi_cpuid_leaf leaf[3] = {
+		{ .fn_eax = 0xB, .fn_ecx = 0 },
+		{ .fn_eax = 0x8000001D, .fn_ecx = 3 },
+		{ .fn_eax = 0x80000000 },
+	};
+	struct esmi_cpuid_leaf ext[EXT_TOPO_LEVELS];
+	oob_status_t ret;
+	uint32_t i;
+
+	ret = esmi_oob_cpuid_multi(soc_num, thread, leaf, 3);
+	if (ret)
+		return ret;
+	/* SMT level: shift to the core ID, logical processors per core */
+	shift->smt = leaf[0].eax & 0x1F;
+	shift->threads_per_core = leaf[0].ebx & 0xFFFF;
+	/* L3: NumSharingCache[25:14] + 1 threads share the CCX cache */
+	shift->ccx = order_base_2(((leaf[1].eax >> 14) & 0xFFF) + 1);
+	shift->ccd = shift->ccx;
+	shift->ccd_from_cpuid = false;
+	if (leaf[2].eax < 0x80000026)
+		return OOB_SUCCESS;
+
+	memset(ext, 0, sizeof(ext));
+	for (i = 0; i < EXT_TOPO_LEVELS; i++) {
+		ext[i].fn_eax = 0x80000026;
+		ext[i].fn_ecx = i;
+	}
+	ret = esmi_oob_cpuid_multi(soc_num, thread, ext, EXT_TOPO_LEVELS);
+	if (ret)
+		return ret;
+	/* The shift of a level gives the ID of that level */
+	for (i = 0; i < EXT_TOPO_LEVELS; i++) {
+		switch ((ext[i].ecx >> 8) & 0xFF) {
+		case LEVEL_CORE:
+			shift->smt = ext[i].eax & 0x1F;
+			break;
+		case LEVEL_COMPLEX:
+			shift->ccx = ext[i].eax & 0x1F;
+			break;
+		case LEVEL_DIE:
+			shift->ccd = ext[i].eax & 0x1F;
+			shift->ccd_from_cpuid = true;
+			break;
+		}
+	}
+
+	return OOB_SUCCESS;
+}
+
+/* Insertion sort of the thread indexes by x2APIC ID, few hundred entries */
+static void sort_by_apic(uint16_t *order, uint32_t count,
+			 const struct apml_topo_thread *thread)
+{
+	uint32_t i, j;
+	uint16_t t;
+
+	for (i = 1; i < count; i++) {
+		t = order[i];
+		for (j = i; j && thread[order[j - 1]].apic_id >
+				 thread[t].apic_id; j--)
+			order[j] = order[j - 1];
+		order[j] = t;
+	}
+}
+
+/* Assign dense indexes walking the threads in x2APIC ID order */
+static oob_status_t link_threads(struct apml_topo *topo,
+				 const struct topo_shift *shift,
+				 const uint16_t *order, uint32_t count)
+{
+	uint32_t apic, prev = 0, i;
+	struct apml_topo_thread *t;
+	struct apml_topo_core *core = NULL;
+	struct apml_topo_ccx *ccx = NULL;
+	struct apml_topo_ccd *ccd = NULL;
+
+	for (i = 0; i < count; i++) {
+		t = &topo->thread[order[i]];
+		apic = t->apic_id;
+		if (!ccd || apic >> shift->ccd != prev >> shift->ccd) {
+			if (topo->ccds == APML_TOPO_MAX_CCD)
+				return OOB_NOT_SUPPORTED;
+			ccd = &topo->ccd[topo->ccds++];
+			ccd->first_ccx = topo->ccxs;
+			ccx = NULL;
+		}
+		if (!ccx || apic >> shift->ccx != prev >> shift->ccx) {
+			if (topo->ccxs == APML_TOPO_MAX_CCX)
+				return OOB_NOT_SUPPORTED;
+			ccx = &topo->ccx[topo->ccxs++];
+			ccx->first_core = topo->cores;
+			ccx->ccd = topo->ccds - 1;
+			ccd->ccxs++;
+			core = NULL;
+		}
+		if (!core || apic >> shift->smt != prev >> shift->smt) {
+			core = &topo->core[topo->cores++];
+			core->thread[0] = APML_TOPO_NONE;
+			core->thread[1] = APML_TOPO_NONE;
+			core->ccx = topo->ccxs - 1;
+			ccx->cores++;
+		}
+		if (core->threads == APML_TOPO_MAX_SMT)
+			return OOB_NOT_SUPPORTED;
+
+		t->ccd = topo->ccds - 1;
+		t->ccx = topo->ccxs - 1;
+		t->ccx_in_ccd = t->ccx - ccd->first_ccx;
+		t->core = topo->cores - 1;
+		t->core_in_ccx = t->core - ccx->first_core;
+		t->smt = core->threads;
+		core->thread[core->threads++] = order[i];
+		prev = apic;
+	}
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t apml_topo_build(uint8_t soc_num, struct apml_topo *topo)
+{
+	struct apml_thread_mask enabled;
+	struct topo_shift shift;
+	uint16_t *order;
+	uint32_t count = 0;
+	oob_status_t ret;
+	int thread;
+
+	if (!topo)
+		return OOB_ARG_PTR_NULL;
+
+	ret = sbrmi_get_thread_masks(soc_num, &enabled, NULL, NULL);
+	if (ret)
+		return ret;
+	thread = apml_thread_mask_next(&enabled, -1);
+	if (thread < 0)
+		return OOB_NOT_SUPPORTED;
+	ret = read_shifts(soc_num, thread, &shift);
+	if (ret)
+		return ret;
+
+	memset(topo, 0, sizeof(*topo));
+	topo->threads_per_core = shift.threads_per_core;
+	topo->ccd_from_cpuid = shift.ccd_from_cpuid;
+	order = malloc(APML_TOPO_MAX_THREADS * sizeof(*order));
+	if (!order)
+		return OOB_NO_MEMORY;
+
+	/* The layout is known, one ecx/edx transaction per thread */
+	apml_for_each_thread(thread, &enabled) {
+		ret = esmi_oob_cpuid_edx(soc_num, thread, 0xB, 0,
+					 &topo->thread[thread].apic_id);
+		if (ret)
+			goto out;
+		topo->thread[thread].enabled = 1;
+		order[count++] = thread;
+	}
+	topo->threads = count;
+
+	sort_by_apic(order, count, topo->thread);
+	ret = link_threads(topo, &shift, order, count);
+
+out:
+	free(order);
+
+	return ret;
+}
+
+uint16_t apml_topo_thread_at(const struct apml_topo *topo, uint8_t ccd,
+			     uint8_t ccx, uint8_t core, uint8_t smt)
+{
+	const struct apml_topo_ccx *x;
+	uint32_t c;
+
+	if (!topo || ccd >= topo->ccds || ccx >= topo->ccd[ccd].ccxs ||
+	    smt >= APML_TOPO_MAX_SMT)
+		return APML_TOPO_NONE;
+
+	x = &topo->ccx[topo->ccd[ccd].first_ccx + ccx];
+	if (core >= x->cores)
+		return APML_TOPO_NONE;
+	c = x->first_core + core;
+
+	return topo->core[c].thread[smt];
+}
+
+oob_status_t apml_topo_ccx_threads(const struct apml_topo *topo, uint8_t ccx,
+				   struct apml_thread_mask *mask)
+{
+	const struct apml_topo_core *core;
+	uint32_t c, s, t;
+
+	if (!topo || !mask)
+		return OOB_ARG_PTR_NULL;
+	if (ccx >= topo->ccxs)
+		return OOB_INVALID_INPUT;
+
+	memset(mask, 0, sizeof(*mask));
+	mask->nbits = APML_TOPO_MAX_THREADS;
+	for (c = 0; c < topo->ccx[ccx].cores; c++) {
+		core = &topo->core[topo->ccx[ccx].first_core + c];
+		for (s = 0; s < core->threads; s++) {
+			t = core->thread[s];
+			mask->bits[t / 64] |= 1ULL << (t % 64);
+		}
+	}
+
+	return OOB_SUCCESS;
+}
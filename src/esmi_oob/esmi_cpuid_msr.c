@@ -42,10 +42,12 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <esmi_oob/esmi_cpuid_msr.h>
 #include <esmi_oob/apml.h>
+#include <esmi_oob/apml_init.h>
 #include <esmi_oob/esmi_rmi.h>
 
 /* Default message lengths as per APML command protocol */
@@ -69,6 +71,10 @@
 #define LEGACY_PLAT_THREADS_PER_SOC 128
 /* CPUID function for max threads per l3 */
 #define THREADS_L3_FUNC         0x8000001D
+/* MSR reads submitted per batch */
+#define MSR_MULTI_BATCH		64
+/* CPUID transactions submitted per batch, two per leaf */
+#define CPUID_MULTI_BATCH	64
 
 static oob_status_t esmi_convert_reg_val(uint32_t reg, char *id)
 {
@@ -138,7 +144,7 @@ static oob_status_t esmi_reg_offset_conv(uint32_t reg, uint32_t offset,
 oob_status_t esmi_get_processor_info(uint8_t soc_num,
 				     struct processor_info *proc_info)
 {
-
+	struct apml_inventory inv;
 	oob_status_t ret;
 	uint32_t eax = 1, ebx, ecx = 0, edx;
 	uint32_t core_id = 0;
@@ -146,6 +152,12 @@ oob_status_t esmi_get_processor_info(uint8_t soc_num,
 	if (!proc_info)
 		return OOB_ARG_PTR_NULL;
 
+	/* Family and model never change, use the socket inventory if any */
+	if (!apml_get_inventory(soc_num, &inv) && inv.proc.family) {
+		*proc_info = inv.proc;
+		return OOB_SUCCESS;
+	}
+
 	ret = esmi_oob_cpuid(soc_num, core_id,
 			     &eax, &ebx, &ecx, &edx);
 	if (ret != 0)
@@ -234,10 +246,21 @@ static oob_status_t esmi_oob_extend_thread(uint8_t soc_num, uint32_t *thread)
 
 static oob_status_t validate_thread(uint8_t soc_num, uint32_t thread_num)
 {
+	struct apml_inventory inv;
 	uint32_t max_threads_per_soc = 0;
 	uint8_t rev = 0;
 	oob_status_t ret;
 
+	/*
+	 * Use the socket inventory when the library is initialized and
+	 * discovery found the thread count, else read it live
+	 */
+	if (!apml_get_inventory(soc_num, &inv) && inv.threads_per_socket) {
+		if (thread_num > (inv.threads_per_socket - 1))
+			return OOB_CPUID_MSR_CMD_INVAL_THREAD;
+		return OOB_SUCCESS;
+	}
+
 	ret = read_sbrmi_revision(soc_num, &rev);
 	if (ret)
 		return ret;
@@ -290,56 +313,189 @@ oob_status_t esmi_oob_read_msr(uint8_t soc_num,
 	return OOB_SUCCESS;
 }
 
-oob_status_t esmi_oob_cpuid(uint8_t soc_num, uint32_t thread,
-			    uint32_t *eax, uint32_t *ebx,
-			    uint32_t *ecx, uint32_t *edx)
+/* Submit a batch of MSR reads, idx[k] is the out index of message k */
+static oob_status_t msr_multi_flush(uint8_t soc_num,
+				    struct apml_message *msgs,
+				    const uint32_t *idx, uint32_t count,
+				    uint32_t n_msr, uint64_t *out,
+				    struct apml_thread_mask *read)
 {
-	uint32_t fn_eax, fn_ecx;
+	uint32_t done = 0, k, thread;
 	oob_status_t ret;
 
-	fn_eax = *eax;
-	fn_ecx = *ecx;
+	ret = sbrmi_xfer_msgs_partial(soc_num, msgs, count, &done);
+	for (k = 0; k < done; k++) {
+		out[idx[k]] = msgs[k].data_out.cpu_msr_out;
+		/* A thread is read once its last MSR is */
+		if (idx[k] % n_msr == n_msr - 1) {
+			thread = idx[k] / n_msr;
+			read->bits[thread / 64] |= 1ULL << (thread % 64);
+		}
+	}
 
-	/* validate thread */
-	ret = validate_thread(soc_num, thread);
+	return ret;
+}
+
+oob_status_t esmi_oob_read_msr_multi(uint8_t soc_num, const uint32_t *msrs,
+				     uint32_t n_msr,
+				     struct apml_thread_mask *thread_mask,
+				     uint64_t *out)
+{
+	struct apml_message msgs[MSR_MULTI_BATCH], *msg;
+	struct apml_thread_mask enabled, read = {0};
+	uint32_t idx[MSR_MULTI_BATCH];
+	uint32_t count = 0, i;
+	int thread, last = -1;
+	oob_status_t ret;
+
+	if (!msrs || !thread_mask || !out)
+		return OOB_ARG_PTR_NULL;
+	if (!n_msr)
+		return OOB_INVALID_INPUT;
+
+	apml_for_each_thread(thread, thread_mask)
+		last = thread;
+	if (last < 0)
+		return OOB_SUCCESS;
+
+	/* Validate the highest thread once instead of per read */
+	ret = validate_thread(soc_num, last);
 	if (ret)
 		return ret;
-
-	ret = esmi_oob_cpuid_eax(soc_num, thread, fn_eax, fn_ecx, eax);
+	ret = sbrmi_get_thread_masks(soc_num, &enabled, NULL, NULL);
 	if (ret)
 		return ret;
+	for (i = 0; i < APML_THREAD_MASK_WORDS; i++)
+		thread_mask->bits[i] &= enabled.bits[i];
+	read.nbits = thread_mask->nbits;
+
+	/* Thread major order, Thread128CS flips at most once */
+	apml_for_each_thread(thread, thread_mask) {
+		for (i = 0; i < n_msr; i++) {
+			msg = &msgs[count];
+			memset(msg, 0, sizeof(*msg));
+			/* cmd for MCAMSR is 0x1001 */
+			msg->cmd = 0x1001;
+			msg->data_in.cpu_msr_in = msrs[i] |
+						  ((uint64_t)thread << 32);
+			/* Assign 7 byte to READ Mode */
+			msg->data_in.reg_in[7] = 1;
+			idx[count++] = thread * n_msr + i;
+			if (count < MSR_MULTI_BATCH)
+				continue;
+			ret = msr_multi_flush(soc_num, msgs, idx, count,
+					      n_msr, out, &read);
+			if (ret)
+				goto out;
+			count = 0;
+		}
+	}
+	if (count)
+		ret = msr_multi_flush(soc_num, msgs, idx, count, n_msr, out,
+				      &read);
+
+out:
+	*thread_mask = read;
+
+	return ret;
+}
 
-	ret = esmi_oob_cpuid_ebx(soc_num, thread, fn_eax, fn_ecx, ebx);
+/* Fill a CPUID message, read_reg 0 returns eax/ebx and 1 ecx/edx */
+static void cpuid_msg_init(struct apml_message *msg, uint32_t thread,
+			   uint32_t fn_eax, uint32_t fn_ecx, uint8_t read_reg)
+{
+	uint8_t ext;
+
+	memset(msg, 0, sizeof(*msg));
+	/* cmd for CPUID is 0x1000 */
+	msg->cmd = 0x1000;
+	/* Assign thread number to data_in[4:5] */
+	msg->data_in.cpu_msr_in = fn_eax | ((uint64_t)thread << 32);
+	/* Assign extended function to data_in[6][4:7] */
+	ext = (uint8_t)fn_ecx << 4 | read_reg;
+	msg->data_in.cpu_msr_in |= (uint64_t)ext << 48;
+	/* Assign 7 byte to READ Mode */
+	msg->data_in.reg_in[7] = 1;
+}
+
+oob_status_t esmi_oob_cpuid(uint8_t soc_num, uint32_t thread,
+			    uint32_t *eax, uint32_t *ebx,
+			    uint32_t *ecx, uint32_t *edx)
+{
+	struct esmi_cpuid_leaf leaf = {0};
+	oob_status_t ret;
+
+	if (!eax || !ebx || !ecx || !edx)
+		return OOB_ARG_PTR_NULL;
+
+	leaf.fn_eax = *eax;
+	leaf.fn_ecx = *ecx;
+	/* One transaction for eax/ebx and one for ecx/edx */
+	ret = esmi_oob_cpuid_multi(soc_num, thread, &leaf, 1);
 	if (ret)
 		return ret;
 
-	ret = esmi_oob_cpuid_ecx(soc_num, thread, fn_eax, fn_ecx, ecx);
+	*eax = leaf.eax;
+	*ebx = leaf.ebx;
+	*ecx = leaf.ecx;
+	*edx = leaf.edx;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t esmi_oob_cpuid_multi(uint8_t soc_num, uint32_t thread,
+				  struct esmi_cpuid_leaf *leaves,
+				  uint32_t count)
+{
+	struct apml_message msgs[CPUID_MULTI_BATCH];
+	uint32_t i, n, k;
+	oob_status_t ret;
+
+	if (!leaves)
+		return OOB_ARG_PTR_NULL;
+
+	/* validate thread */
+	ret = validate_thread(soc_num, thread);
 	if (ret)
 		return ret;
 
-	return esmi_oob_cpuid_edx(soc_num, thread, fn_eax, fn_ecx, edx);
+	for (i = 0; i < count; i += n) {
+		n = count - i;
+		if (n > CPUID_MULTI_BATCH / 2)
+			n = CPUID_MULTI_BATCH / 2;
+		for (k = 0; k < n; k++) {
+			cpuid_msg_init(&msgs[2 * k], thread,
+				       leaves[i + k].fn_eax,
+				       leaves[i + k].fn_ecx, 0);
+			cpuid_msg_init(&msgs[2 * k + 1], thread,
+				       leaves[i + k].fn_eax,
+				       leaves[i + k].fn_ecx, 1);
+		}
+		ret = sbrmi_xfer_msgs(soc_num, msgs, 2 * n);
+		if (ret)
+			return ret;
+		for (k = 0; k < n; k++) {
+			leaves[i + k].eax = msgs[2 * k].data_out.mb_out[0];
+			leaves[i + k].ebx = msgs[2 * k].data_out.mb_out[1];
+			leaves[i + k].ecx = msgs[2 * k + 1].data_out.mb_out[0];
+			leaves[i + k].edx = msgs[2 * k + 1].data_out.mb_out[1];
+		}
+	}
+
+	return OOB_SUCCESS;
 }
 
 static oob_status_t esmi_oob_cpuid_fn(uint8_t soc_num, uint32_t thread,
 				      uint32_t fn_eax, uint32_t fn_ecx,
 				      uint8_t mode, uint32_t *value)
 {
-	struct apml_message msg = {0};
-	uint8_t ext = 0, read_reg = 0;
+	struct apml_message msg;
+	uint8_t read_reg;
 	oob_status_t ret;
 
 	if (!value)
 		return OOB_ARG_PTR_NULL;
 
-	/* cmd for CPUID is 0x1000 */
-	msg.cmd = 0x1000;
-	msg.data_in.cpu_msr_in = fn_eax;
-
-	/* Assign thread number to data_in[4:5] */
-	msg.data_in.cpu_msr_in = msg.data_in.cpu_msr_in
-				 | ((uint64_t)thread << 32);
-
-	/* Assign extended function to data_in[6][4:7] */
 	if (mode == EAX || mode == EBX)
 		/* read eax/ebx */
 		read_reg = 0;
@@ -347,14 +503,10 @@ static oob_status_t esmi_oob_cpuid_fn(uint8_t soc_num, uint32_t thread,
 		/* read ecx/edx */
 		read_reg = 1;
 
-	ext = (uint8_t)fn_ecx;
-        ext = ext << 4 | read_reg;
-        msg.data_in.cpu_msr_in = msg.data_in.cpu_msr_in | ((uint64_t) ext << 48);
-	/* Assign 7 byte to READ Mode */
-	msg.data_in.reg_in[7] = 1;
-        ret = sbrmi_xfer_msg(soc_num, &msg);
-        if (ret)
-                return ret;
+	cpuid_msg_init(&msg, thread, fn_eax, fn_ecx, read_reg);
+	ret = sbrmi_xfer_msg(soc_num, &msg);
+	if (ret)
+		return ret;
 
 	if (mode == EAX || mode == ECX)
 		/* Read low word/mbout[0] */
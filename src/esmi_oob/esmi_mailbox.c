@@ -38,15 +38,19 @@
  * DEALINGS WITH THE SOFTWARE.
  *
  */
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <unistd.h>
 
 #include <esmi_oob/esmi_mailbox.h>
 #include <esmi_oob/apml.h>
 #include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_hwmon.h>
+#include <esmi_oob/apml_init.h>
 #include <esmi_oob/esmi_cpuid_msr.h>
 #include <esmi_oob/esmi_rmi.h>
 
@@ -70,8 +74,14 @@
 #define DIMM_SERIAL_NUM_REG_OFF	0x205
 /* Register space to get DIMM serial Number */
 #define DIMM_SERIAL_NUM_REG_SPACE 0x1
+/* Mailbox read mode */
+#define MB_READ_MODE		1
+/* Low words this far past the wrap cannot tear with the high word */
+#define RAPL_TEAR_MARGIN	(1U << 24)
 
 float esu_multiplier;
+/* Per socket energy status unit multiplier without apml_init() */
+static float esu_soc[APML_MAX_SOCKETS];
 struct processor_info plat_info[1];
 
 /*
@@ -102,12 +112,18 @@ static oob_status_t validate_pwr_efficiency_mode(uint8_t value)
 
 oob_status_t read_socket_power(uint8_t soc_num, uint32_t *buffer)
 {
+	if (!apml_hwmon_read_power(soc_num, buffer))
+		return OOB_SUCCESS;
+
 	return esmi_oob_read_mailbox(soc_num, READ_PACKAGE_POWER_CONSUMPTION,
 				     0, buffer);
 }
 
 oob_status_t read_socket_power_limit(uint8_t soc_num, uint32_t *buffer)
 {
+	if (!apml_hwmon_read_power_limit(soc_num, buffer))
+		return OOB_SUCCESS;
+
 	return esmi_oob_read_mailbox(soc_num, READ_PACKAGE_POWER_LIMIT,
 				     0, buffer);
 }
@@ -811,23 +827,6 @@ oob_status_t read_bmc_rapl_units(uint8_t soc_num,
 	return ret;
 }
 
-static oob_status_t read_bmc_rapl_core_lo_counter(uint8_t soc_num,
-						  uint32_t core_id,
-						  uint32_t *value)
-{
-	return esmi_oob_read_mailbox(soc_num,
-				     READ_BMC_RAPL_CORE_LO_COUNTER,
-				     core_id, value);
-}
-
-static oob_status_t read_bmc_rapl_core_hi_counter(uint8_t soc_num,
-						  uint32_t core_id,
-						  uint32_t *value)
-{
-	return esmi_oob_read_mailbox(soc_num, READ_BMC_RAPL_CORE_HI_COUNTER,
-				     core_id, value);
-}
-
 static oob_status_t read_bmc_rapl_pkg_counter(uint8_t soc_num,
 					      uint8_t counter,
 					      uint32_t *counter_value)
@@ -920,70 +919,154 @@ static oob_status_t read_bmc_esu_multiplier(uint8_t soc_num)
 	if (ret)
 		return ret;
 
-	esu_multiplier = pow(2, -1 * (esu_value));
+	/* 1/2^ESU is exact as a float, no need for pow() */
+	esu_soc[soc_num] = ldexpf(1.0f, -esu_value);
+	esu_multiplier = esu_soc[soc_num];
 	return ret;
 }
 
+static oob_status_t get_esu_multiplier(uint8_t soc_num, float *esu)
+{
+	oob_status_t ret;
+
+	/* Per socket multiplier when the library is initialized */
+	ret = apml_get_esu_multiplier(soc_num, esu);
+	if (ret != OOB_NOT_INITIALIZED)
+		return ret;
+
+	if (soc_num >= APML_MAX_SOCKETS)
+		return OOB_INVALID_INPUT;
+	if (!esu_soc[soc_num]) {
+		ret = read_bmc_esu_multiplier(soc_num);
+		if (ret)
+			return ret;
+	}
+	*esu = esu_soc[soc_num];
+
+	return OOB_SUCCESS;
+}
+
 oob_status_t read_rapl_core_energy_counters(uint8_t soc_num,
 					    uint32_t core_id,
 					    double *energy_counters)
 {
-	uint64_t counter;
-	uint32_t hi_counter, new_hi_counter, lo_counter;
+	struct rapl_core_energy energy;
 	oob_status_t ret;
 
 	if (!energy_counters)
 		return OOB_ARG_PTR_NULL;
 
-	/* Read Package High count Register Value */
-	ret = read_bmc_rapl_core_hi_counter(soc_num, core_id, &hi_counter);
-
+	ret = read_rapl_core_energy_sweep(soc_num, &core_id, 1, &energy);
 	if (ret)
 		return ret;
 
-	/* Read Package Low count Register Value */
-	ret = read_bmc_rapl_core_lo_counter(soc_num, core_id, &lo_counter);
-	if (ret)
-		return ret;
+	/* Convert the energy counters to Kilo Joules by dividing it by 1000 */
+	*energy_counters = energy.joules / 1000;
 
-	/* Read Package High count Register Value */
-	ret = read_bmc_rapl_core_hi_counter(soc_num, core_id, &new_hi_counter);
+	return ret;
+}
+
+static void rapl_msg_init(struct apml_message *msg, uint32_t cmd,
+			  uint32_t core_id)
+{
+	memset(msg, 0, sizeof(*msg));
+	msg->cmd = cmd;
+	msg->data_in.mb_in[0] = core_id;
+	msg->data_in.mb_in[1] = (uint32_t)MB_READ_MODE << 24;
+}
+
+/* Low word close past the wrap, the high word may predate the carry */
+static bool rapl_may_tear(uint64_t counter)
+{
+	return (counter & FOUR_BYTE_MASK) < RAPL_TEAR_MARGIN;
+}
+
+oob_status_t read_rapl_core_energy_sweep(uint8_t soc_num,
+					 const uint32_t *core_ids,
+					 uint32_t count,
+					 struct rapl_core_energy *energy)
+{
+	struct apml_message *msgs;
+	uint32_t i, n = 0;
+	oob_status_t ret;
+	float esu;
+
+	if (!energy)
+		return OOB_ARG_PTR_NULL;
+	if (!count)
+		return OOB_INVALID_INPUT;
+
+	/* Fail fast on commands known to be unsupported by the firmware */
+	if (apml_cap_get(soc_num, READ_BMC_RAPL_CORE_HI_COUNTER) ==
+	    APML_CAP_UNSUPPORTED ||
+	    apml_cap_get(soc_num, READ_BMC_RAPL_CORE_LO_COUNTER) ==
+	    APML_CAP_UNSUPPORTED)
+		return OOB_MAILBOX_CMD_UNKNOWN;
+
+	ret = get_esu_multiplier(soc_num, &esu);
 	if (ret)
 		return ret;
 
-	if (hi_counter != new_hi_counter) {
-		/* Read Package low count Register Value */
-		ret = read_bmc_rapl_core_lo_counter(soc_num, core_id, &lo_counter);
-		if (ret)
-			return ret;
-	}
-
-	/* Get the 64-bit counter from high and low word counters */
-	counter = (uint64_t)new_hi_counter << 32\
-		  | (uint64_t)lo_counter & FOUR_BYTE_MASK;
+	msgs = calloc(2 * count, sizeof(*msgs));
+	if (!msgs)
+		return OOB_NO_MEMORY;
 
-	/* Get the esu multiplier */
-	if (!esu_multiplier) {
-		ret = read_bmc_esu_multiplier(soc_num);
+	/* High then low word of every core in one batch */
+	for (i = 0; i < count; i++) {
+		rapl_msg_init(&msgs[2 * i], READ_BMC_RAPL_CORE_HI_COUNTER,
+			      core_ids ? core_ids[i] : i);
+		rapl_msg_init(&msgs[2 * i + 1], READ_BMC_RAPL_CORE_LO_COUNTER,
+			      core_ids ? core_ids[i] : i);
+	}
+	ret = sbrmi_xfer_msgs(soc_num, msgs, 2 * count);
+	if (ret)
+		goto out;
+	apml_cap_record(soc_num, READ_BMC_RAPL_CORE_HI_COUNTER, OOB_SUCCESS);
+	apml_cap_record(soc_num, READ_BMC_RAPL_CORE_LO_COUNTER, OOB_SUCCESS);
+	for (i = 0; i < count; i++)
+		energy[i].counter =
+			(uint64_t)msgs[2 * i].data_out.mb_out[0] << 32 |
+			msgs[2 * i + 1].data_out.mb_out[0];
+
+	/*
+	 * A low word far from the wrap cannot have carried between the two
+	 * reads. Otherwise the low word was read after the carry and pairs
+	 * with a high word read again now.
+	 */
+	for (i = 0; i < count; i++)
+		if (rapl_may_tear(energy[i].counter))
+			rapl_msg_init(&msgs[n++], READ_BMC_RAPL_CORE_HI_COUNTER,
+				      core_ids ? core_ids[i] : i);
+	if (n) {
+		ret = sbrmi_xfer_msgs(soc_num, msgs, n);
 		if (ret)
-			return ret;
+			goto out;
+		n = 0;
+		for (i = 0; i < count; i++) {
+			if (!rapl_may_tear(energy[i].counter))
+				continue;
+			energy[i].counter &= FOUR_BYTE_MASK;
+			energy[i].counter |=
+				(uint64_t)msgs[n++].data_out.mb_out[0] << 32;
+		}
 	}
 
 	/* Calculate the energy counters(64bit counter * esu_multiplier) */
-	/* Convert the energy counters to Kilo Joules by dividing it by 1000 */
-	*energy_counters = (counter * esu_multiplier) / 1000;
+	for (i = 0; i < count; i++)
+		energy[i].joules = energy[i].counter * (double)esu;
+
+out:
+	free(msgs);
 
 	return ret;
 }
 
-oob_status_t read_rapl_pckg_energy_counters(uint8_t soc_num,
-					    double *energy_counters)
+oob_status_t read_rapl_pckg_energy_raw(uint8_t soc_num, uint64_t *counter)
 {
-	uint64_t counter;
-	uint32_t hi_counter, new_hi_counter, lo_counter;
+	uint32_t hi_counter, lo_counter;
 	oob_status_t ret;
 
-	if (!energy_counters)
+	if (!counter)
 		return OOB_ARG_PTR_NULL;
 
 	/* Read Package High count Register Value */
@@ -998,33 +1081,40 @@ oob_status_t read_rapl_pckg_energy_counters(uint8_t soc_num,
 	if (ret)
 		return ret;
 
-	/* Read Package High count Register value */
-	ret = read_bmc_rapl_pkg_counter(soc_num, HI_WORD_REG,
-					&new_hi_counter);
-	if (ret)
-		return ret;
-
-	if (hi_counter != new_hi_counter) {
-		/* Read Package low count Register value */
-		ret = read_bmc_rapl_pkg_counter(soc_num,
-						LO_WORD_REG,
-						&lo_counter);
+	/* Only a low word close past the wrap may pair with a stale high */
+	if (lo_counter < RAPL_TEAR_MARGIN) {
+		ret = read_bmc_rapl_pkg_counter(soc_num, HI_WORD_REG,
+						&hi_counter);
 		if (ret)
 			return ret;
 	}
-	counter = (uint64_t)new_hi_counter << 32 |\
-		  (uint64_t)lo_counter & FOUR_BYTE_MASK;
+	*counter = (uint64_t)hi_counter << 32 | lo_counter;
+
+	return OOB_SUCCESS;
+}
+
+oob_status_t read_rapl_pckg_energy_counters(uint8_t soc_num,
+					    double *energy_counters)
+{
+	uint64_t counter;
+	float esu;
+	oob_status_t ret;
+
+	if (!energy_counters)
+		return OOB_ARG_PTR_NULL;
+
+	ret = read_rapl_pckg_energy_raw(soc_num, &counter);
+	if (ret)
+		return ret;
 
 	/* Get the esu multiplier */
-	if (!esu_multiplier) {
-		ret = read_bmc_esu_multiplier(soc_num);
-		if (ret)
-			return ret;
-	}
+	ret = get_esu_multiplier(soc_num, &esu);
+	if (ret)
+		return ret;
 
 	/* Calculate the energy counters(64bit counter * esu_multiplier) */
 	/* Convert the energy counters to Mega Joules by dividing it by 1000000 */
-	*energy_counters = (counter * esu_multiplier) / 1000000;
+	*energy_counters = (counter * esu) / 1000000;
 	return ret;
 }
 
@@ -40,10 +40,13 @@
  */
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <esmi_oob/apml_common.h>
 #include <esmi_oob/esmi_cpuid_msr.h>
 #include <esmi_oob/esmi_rmi.h>
 #include <esmi_oob/apml.h>
+#include <esmi_oob/apml_init.h>
 
 /* REVISION 0x10 */
 /* Thread enable status registers */
@@ -419,3 +422,348 @@ oob_status_t esmi_get_threads_per_socket(uint8_t soc_num,
 	*threads_per_socket = ((uint32_t)thread_num_hi << 8) | thread_num_low;
 	return ret;
 }
+
+/* Revision, scalar registers, three register arrays and the messages */
+#define RMI_SNAPSHOT_REGS	(8 + MAX_THREAD_REG_V21_DENSE + \
+				 2 * MAX_ALERT_REG_V21_DENSE + \
+				 3 * SBRMI_MSG_REGS)
+
+/* Register list of a snapshot, where each value is stored and its group */
+struct rmi_batch {
+	struct apml_message msgs[RMI_SNAPSHOT_REGS];
+	uint8_t *dst[RMI_SNAPSHOT_REGS];
+	uint8_t group[RMI_SNAPSHOT_REGS];
+	uint32_t count;
+};
+
+static void batch_add(struct rmi_batch *batch, uint8_t group, uint16_t reg,
+		      uint8_t *dst)
+{
+	struct apml_message *msg = &batch->msgs[batch->count];
+
+	/* Read/Write register command is 0x1002 */
+	msg->cmd = 0x1002;
+	msg->data_in.mb_in[0] = reg;
+	/* Assign 1 to the msg.data_in[7] for the read operation */
+	msg->data_in.reg_in[7] = 1;
+	batch->group[batch->count] = group;
+	batch->dst[batch->count++] = dst;
+}
+
+/*
+ * Read the batch, skipping the registers that fail. The group of a
+ * failed register is cleared from valid and its fields are zeroed.
+ * Only a device that cannot be opened fails the whole batch.
+ */
+static oob_status_t batch_read(uint8_t soc_num, struct rmi_batch *batch,
+			       uint32_t *valid)
+{
+	uint32_t i = 0, j, done;
+	oob_status_t ret;
+
+	*valid = 0;
+	for (j = 0; j < batch->count; j++)
+		*valid |= BIT(batch->group[j]);
+	while (i < batch->count) {
+		done = 0;
+		ret = sbrmi_xfer_msgs_partial(soc_num, &batch->msgs[i],
+					      batch->count - i, &done);
+		if (ret == OOB_FILE_ERROR)
+			return ret;
+		for (j = i; j < i + done; j++)
+			*batch->dst[j] = batch->msgs[j].data_out.reg_out[0];
+		i += done;
+		if (!ret)
+			break;
+		*valid &= ~BIT(batch->group[i]);
+		i++;
+	}
+	for (j = 0; j < batch->count; j++)
+		if (!(*valid & BIT(batch->group[j])))
+			*batch->dst[j] = 0;
+
+	return OOB_SUCCESS;
+}
+
+/*
+ * Register layout of the revision, taken from the socket inventory when
+ * the library is initialized
+ */
+static oob_status_t regs_layout(uint8_t soc_num, struct sbrmi_regs *regs)
+{
+	struct processor_info plat_info = {0};
+	struct apml_inventory inv;
+	bool cached;
+	oob_status_t ret;
+
+	memset(regs, 0, sizeof(*regs));
+	cached = !apml_get_inventory(soc_num, &inv);
+	if (cached) {
+		regs->revision = inv.rmi_rev;
+		plat_info = inv.proc;
+	} else {
+		ret = read_sbrmi_revision(soc_num, &regs->revision);
+		if (ret)
+			return ret;
+	}
+
+	regs->thread_en_count = sizeof(thread_en_reg_v20);
+	regs->alert_count = sizeof(alert_status);
+	if (regs->revision == 0x10) {
+		regs->thread_en_count = sizeof(thread_en_reg_v10);
+	} else if (regs->revision == 0x21) {
+		if (!cached) {
+			ret = esmi_get_processor_info(soc_num, &plat_info);
+			if (ret)
+				return ret;
+		}
+		regs->dense = plat_info.family == 0x1A &&
+			      plat_info.model >= 0x10 &&
+			      plat_info.model <= 0x1F;
+	}
+	if (regs->dense) {
+		regs->thread_en_count = ARRAY_SIZE(thread_en_reg_v21_dense);
+		regs->alert_count = ARRAY_SIZE(alert_status_v21_dense);
+	}
+
+	return OOB_SUCCESS;
+}
+
+/* Queue the thread enable, alert status and alert mask registers */
+static void batch_add_threads(struct rmi_batch *batch,
+			      struct sbrmi_regs *regs, uint32_t groups)
+{
+	const uint8_t *thread8 = regs->revision == 0x10 ?
+				 thread_en_reg_v10 : thread_en_reg_v20;
+	uint32_t i;
+
+	if (groups & BIT(SBRMI_REGS_THREAD_EN))
+		for (i = 0; i < regs->thread_en_count; i++)
+			batch_add(batch, SBRMI_REGS_THREAD_EN,
+				  regs->dense ? thread_en_reg_v21_dense[i] :
+				  thread8[i], &regs->thread_en[i]);
+	if (groups & BIT(SBRMI_REGS_ALERT_STATUS))
+		for (i = 0; i < regs->alert_count; i++)
+			batch_add(batch, SBRMI_REGS_ALERT_STATUS,
+				  regs->dense ? alert_status_v21_dense[i] :
+				  alert_status[i], &regs->alert_status[i]);
+	if (groups & BIT(SBRMI_REGS_ALERT_MASK))
+		for (i = 0; i < regs->alert_count; i++)
+			batch_add(batch, SBRMI_REGS_ALERT_MASK,
+				  regs->dense ? alert_mask_v21_dense[i] :
+				  alert_mask[i], &regs->alert_mask[i]);
+}
+
+oob_status_t sbrmi_read_all(uint8_t soc_num, struct sbrmi_regs *regs)
+{
+	struct rmi_batch *batch;
+	oob_status_t ret;
+	uint32_t i;
+
+	if (!regs)
+		return OOB_ARG_PTR_NULL;
+
+	ret = regs_layout(soc_num, regs);
+	if (ret)
+		return ret;
+
+	batch = calloc(1, sizeof(*batch));
+	if (!batch)
+		return OOB_NO_MEMORY;
+
+	batch_add(batch, SBRMI_REGS_CONTROL, SBRMI_CONTROL, &regs->control);
+	batch_add(batch, SBRMI_REGS_STATUS, SBRMI_STATUS, &regs->status);
+	batch_add(batch, SBRMI_REGS_READSIZE, SBRMI_READSIZE,
+		  &regs->readsize);
+	batch_add_threads(batch, regs, BIT(SBRMI_REGS_THREAD_EN) |
+			  BIT(SBRMI_REGS_ALERT_STATUS) |
+			  BIT(SBRMI_REGS_ALERT_MASK));
+	for (i = 0; i < SBRMI_MSG_REGS; i++) {
+		batch_add(batch, SBRMI_REGS_OUTBOUND, SBRMI_OUTBNDMSG0 + i,
+			  &regs->outbound_msg[i]);
+		batch_add(batch, SBRMI_REGS_INBOUND, SBRMI_INBNDMSG0 + i,
+			  &regs->inbound_msg[i]);
+	}
+	batch_add(batch, SBRMI_REGS_SW_INTERRUPT, SBRMI_SOFTWAREINTERRUPT,
+		  &regs->sw_interrupt);
+	if (regs->revision == 0x10) {
+		batch_add(batch, SBRMI_REGS_THREAD_NUM, SBRMI_THREADNUMBER,
+			  &regs->thread_number);
+	} else {
+		batch_add(batch, SBRMI_REGS_THREAD_NUM, SBRMI_THREADNUMBERLOW,
+			  &regs->thread_number_low);
+		batch_add(batch, SBRMI_REGS_THREAD_NUM, SBRMI_THREADNUMBERHIGH,
+			  &regs->thread_number_high);
+	}
+	batch_add(batch, SBRMI_REGS_THREAD_CS, SBRMI_THREAD128CS,
+		  &regs->thread_cs);
+	batch_add(batch, SBRMI_REGS_RAS_STATUS, SBRMI_RASSTATUS,
+		  &regs->ras_status);
+	for (i = 0; i < SBRMI_MSG_REGS; i++)
+		batch_add(batch, SBRMI_REGS_MP0, SBRMI_MP0OUTBNDMSG0 + i,
+			  &regs->mp0_msg[i]);
+
+	ret = batch_read(soc_num, batch, &regs->valid);
+	free(batch);
+
+	/* [0] Thread128CS */
+	regs->thread_cs &= 1;
+
+	return ret;
+}
+
+static void mask_set(struct apml_thread_mask *mask, uint32_t thread)
+{
+	if (thread < APML_THREAD_MASK_WORDS * 64)
+		mask->bits[thread / 64] |= 1ULL << (thread % 64);
+}
+
+/* Thread of bit b in SBRMI::AlertStatus/AlertMask register index i */
+static uint32_t alert_bit_to_thread(uint32_t i, uint32_t b)
+{
+	/* 0x10 - 0x1F: threads 16 * {0-3, 8-11} + i */
+	if (i < MAX_ALERT_REG / 2)
+		return 16 * (b < 4 ? b : b + 4) + i;
+	/* 0x50 - 0x5F: threads 16 * {4-7, 12-15} + i - 16 */
+	if (i < MAX_ALERT_REG)
+		return 16 * (b < 4 ? b + 4 : b + 8) + i - MAX_ALERT_REG / 2;
+	/* Dense 0x220 - 0x22F and 0x1C0 - 0x1CF: threads 256 and above */
+	return 16 * b + 256 + i - MAX_ALERT_REG;
+}
+
+static void pack_alert(const uint8_t *reg, uint8_t count,
+		       struct apml_thread_mask *mask)
+{
+	uint32_t i, b;
+
+	memset(mask, 0, sizeof(*mask));
+	mask->nbits = count * 8;
+	for (i = 0; i < count; i++)
+		for (b = 0; b < 8; b++)
+			if (reg[i] & BIT(b))
+				mask_set(mask, alert_bit_to_thread(i, b));
+}
+
+void sbrmi_regs_thread_masks(const struct sbrmi_regs *regs,
+			     struct apml_thread_mask *enabled,
+			     struct apml_thread_mask *alert,
+			     struct apml_thread_mask *alert_mask)
+{
+	uint32_t i;
+
+	if (enabled) {
+		memset(enabled, 0, sizeof(*enabled));
+		enabled->nbits = regs->thread_en_count * 8;
+		/* Register i holds threads 8 * i to 8 * i + 7 */
+		for (i = 0; i < regs->thread_en_count; i++)
+			enabled->bits[i / 8] |=
+				(uint64_t)regs->thread_en[i] << (8 * (i % 8));
+	}
+	if (alert)
+		pack_alert(regs->alert_status, regs->alert_count, alert);
+	if (alert_mask)
+		pack_alert(regs->alert_mask, regs->alert_count, alert_mask);
+}
+
+oob_status_t sbrmi_get_thread_masks(uint8_t soc_num,
+				    struct apml_thread_mask *enabled,
+				    struct apml_thread_mask *alert,
+				    struct apml_thread_mask *alert_mask)
+{
+	struct rmi_batch *batch;
+	struct sbrmi_regs regs;
+	uint32_t need = 0, i;
+	oob_status_t ret;
+
+	if (enabled)
+		need |= BIT(SBRMI_REGS_THREAD_EN);
+	if (alert)
+		need |= BIT(SBRMI_REGS_ALERT_STATUS);
+	if (alert_mask)
+		need |= BIT(SBRMI_REGS_ALERT_MASK);
+
+	ret = regs_layout(soc_num, &regs);
+	if (ret)
+		return ret;
+
+	batch = calloc(1, sizeof(*batch));
+	if (!batch)
+		return OOB_NO_MEMORY;
+
+	/* Only the requested registers, a partial mask would hide threads */
+	batch_add_threads(batch, &regs, need);
+	ret = sbrmi_xfer_msgs(soc_num, batch->msgs, batch->count);
+	if (!ret) {
+		for (i = 0; i < batch->count; i++)
+			*batch->dst[i] = batch->msgs[i].data_out.reg_out[0];
+		sbrmi_regs_thread_masks(&regs, enabled, alert, alert_mask);
+	}
+	free(batch);
+
+	return ret;
+}
+
+oob_status_t sbrmi_get_thread_summary(uint8_t soc_num,
+				      struct sbrmi_thread_summary *summary)
+{
+	struct apml_thread_mask enabled, alert, alert_mask;
+	uint32_t threads_per_core, i;
+	oob_status_t ret;
+
+	if (!summary)
+		return OOB_ARG_PTR_NULL;
+
+	ret = sbrmi_get_thread_masks(soc_num, &enabled, &alert, &alert_mask);
+	if (ret)
+		return ret;
+	ret = esmi_get_threads_per_core(soc_num, &threads_per_core);
+	if (ret)
+		return ret;
+
+	summary->online = apml_thread_mask_count(&enabled);
+	summary->alerts_pending = apml_thread_mask_count(&alert);
+	summary->alerts_unmasked = 0;
+	for (i = 0; i < APML_THREAD_MASK_WORDS; i++)
+		summary->alerts_unmasked +=
+			__builtin_popcountll(alert.bits[i] &
+					     ~alert_mask.bits[i]);
+	summary->smt = threads_per_core > 1;
+
+	return OOB_SUCCESS;
+}
+
+uint32_t apml_thread_mask_count(const struct apml_thread_mask *mask)
+{
+	uint32_t i, count = 0;
+
+	for (i = 0; i < APML_THREAD_MASK_WORDS; i++)
+		count += __builtin_popcountll(mask->bits[i]);
+
+	return count;
+}
+
+bool apml_thread_mask_test(const struct apml_thread_mask *mask,
+			   uint32_t thread)
+{
+	if (thread >= APML_THREAD_MASK_WORDS * 64)
+		return false;
+
+	return mask->bits[thread / 64] & (1ULL << (thread % 64));
+}
+
+int apml_thread_mask_next(const struct apml_thread_mask *mask, int thread)
+{
+	uint32_t next = thread + 1, word;
+	uint64_t bits;
+
+	while (next < APML_THREAD_MASK_WORDS * 64) {
+		word = next / 64;
+		/* Bits at or above next in this word */
+		bits = mask->bits[word] & (~0ULL << (next % 64));
+		if (bits)
+			return word * 64 + __builtin_ctzll(bits);
+		next = (word + 1) * 64;
+	}
+
+	return -1;
+}
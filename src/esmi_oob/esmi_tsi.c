@@ -38,6 +38,7 @@
  * DEALINGS WITH THE SOFTWARE.
  *
  */
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -45,6 +46,25 @@
 
 #include <esmi_oob/esmi_tsi.h>
 #include <esmi_oob/apml.h>
+#include <esmi_oob/apml_common.h>
+#include <esmi_oob/apml_hwmon.h>
+#include <esmi_oob/tsi_mi300.h>
+
+/* Reads of a temperature register pair before giving up */
+#define TEMP_READ_RETRY		3
+
+/* Cached SBTSI::Config[ReadOrder] per socket */
+typedef enum {
+	RD_ORDER_UNKNOWN,
+	RD_ORDER_INT_FIRST,
+	RD_ORDER_DEC_FIRST
+} rd_order_state;
+
+static uint8_t rd_order_cache[APML_MAX_SOCKETS];
+
+/* as per the ssp document valid rates from 0 - 10 are as below */
+static const float valid_rate[] = {0.0625, 0.125, 0.25, 0.5, 1, 2, 4, 8,
+				   16, 32, 64};
 
 /* sb-tsi register access */
 oob_status_t read_sbtsi_cpuinttemp(uint8_t soc_num,
@@ -70,9 +90,7 @@ oob_status_t read_sbtsi_config(uint8_t soc_num,
 oob_status_t read_sbtsi_updaterate(uint8_t soc_num,
 				   float *buffer)
 {
-	/* as per the ssp document valid rates from 0 - 10 are as below */
-	float valid_rate[] = {0.0625, 0.125, 0.25, 0.5, 1, 2, 4, 8, 16, 32, 64};
-	int items = 11; /* total number of uprates in above valid_rate[] */
+	int items = ARRAY_SIZE(valid_rate);
 	oob_status_t ret;
 	uint8_t rdbyte;
 
@@ -92,9 +110,7 @@ oob_status_t read_sbtsi_updaterate(uint8_t soc_num,
 oob_status_t write_sbtsi_updaterate(uint8_t soc_num,
 				    float uprate)
 {
-	/* as per the ssp document valid rates from 0 - 10 are as below */
-	float valid_rate[] = {0.0625, 0.125, 0.25, 0.5, 1, 2, 4, 8, 16, 32, 64};
-	int items = 11; /* total number of uprates in above valid_rate[] */
+	int items = ARRAY_SIZE(valid_rate);
 	uint8_t wrbyte;
 
 	for (wrbyte = 0; wrbyte < items; wrbyte++) {
@@ -243,7 +259,13 @@ oob_status_t sbtsi_set_configwr(uint8_t soc_num,
 		return ret;
 
 	new = mode ? prev | config_mask : prev & (~config_mask);
-	return esmi_oob_tsi_write_byte(soc_num, SBTSI_CONFIGWR, new);
+	ret = esmi_oob_tsi_write_byte(soc_num, SBTSI_CONFIGWR, new);
+	/* Read order may have changed, read it again on next temperature */
+	if (soc_num < APML_MAX_SOCKETS)
+		__atomic_store_n(&rd_order_cache[soc_num], RD_ORDER_UNKNOWN,
+				 __ATOMIC_RELAXED);
+
+	return ret;
 }
 
 oob_status_t read_sbtsi_hitempint(uint8_t soc_num,
@@ -449,6 +471,59 @@ oob_status_t read_sbtsi_revision(uint8_t soc_num,
 	return esmi_oob_tsi_read_byte(soc_num, SBTSI_REVISION, rivision);
 }
 
+oob_status_t sbtsi_read_temp_regs(uint8_t soc_num, uint8_t first,
+				  uint8_t second, uint8_t *first_val,
+				  uint8_t *second_val)
+{
+	oob_status_t ret;
+	uint8_t check;
+	int retry;
+
+	if (!first_val || !second_val)
+		return OOB_ARG_PTR_NULL;
+
+	ret = esmi_oob_tsi_read_byte(soc_num, first, first_val);
+	for (retry = 0; !ret && retry < TEMP_READ_RETRY; retry++) {
+		ret = esmi_oob_tsi_read_byte(soc_num, second, second_val);
+		if (ret)
+			break;
+		ret = esmi_oob_tsi_read_byte(soc_num, first, &check);
+		if (ret)
+			break;
+		if (check == *first_val)
+			return OOB_SUCCESS;
+		/* Updated in between, the re-read latched a new pair */
+		*first_val = check;
+	}
+
+	return ret ? ret : OOB_TRY_AGAIN;
+}
+
+/* Cached read order of the CPU temperature registers */
+static oob_status_t get_read_order(uint8_t soc_num, uint8_t *rd_order)
+{
+	oob_status_t ret;
+	uint8_t config;
+
+	if (soc_num < APML_MAX_SOCKETS) {
+		*rd_order = __atomic_load_n(&rd_order_cache[soc_num],
+					    __ATOMIC_RELAXED);
+		if (*rd_order != RD_ORDER_UNKNOWN)
+			return OOB_SUCCESS;
+	}
+
+	ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_CONFIGURATION, &config);
+	if (ret != OOB_SUCCESS)
+		return ret;
+	*rd_order = (config & READORDER_MASK) ? RD_ORDER_DEC_FIRST
+					      : RD_ORDER_INT_FIRST;
+	if (soc_num < APML_MAX_SOCKETS)
+		__atomic_store_n(&rd_order_cache[soc_num], *rd_order,
+				 __ATOMIC_RELAXED);
+
+	return OOB_SUCCESS;
+}
+
 oob_status_t sbtsi_get_cputemp(uint8_t soc_num,
 			       float *cpu_temp)
 {
@@ -459,30 +534,27 @@ oob_status_t sbtsi_get_cputemp(uint8_t soc_num,
 	if (!cpu_temp)
 		return OOB_ARG_PTR_NULL;
 
-	ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_CONFIGURATION, &rd_order);
+	/* hwmon backend, falls back to the ioctl path if not available */
+	if (!apml_hwmon_read_temp(soc_num, cpu_temp))
+		return OOB_SUCCESS;
+
+	ret = get_read_order(soc_num, &rd_order);
 	if (ret != OOB_SUCCESS)
 		return ret;
-	rd_order &= READORDER_MASK;
-	if (rd_order) {
-		ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_CPUTEMPDEC,
-					     &byte_dec);
-		if (ret != OOB_SUCCESS)
-			return ret;
-		usleep(1000);
-		ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_CPUTEMPINT,
-					     &byte_int);
-		if (ret != OOB_SUCCESS)
-			return ret;
-	} else {
-		ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_CPUTEMPINT,
-					     &byte_int);
-		if (ret != OOB_SUCCESS)
-			return ret;
-		usleep(1000);
-		ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_CPUTEMPDEC,
-					     &byte_dec);
-		if (ret != OOB_SUCCESS)
-			return ret;
+	if (rd_order == RD_ORDER_DEC_FIRST)
+		ret = sbtsi_read_temp_regs(soc_num, SBTSI_CPUTEMPDEC,
+					   SBTSI_CPUTEMPINT, &byte_dec,
+					   &byte_int);
+	else
+		ret = sbtsi_read_temp_regs(soc_num, SBTSI_CPUTEMPINT,
+					   SBTSI_CPUTEMPDEC, &byte_int,
+					   &byte_dec);
+	if (ret != OOB_SUCCESS) {
+		/* Possibly a stale read order, read it again next time */
+		if (ret == OOB_TRY_AGAIN && soc_num < APML_MAX_SOCKETS)
+			__atomic_store_n(&rd_order_cache[soc_num],
+					 RD_ORDER_UNKNOWN, __ATOMIC_RELAXED);
+		return ret;
 	}
 	*cpu_temp = byte_int + ((byte_dec >> 5) * TEMP_INC);
 
@@ -498,11 +570,8 @@ oob_status_t sbtsi_get_hitemp_threshold(uint8_t soc_num,
 	if (!hitemp_thr)
 		return OOB_ARG_PTR_NULL;
 
-	ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_HITEMPINT, &byte_int);
-	if (ret != OOB_SUCCESS)
-		return ret;
-	usleep(1000);
-	ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_HITEMPDEC, &byte_dec);
+	ret = sbtsi_read_temp_regs(soc_num, SBTSI_HITEMPINT, SBTSI_HITEMPDEC,
+				   &byte_int, &byte_dec);
 	if (ret != OOB_SUCCESS)
 		return ret;
 	/* combining integer and decimal part to make float value
@@ -522,11 +591,8 @@ oob_status_t sbtsi_get_lotemp_threshold(uint8_t soc_num,
 	if (!lotemp_thr)
 		return OOB_ARG_PTR_NULL;
 
-	ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_LOTEMPINT, &byte_int);
-	if (ret != OOB_SUCCESS)
-		return ret;
-	usleep(1000);
-	ret = esmi_oob_tsi_read_byte(soc_num, SBTSI_LOTEMPDEC, &byte_dec);
+	ret = sbtsi_read_temp_regs(soc_num, SBTSI_LOTEMPINT, SBTSI_LOTEMPDEC,
+				   &byte_int, &byte_dec);
 	if (ret != OOB_SUCCESS)
 		return ret;
 	/* combining integer and decimal part to make float value
@@ -590,3 +656,120 @@ oob_status_t sbtsi_get_timeout(uint8_t soc_num,
 
 	return OOB_SUCCESS;
 }
+
+/* Register of the snapshot and the field it is stored in */
+struct tsi_reg_field {
+	uint8_t reg;
+	size_t offset;
+};
+
+#define TSI_FIELD(reg, field)	{reg, offsetof(struct sbtsi_regs, field)}
+
+/* Pairs are listed integer first, next to each other */
+static const struct tsi_reg_field tsi_fields[] = {
+	TSI_FIELD(SBTSI_STATUS, status),
+	TSI_FIELD(SBTSI_CONFIGURATION, config),
+	TSI_FIELD(SBTSI_UPDATERATE, update_rate),
+	TSI_FIELD(SBTSI_HITEMPINT, hi_temp_int),
+	TSI_FIELD(SBTSI_HITEMPDEC, hi_temp_dec),
+	TSI_FIELD(SBTSI_LOTEMPINT, lo_temp_int),
+	TSI_FIELD(SBTSI_LOTEMPDEC, lo_temp_dec),
+	TSI_FIELD(SBTSI_CPUTEMPOFFINT, temp_off_int),
+	TSI_FIELD(SBTSI_CPUTEMPOFFDEC, temp_off_dec),
+	TSI_FIELD(SBTSI_TIMEOUTCONFIG, timeout_config),
+	TSI_FIELD(SBTSI_ALERTTHRESHOLD, alert_threshold),
+	TSI_FIELD(SBTSI_ALERTCONFIG, alert_config),
+	TSI_FIELD(SBTSI_MANUFID, manuf_id),
+	TSI_FIELD(SBTSI_REVISION, revision),
+	TSI_FIELD(SBTSI_HBM_HITEMPINT_LIMIT, hbm_hi_temp_int),
+	TSI_FIELD(SBTSI_HBM_HITEMPDEC_LIMIT, hbm_hi_temp_dec),
+	TSI_FIELD(SBTSI_HBM_LOTEMPINT_LIMIT, hbm_lo_temp_int),
+	TSI_FIELD(SBTSI_HBM_LOTEMPDEC_LIMIT, hbm_lo_temp_dec),
+	TSI_FIELD(SBTSI_MAX_HBMTEMPINT, hbm_max_temp_int),
+	TSI_FIELD(SBTSI_MAX_HBMTEMPDEC, hbm_max_temp_dec),
+	TSI_FIELD(SBTSI_HBMTEMPINT, hbm_temp_int),
+	TSI_FIELD(SBTSI_HBMTEMPDEC, hbm_temp_dec),
+};
+
+/* CPU temperature pair plus the table */
+#define TSI_SNAPSHOT_REGS	(ARRAY_SIZE(tsi_fields) + 2)
+
+/* Integer and [7:5] decimal register pair to °C */
+static float pair_to_temp(uint8_t byte_int, uint8_t byte_dec)
+{
+	return byte_int + ((byte_dec >> 5) * TEMP_INC);
+}
+
+static void set_read_msg(struct apml_message *msg, uint8_t reg)
+{
+	/* Read/Write register command is 0x1002 */
+	msg->cmd = 0x1002;
+	msg->data_in.mb_in[0] = reg;
+	/* Assign 1 to the msg.data_in[7] for the read operation */
+	msg->data_in.reg_in[7] = 1;
+}
+
+oob_status_t sbtsi_read_all(uint8_t soc_num, struct sbtsi_regs *regs)
+{
+	struct apml_message msgs[TSI_SNAPSHOT_REGS] = {0};
+	uint8_t rd_order;
+	oob_status_t ret;
+	uint32_t i;
+
+	if (!regs)
+		return OOB_ARG_PTR_NULL;
+
+	ret = get_read_order(soc_num, &rd_order);
+	if (ret != OOB_SUCCESS)
+		return ret;
+	/* CPU temperature first, in latch order */
+	if (rd_order == RD_ORDER_DEC_FIRST) {
+		set_read_msg(&msgs[0], SBTSI_CPUTEMPDEC);
+		set_read_msg(&msgs[1], SBTSI_CPUTEMPINT);
+	} else {
+		set_read_msg(&msgs[0], SBTSI_CPUTEMPINT);
+		set_read_msg(&msgs[1], SBTSI_CPUTEMPDEC);
+	}
+	for (i = 0; i < ARRAY_SIZE(tsi_fields); i++)
+		set_read_msg(&msgs[i + 2], tsi_fields[i].reg);
+
+	ret = sbtsi_xfer_msgs(soc_num, msgs, TSI_SNAPSHOT_REGS);
+	if (ret != OOB_SUCCESS)
+		return ret;
+
+	if (rd_order == RD_ORDER_DEC_FIRST) {
+		regs->cpu_temp_dec = msgs[0].data_out.reg_out[0];
+		regs->cpu_temp_int = msgs[1].data_out.reg_out[0];
+	} else {
+		regs->cpu_temp_int = msgs[0].data_out.reg_out[0];
+		regs->cpu_temp_dec = msgs[1].data_out.reg_out[0];
+	}
+	for (i = 0; i < ARRAY_SIZE(tsi_fields); i++)
+		*((uint8_t *)regs + tsi_fields[i].offset) =
+			msgs[i + 2].data_out.reg_out[0];
+
+	/* Decode the derived values from the raw bytes */
+	regs->cpu_temp = pair_to_temp(regs->cpu_temp_int, regs->cpu_temp_dec);
+	regs->hi_temp_thr = pair_to_temp(regs->hi_temp_int, regs->hi_temp_dec);
+	regs->lo_temp_thr = pair_to_temp(regs->lo_temp_int, regs->lo_temp_dec);
+	regs->temp_offset = (int8_t)regs->temp_off_int +
+			    ((regs->temp_off_dec >> 5) * TEMP_INC);
+	regs->update_rate_hz = regs->update_rate < ARRAY_SIZE(valid_rate) ?
+			       valid_rate[regs->update_rate] : 0;
+	/* [2:0] AlertThr, 0h: 1 sample to 7h: 8 samples */
+	regs->alert_samples = (regs->alert_threshold & 0x07) + 1;
+
+	/* A non zero max HBM temperature marks a MI300 socket */
+	regs->hbm_valid = regs->hbm_max_temp_int != 0;
+	regs->hbm_hi_temp_thr = pair_to_temp(regs->hbm_hi_temp_int,
+					     regs->hbm_hi_temp_dec);
+	regs->hbm_lo_temp_thr = pair_to_temp(regs->hbm_lo_temp_int,
+					     regs->hbm_lo_temp_dec);
+	regs->hbm_max_temp = pair_to_temp(regs->hbm_max_temp_int,
+					  regs->hbm_max_temp_dec);
+	regs->hbm_temp = pair_to_temp(regs->hbm_temp_int, regs->hbm_temp_dec);
+	/* [5:3] HBM AlertThr */
+	regs->hbm_alert_samples = ((regs->alert_threshold & 0x38) >> 3) + 1;
+
+	return OOB_SUCCESS;
+}
@@ -134,8 +134,8 @@ oob_status_t get_xcc_idle_residency(uint8_t soc_num, uint32_t *gfx_cores_idle_re
 				     DEFAULT_DATA, gfx_cores_idle_res);
 }
 
-oob_status_t get_energy_accum_with_timestamp(uint8_t soc_num, uint64_t *energy,
-					     uint64_t *time_stamp)
+oob_status_t get_energy_accum_raw(uint8_t soc_num, uint64_t *energy,
+				  uint64_t *time_stamp)
 {
 	uint32_t buffer[4] = {0};
 	uint32_t value;
@@ -157,12 +157,26 @@ oob_status_t get_energy_accum_with_timestamp(uint8_t soc_num, uint64_t *energy,
 	}
 
 	/* Read 64 bit of energy accumulator */
-	*energy = ((uint64_t)buffer[1] << D_WORD_BITS | buffer[0])
-		  * pow(2, -WORD_BITS);
+	*energy = (uint64_t)buffer[1] << D_WORD_BITS | buffer[0];
 
 	/* Read 56 bit of timestamp */
-	*time_stamp = (((uint64_t)(buffer[3] & THREE_BYTE_MASK)) << D_WORD_BITS
-		      | buffer[2]) * 10;
+	*time_stamp = ((uint64_t)(buffer[3] & THREE_BYTE_MASK)) << D_WORD_BITS
+		      | buffer[2];
+	return ret;
+}
+
+oob_status_t get_energy_accum_with_timestamp(uint8_t soc_num, uint64_t *energy,
+					     uint64_t *time_stamp)
+{
+	oob_status_t ret;
+
+	ret = get_energy_accum_raw(soc_num, energy, time_stamp);
+	if (ret)
+		return ret;
+
+	/* Accumulator in 2^-16 J units, time stamp in 10 ns units */
+	*energy = *energy * pow(2, -WORD_BITS);
+	*time_stamp = *time_stamp * 10;
 	return ret;
 }
 
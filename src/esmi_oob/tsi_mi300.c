@@ -50,8 +50,6 @@
 
 /* Decimal portion bits */
 #define DEC_PORTION_BITS	5	//!< Decimal portion bits
-/* Delay time or wait time */
-#define WAIT_TIME		1000	//!< Delay time
 /* Min temperature */
 #define MIN_TEMP		0	//!< Min Temp
 /* Max temperature */
@@ -116,21 +114,18 @@ oob_status_t write_sbtsi_hbm_hi_temp_th(uint8_t soc_num, float hi_temp_th)
 
 oob_status_t read_sbtsi_hbm_hi_temp_th(uint8_t soc_num, float *buffer)
 {
-	float dec_temp;
-	uint8_t int_temp;
+	uint8_t int_temp, dec_temp;
 	oob_status_t ret;
 
 	if (!buffer)
 		return OOB_ARG_PTR_NULL;
 
-	ret = read_sbtsi_hbm_hi_temp_int_th(soc_num, &int_temp);
-	if (ret)
-		return ret;
-
-	usleep(WAIT_TIME);
-	ret = read_sbtsi_hbm_hi_temp_dec_th(soc_num, &dec_temp);
+	ret = sbtsi_read_temp_regs(soc_num, SBTSI_HBM_HITEMPINT_LIMIT,
+				   SBTSI_HBM_HITEMPDEC_LIMIT, &int_temp,
+				   &dec_temp);
 	if (!ret)
-		*buffer = int_temp + dec_temp;
+		*buffer = int_temp +
+			  ((dec_temp >> DEC_PORTION_BITS) * TEMP_INC);
 
 	return ret;
 }
@@ -192,21 +187,18 @@ oob_status_t write_sbtsi_hbm_lo_temp_th(uint8_t soc_num, float temp_th)
 
 oob_status_t read_sbtsi_hbm_lo_temp_th(uint8_t soc_num, float *buffer)
 {
-	float dec_temp;
-	uint8_t int_temp;
+	uint8_t int_temp, dec_temp;
 	oob_status_t ret;
 
 	if (!buffer)
 		return OOB_ARG_PTR_NULL;
 
-	ret = read_sbtsi_hbm_lo_temp_int_th(soc_num, &int_temp);
-	if (ret)
-		return ret;
-
-	usleep(WAIT_TIME);
-	ret = read_sbtsi_hbm_lo_temp_dec_th(soc_num, &dec_temp);
+	ret = sbtsi_read_temp_regs(soc_num, SBTSI_HBM_LOTEMPINT_LIMIT,
+				   SBTSI_HBM_LOTEMPDEC_LIMIT, &int_temp,
+				   &dec_temp);
 	if (!ret)
-		*buffer = int_temp + dec_temp;
+		*buffer = int_temp +
+			  ((dec_temp >> DEC_PORTION_BITS) * TEMP_INC);
 
 	return ret;
 }
@@ -235,21 +227,17 @@ oob_status_t read_sbtsi_max_hbm_temp_dec(uint8_t soc_num, float *buffer)
 
 oob_status_t read_sbtsi_max_hbm_temp(uint8_t soc_num, float *buffer)
 {
-	float dec_temp;
-	uint8_t int_temp;
+	uint8_t int_temp, dec_temp;
 	oob_status_t ret;
 
 	if (!buffer)
 		return OOB_ARG_PTR_NULL;
 
-	ret = read_sbtsi_max_hbm_temp_int(soc_num, &int_temp);
-	if (ret)
-		return ret;
-
-	usleep(WAIT_TIME);
-	ret = read_sbtsi_max_hbm_temp_dec(soc_num, &dec_temp);
+	ret = sbtsi_read_temp_regs(soc_num, SBTSI_MAX_HBMTEMPINT,
+				   SBTSI_MAX_HBMTEMPDEC, &int_temp, &dec_temp);
 	if (!ret)
-		*buffer = int_temp + dec_temp;
+		*buffer = int_temp +
+			  ((dec_temp >> DEC_PORTION_BITS) * TEMP_INC);
 
 	return ret;
 }
@@ -278,21 +266,17 @@ oob_status_t read_sbtsi_hbm_temp_dec(uint8_t soc_num, float *buffer)
 
 oob_status_t read_sbtsi_hbm_temp(uint8_t soc_num, float *buffer)
 {
-	float dec_temp;
-	uint8_t int_temp;
+	uint8_t int_temp, dec_temp;
 	oob_status_t ret;
 
 	if (!buffer)
 		return OOB_ARG_PTR_NULL;
 
-	ret = read_sbtsi_hbm_temp_int(soc_num, &int_temp);
-	if (ret)
-		return ret;
-
-	usleep(WAIT_TIME);
-	ret = read_sbtsi_hbm_temp_dec(soc_num, &dec_temp);
+	ret = sbtsi_read_temp_regs(soc_num, SBTSI_HBMTEMPINT,
+				   SBTSI_HBMTEMPDEC, &int_temp, &dec_temp);
 	if (!ret)
-		*buffer = int_temp + dec_temp;
+		*buffer = int_temp +
+			  ((dec_temp >> DEC_PORTION_BITS) * TEMP_INC);
 
 	return ret;
 }
@@ -42,13 +42,29 @@
 #include <ctype.h>
 #include <errno.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <esmi_oob/apml.h>
 #include <esmi_oob/esmi_cpuid_msr.h>
+#include <esmi_oob/esmi_mailbox.h>
+#include <esmi_oob/esmi_rmi.h>
 #define ARGS_MAX 64
+/* Max threads per socket in a dump */
+#define DUMP_MAX_THREADS	(APML_THREAD_MASK_WORDS * 64)
+/* Subleaves reachable through the 4 bit SB-RMI extended function */
+#define DUMP_SUBLEAVES		16
+/* Sanity limits on the reported max leaves */
+#define DUMP_MAX_STD		0x40
+#define DUMP_MAX_EXT		0x80000040
+#define DUMP_PATH_SIZE		128
 
 static uint32_t eax;
 static uint32_t ebx;
@@ -174,10 +190,424 @@ static oob_status_t read_cupid_fn00000001(uint8_t soc_num,
 	return ret;
 }
 
+/* Leaves enumerated with subleaves */
+static const uint32_t subleaf_fns[] = {
+	0x7, 0xB, 0xD, 0xF, 0x10, 0x8000001D, 0x80000020, 0x80000026,
+};
+
+/* CPUID dump of a socket */
+struct cpuid_dump {
+	pthread_t tid;
+	bool started;
+	uint8_t soc_num;
+	oob_status_t ret;
+	const char *cache_dir;
+	bool cached;
+	uint64_t ppin;
+	uint32_t ucode;
+	uint32_t threads[DUMP_MAX_THREADS];
+	uint32_t nthreads;
+	/* nthreads rows of nleaves leaves, in the same leaf order */
+	struct esmi_cpuid_leaf *leaves;
+	uint32_t nleaves;
+};
+
+static bool has_subleaves(uint32_t fn)
+{
+	uint32_t i;
+
+	for (i = 0; i < sizeof(subleaf_fns) / sizeof(subleaf_fns[0]); i++)
+		if (subleaf_fns[i] == fn)
+			return true;
+
+	return false;
+}
+
+/* Append the leaves of [first, last] to the list */
+static uint32_t add_range(struct esmi_cpuid_leaf *list, uint32_t n,
+			  uint32_t first, uint32_t last)
+{
+	uint32_t fn, sub, subs;
+
+	for (fn = first; fn <= last; fn++) {
+		subs = has_subleaves(fn) ? DUMP_SUBLEAVES : 1;
+		for (sub = 0; sub < subs; sub++) {
+			memset(&list[n], 0, sizeof(list[n]));
+			list[n].fn_eax = fn;
+			list[n].fn_ecx = sub;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+/* Read the max leaves on the first thread and every leaf below them */
+static oob_status_t enumerate_leaves(struct cpuid_dump *dump)
+{
+	struct esmi_cpuid_leaf max[2] = {
+		{ .fn_eax = 0 }, { .fn_eax = 0x80000000 },
+	};
+	struct esmi_cpuid_leaf *list;
+	uint32_t n = 0, i, k = 0;
+	oob_status_t ret;
+
+	ret = esmi_oob_cpuid_multi(dump->soc_num, dump->threads[0], max, 2);
+	if (ret)
+		return ret;
+	if (max[0].eax > DUMP_MAX_STD)
+		max[0].eax = DUMP_MAX_STD;
+	if (max[1].eax > DUMP_MAX_EXT)
+		max[1].eax = DUMP_MAX_EXT;
+	if (max[1].eax < 0x80000000)
+		max[1].eax = 0x80000000;
+
+	list = calloc((max[0].eax + 1 + max[1].eax - 0x80000000 + 1) *
+		      DUMP_SUBLEAVES, sizeof(*list));
+	if (!list)
+		return OOB_NO_MEMORY;
+	n = add_range(list, n, 0, max[0].eax);
+	n = add_range(list, n, 0x80000000, max[1].eax);
+	ret = esmi_oob_cpuid_multi(dump->soc_num, dump->threads[0], list, n);
+	if (ret) {
+		free(list);
+		return ret;
+	}
+
+	/* Empty subleaves past the first carry nothing */
+	for (i = 0; i < n; i++) {
+		if (list[i].fn_ecx && !list[i].eax && !list[i].ebx &&
+		    !list[i].ecx && !list[i].edx)
+			continue;
+		list[k++] = list[i];
+	}
+	dump->leaves = list;
+	dump->nleaves = k;
+
+	return OOB_SUCCESS;
+}
+
+static void cache_path(const struct cpuid_dump *dump, char *buf)
+{
+	snprintf(buf, DUMP_PATH_SIZE, "%s/cpuid-%016llx-%08x",
+		 dump->cache_dir, (unsigned long long)dump->ppin, dump->ucode);
+}
+
+/* Load the requested threads from the cache, all or nothing */
+static bool cache_load(struct cpuid_dump *dump)
+{
+	struct esmi_cpuid_leaf leaf, *leaves = NULL;
+	uint32_t thread, nleaves = 0, *fill = NULL;
+	char path[DUMP_PATH_SIZE];
+	bool ok = false;
+	uint32_t i;
+	FILE *fp;
+
+	cache_path(dump, path);
+	fp = fopen(path, "r");
+	if (!fp)
+		return false;
+	/* The first thread sets the leaf count */
+	while (fscanf(fp, "%x %x %x %x %x %x %x", &thread, &leaf.fn_eax,
+		      &leaf.fn_ecx, &leaf.eax, &leaf.ebx, &leaf.ecx,
+		      &leaf.edx) == 7)
+		if (thread == dump->threads[0])
+			nleaves++;
+	if (!nleaves)
+		goto out;
+
+	leaves = calloc(dump->nthreads * nleaves, sizeof(*leaves));
+	fill = calloc(dump->nthreads, sizeof(*fill));
+	if (!leaves || !fill)
+		goto out;
+	rewind(fp);
+	while (fscanf(fp, "%x %x %x %x %x %x %x", &thread, &leaf.fn_eax,
+		      &leaf.fn_ecx, &leaf.eax, &leaf.ebx, &leaf.ecx,
+		      &leaf.edx) == 7) {
+		for (i = 0; i < dump->nthreads; i++)
+			if (dump->threads[i] == thread)
+				break;
+		if (i == dump->nthreads || fill[i] == nleaves)
+			continue;
+		leaves[i * nleaves + fill[i]++] = leaf;
+	}
+	for (i = 0; i < dump->nthreads; i++)
+		if (fill[i] != nleaves)
+			goto out;
+
+	dump->leaves = leaves;
+	dump->nleaves = nleaves;
+	leaves = NULL;
+	ok = true;
+out:
+	free(leaves);
+	free(fill);
+	fclose(fp);
+
+	return ok;
+}
+
+static void cache_save(const struct cpuid_dump *dump)
+{
+	const struct esmi_cpuid_leaf *leaf;
+	char path[DUMP_PATH_SIZE];
+	char tmp[DUMP_PATH_SIZE + 4];
+	uint32_t i, j;
+	FILE *fp;
+
+	mkdir(dump->cache_dir, 0755);
+	cache_path(dump, path);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fp = fopen(tmp, "w");
+	if (!fp)
+		return;
+	for (i = 0; i < dump->nthreads; i++) {
+		for (j = 0; j < dump->nleaves; j++) {
+			leaf = &dump->leaves[i * dump->nleaves + j];
+			fprintf(fp, "%x %x %x %08x %08x %08x %08x\n",
+				dump->threads[i], leaf->fn_eax, leaf->fn_ecx,
+				leaf->eax, leaf->ebx, leaf->ecx, leaf->edx);
+		}
+	}
+	/* Readers see the old file or the complete new one */
+	if (fclose(fp) || rename(tmp, path))
+		unlink(tmp);
+}
+
+static void *dump_thread(void *arg)
+{
+	struct cpuid_dump *dump = arg;
+	struct esmi_cpuid_leaf *row;
+	uint32_t i, j;
+
+	/* PPIN and microcode key the cache */
+	if (dump->cache_dir && (read_ppin_fuse(dump->soc_num, &dump->ppin) ||
+				read_ucode_revision(dump->soc_num,
+						    &dump->ucode)))
+		dump->cache_dir = NULL;
+	if (dump->cache_dir && cache_load(dump)) {
+		dump->cached = true;
+		return NULL;
+	}
+
+	dump->ret = enumerate_leaves(dump);
+	if (dump->ret)
+		return NULL;
+	row = realloc(dump->leaves,
+		      dump->nthreads * dump->nleaves * sizeof(*row));
+	if (!row) {
+		dump->ret = OOB_NO_MEMORY;
+		return NULL;
+	}
+	dump->leaves = row;
+	/* The other threads read the leaf list of the first one */
+	for (i = 1; i < dump->nthreads; i++) {
+		row = &dump->leaves[i * dump->nleaves];
+		for (j = 0; j < dump->nleaves; j++) {
+			memset(&row[j], 0, sizeof(row[j]));
+			row[j].fn_eax = dump->leaves[j].fn_eax;
+			row[j].fn_ecx = dump->leaves[j].fn_ecx;
+		}
+		dump->ret = esmi_oob_cpuid_multi(dump->soc_num,
+						 dump->threads[i], row,
+						 dump->nleaves);
+		if (dump->ret)
+			return NULL;
+	}
+	if (dump->cache_dir)
+		cache_save(dump);
+
+	return NULL;
+}
+
+/* Clear the fields identifying the thread itself */
+static void mask_thread_ids(struct esmi_cpuid_leaf *leaf)
+{
+	switch (leaf->fn_eax) {
+	case 0x1:
+		/* Local APIC ID */
+		leaf->ebx &= 0x00FFFFFF;
+		break;
+	case 0xB:
+	case 0x1F:
+	case 0x80000026:
+		/* x2APIC ID */
+		leaf->edx = 0;
+		break;
+	case 0x8000001E:
+		/* Extended APIC ID, core and node identifiers */
+		leaf->eax = 0;
+		leaf->ebx &= ~0xFFU;
+		leaf->ecx &= ~0xFFU;
+		break;
+	}
+}
+
+static void print_dump(const struct cpuid_dump *dump)
+{
+	static const char * const regs[] = { "eax", "ebx", "ecx", "edx" };
+	struct esmi_cpuid_leaf ref, cur;
+	const struct esmi_cpuid_leaf *leaf;
+	uint32_t i, j, r, diffs = 0;
+	const uint32_t *a, *b;
+
+	printf("Socket %u: PPIN 0x%016llx, ucode 0x%08x, %u threads, "
+	       "%u leaves (%s)\n", dump->soc_num,
+	       (unsigned long long)dump->ppin, dump->ucode, dump->nthreads,
+	       dump->nleaves, dump->cached ? "cache" : "APML");
+	printf("-------------------------------------------------------------"
+	       "-----------\n");
+	printf("| Leaf       | Sub | EAX        | EBX        | ECX        "
+	       "| EDX        |\n");
+	printf("-------------------------------------------------------------"
+	       "-----------\n");
+	for (j = 0; j < dump->nleaves; j++) {
+		leaf = &dump->leaves[j];
+		printf("| 0x%08x | %-3u | 0x%08x | 0x%08x | 0x%08x "
+		       "| 0x%08x |\n", leaf->fn_eax, leaf->fn_ecx, leaf->eax,
+		       leaf->ebx, leaf->ecx, leaf->edx);
+	}
+	printf("-------------------------------------------------------------"
+	       "-----------\n");
+
+	/* Every thread against the first one, thread identifiers aside */
+	for (i = 1; i < dump->nthreads; i++) {
+		for (j = 0; j < dump->nleaves; j++) {
+			ref = dump->leaves[j];
+			cur = dump->leaves[i * dump->nleaves + j];
+			mask_thread_ids(&ref);
+			mask_thread_ids(&cur);
+			a = &ref.eax;
+			b = &cur.eax;
+			for (r = 0; r < 4; r++) {
+				if (a[r] == b[r])
+					continue;
+				printf("Thread %u differs from thread %u: "
+				       "leaf 0x%08x.%u %s 0x%08x vs 0x%08x\n",
+				       dump->threads[i], dump->threads[0],
+				       ref.fn_eax, ref.fn_ecx, regs[r],
+				       a[r], b[r]);
+				diffs++;
+			}
+		}
+	}
+	printf("Heterogeneity: %u differences across %u threads\n\n", diffs,
+	       dump->nthreads);
+}
+
+/* Parse "all" or a list as "0,2,8-15" into a bitmap of max entries */
+static bool parse_list(const char *str, uint32_t max, bool *set)
+{
+	unsigned long first, last;
+	char *end;
+
+	if (!strcmp(str, "all")) {
+		memset(set, true, max * sizeof(*set));
+		return true;
+	}
+	while (*str) {
+		first = strtoul(str, &end, 0);
+		if (end == str)
+			return false;
+		last = first;
+		if (*end == '-') {
+			str = end + 1;
+			last = strtoul(str, &end, 0);
+			if (end == str)
+				return false;
+		}
+		if (first > last || last >= max)
+			return false;
+		while (first <= last)
+			set[first++] = true;
+		if (*end == ',')
+			end++;
+		else if (*end)
+			return false;
+		str = end;
+	}
+
+	return true;
+}
+
+static int cpuid_dump_sockets(const char *soc_list, const char *thread_list,
+			      const char *cache_dir)
+{
+	static bool socs[APML_MAX_SOCKETS], threads[DUMP_MAX_THREADS];
+	struct apml_thread_mask enabled;
+	struct cpuid_dump *dumps, *dump;
+	struct timespec start, end;
+	uint32_t count = 0, i, t;
+	int ret = OOB_SUCCESS;
+
+	if (!parse_list(soc_list, APML_MAX_SOCKETS, socs) ||
+	    !parse_list(thread_list, DUMP_MAX_THREADS, threads)) {
+		printf("Invalid socket or thread list\n");
+		return OOB_INVALID_INPUT;
+	}
+	dumps = calloc(APML_MAX_SOCKETS, sizeof(*dumps));
+	if (!dumps)
+		return OOB_NO_MEMORY;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < APML_MAX_SOCKETS; i++) {
+		if (!socs[i])
+			continue;
+		dump = &dumps[count];
+		dump->soc_num = i;
+		dump->cache_dir = cache_dir;
+		/* Disabled threads cannot answer CPUID */
+		if (sbrmi_get_thread_masks(i, &enabled, NULL, NULL)) {
+			printf("Socket %u is not reachable, skipped\n", i);
+			continue;
+		}
+		for (t = 0; t < DUMP_MAX_THREADS; t++)
+			if (threads[t] && apml_thread_mask_test(&enabled, t))
+				dump->threads[dump->nthreads++] = t;
+		if (dump->nthreads)
+			count++;
+	}
+
+	/* Sockets have their own APML bus, dump them in parallel */
+	for (i = 0; i < count; i++) {
+		dumps[i].started = !pthread_create(&dumps[i].tid, NULL,
+						   dump_thread, &dumps[i]);
+		if (!dumps[i].started)
+			dump_thread(&dumps[i]);
+	}
+	for (i = 0; i < count; i++)
+		if (dumps[i].started)
+			pthread_join(dumps[i].tid, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	for (i = 0; i < count; i++) {
+		if (dumps[i].ret) {
+			printf("Failed: to dump socket %u cpuid, Err[%d]: %s\n",
+			       dumps[i].soc_num, dumps[i].ret,
+			       esmi_get_err_msg(dumps[i].ret));
+			ret = dumps[i].ret;
+		} else {
+			print_dump(&dumps[i]);
+		}
+		free(dumps[i].leaves);
+	}
+	printf("Dumped %u sockets in %.3f s\n", count,
+	       end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9);
+	free(dumps);
+
+	return ret;
+}
+
 static void show_usage(char *exe_name)
 {
 	printf("Usage: %s  [-b] soc_num \n"
 		"Where:  soc_num : socket Index starting from 0\n", exe_name);
+	printf("       %s  -d [-b SOCKETS] [-t THREADS] [-c DIR]\n"
+		"  -d, --dump\t\tDump every CPUID leaf and diff the threads\n"
+		"  -b, --bus\t\tSockets as 0,1 or all, default 0\n"
+		"  -t, --threads\t\tThreads as 0,8-15 or all, default 0\n"
+		"  -c, --cache\t\tCache directory, default %s, "
+		"none to disable\n", exe_name, APML_CACHE_DIR);
 }
 
 static void rerun_sudo(int argc, char **argv)
@@ -206,11 +636,17 @@ int main(int argc, char **argv)
 	uint8_t soc_num;
 	char *end;
 	int ret, opt, long_index = 0;
-	char *helperstring = "+hb:";
+	char *helperstring = "+hb:dt:c:";
+	char *soc_list = "0", *thread_list = "0";
+	const char *cache_dir = APML_CACHE_DIR;
+	bool dump = false;
 
 	static struct option long_options[] = {
 		{"help",	no_argument,		0,	'h'},
 		{"bus",		required_argument,	0,      'b'},
+		{"dump",	no_argument,		0,	'd'},
+		{"threads",	required_argument,	0,	't'},
+		{"cache",	required_argument,	0,	'c'},
 		{0,		0,			0,	  0},
 	};
 
@@ -229,6 +665,16 @@ int main(int argc, char **argv)
 			return OOB_SUCCESS;
 		case 'b':
 			soc_num = strtoul(optarg, &end, 0);
+			soc_list = optarg;
+			break;
+		case 'd':
+			dump = true;
+			break;
+		case 't':
+			thread_list = optarg;
+			break;
+		case 'c':
+			cache_dir = strcmp(optarg, "none") ? optarg : NULL;
 			break;
 		default:
 			show_usage(argv[0]);
@@ -236,6 +682,9 @@ int main(int argc, char **argv)
 		}
 	}
 
+	if (dump)
+		return cpuid_dump_sockets(soc_list, thread_list, cache_dir);
+
 	ret = read_cupid_fn00000000(soc_num, core_id);
 	if (ret != OOB_SUCCESS) {
 		printf("Failed: to get addr[0x0] cpuid info, Err[%d]: %s\n",
@@ -47,11 +47,21 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <esmi_oob/apml.h>
 #include <esmi_oob/apml64Config.h>
+#include <esmi_oob/apml_cap.h>
+#include <esmi_oob/apml_freq.h>
+#include <esmi_oob/apml_hwmon.h>
+#include <esmi_oob/apml_init.h>
+#include <esmi_oob/apml_inventory.h>
+#include <esmi_oob/apml_mca.h>
+#include <esmi_oob/apml_ras.h>
 #include <esmi_oob/apml_recovery.h>
+#include <esmi_oob/apml_sampler.h>
+#include <esmi_oob/apml_topo.h>
 #include <esmi_oob/esmi_cpuid_msr.h>
 #include <esmi_oob/esmi_mailbox.h>
 #include <esmi_oob/esmi_rmi.h>
@@ -87,6 +97,8 @@
 #define BIT_MASK		0x1
 /* DRAM CECC leak rate mask */
 #define DRAM_CECC_LEAK_RATE_MASK	0x1F
+/* Update periods without a sample before sampletemp gives up */
+#define SAMPLE_IDLE_PERIODS	16
 static int flag;
 
 static oob_status_t validate_apml_sbtsi_module(uint8_t soc_num)
@@ -133,10 +145,17 @@ static oob_status_t get_platform_info(uint8_t soc_num,
 
 static oob_status_t get_proc_type(uint8_t soc_num,  uint8_t *p_type)
 {
-	uint8_t rev = 0;
+	struct apml_inventory inv;
 	oob_status_t ret = OOB_SUCCESS;
 	bool rev_status = false;
 
+	/* Platform details are looked up once per run from the cache file */
+	if (!apml_get_inventory(soc_num, &inv)) {
+		*plat_info = inv.proc;
+		*p_type = inv.p_type;
+		return ret;
+	}
+
 	ret = get_platform_info(soc_num, plat_info, &rev_status);
 	if (ret) {
 		if (!rev_status) {
@@ -144,36 +163,7 @@ static oob_status_t get_proc_type(uint8_t soc_num,  uint8_t *p_type)
 			return ret;
 		}
 	}
-	/* Family 1A and Model in 00 - 0Fh */
-	if (plat_info->family == 0x1A) {
-	switch (plat_info->model) {
-	case 0x00 ... 0x0F:
-		*p_type = FAM_1A_MOD_00;
-		break;
-	case 0x10 ... 0x1F:
-		*p_type = FAM_1A_MOD_10;
-		break;
-	default:
-		*p_type = LEGACY_PLATFORMS;
-	}
-	} else if (plat_info->family == 0x19) {
-	switch (plat_info->model) {
-	case 0x10 ... 0x1F:
-		*p_type = FAM_19_MOD_10;
-		break;
-	case 0x90 ... 0x9F:
-		*p_type = FAM_19_MOD_90;
-		break;
-	case 0xA0 ... 0xAF:
-		*p_type = FAM_19_MOD_A0;
-		break;
-	default:
-		*p_type = LEGACY_PLATFORMS;
-		break;
-	}
-	} else {
-	*p_type = LEGACY_PLATFORMS;
-	}
+	*p_type = apml_get_proc_type(0, plat_info);
 	return ret;
 }
 
@@ -605,17 +595,28 @@ static oob_status_t set_tsi_config(uint8_t soc_num, int value,
 static oob_status_t get_apml_rmi_access(uint8_t soc_num)
 {
 	struct processor_info plat_info;
+	struct sbrmi_regs regs;
 	int i, range;
-	uint8_t buf, rev;
+	uint8_t rev;
 	uint8_t *buffer;
 	oob_status_t ret;
 	bool is_rsdn = false;
 	bool is_brhdn = false;
+	bool thread_num;
 
 	ret = validate_apml_sbrmi_module(soc_num);
 	if (ret)
 		return ret;
 
+	/* Whole register file in one batch, failed groups are skipped */
+	ret = sbrmi_read_all(soc_num, &regs);
+	if (ret != 0) {
+		printf("Err[%d]:%s\n", ret, esmi_get_err_msg(ret));
+		return ret;
+	}
+	rev = regs.revision;
+	is_brhdn = regs.dense;
+
 	printf("------------------------------------------------------------"
 		"----\n");
 	printf("\n\t\t\t *** SB-RMI REGISTER SUMMARY ***\n");
@@ -624,60 +625,25 @@ static oob_status_t get_apml_rmi_access(uint8_t soc_num)
 	printf("\t FUNCTION [register] \t\t\t| Value [Units]\n");
 	printf("------------------------------------------------------------"
 		"----\n");
-	ret = read_sbrmi_revision(soc_num, &rev);
-	if (ret != 0) {
-		printf("Err[%d]:%s\n", ret, esmi_get_err_msg(ret));
-		return ret;
-	}
 	printf("_RMI_REVISION [0x%x]		\t\t| %#4x\n",
 	       SBRMI_REVISION, rev);
-
-	usleep(APML_SLEEP);
-	if (read_sbrmi_control(soc_num, &buf) == 0)
+	if (regs.valid & BIT(SBRMI_REGS_CONTROL))
 		printf("_RMI_CONTROL [0x%x]		\t\t| %#4x\n",
-		       SBRMI_CONTROL, buf);
-
-	usleep(APML_SLEEP);
-	if (read_sbrmi_status(soc_num, &buf) == 0)
+		       SBRMI_CONTROL, regs.control);
+	if (regs.valid & BIT(SBRMI_REGS_STATUS))
 		printf("_RMI_STATUS [0x%x]		\t\t| %#4x\n",
-		       SBRMI_STATUS, buf);
-
-	usleep(APML_SLEEP);
-	if (read_sbrmi_readsize(soc_num, &buf) == 0)
+		       SBRMI_STATUS, regs.status);
+	if (regs.valid & BIT(SBRMI_REGS_READSIZE))
 		printf("_RMI_READSIZE [0x%x]		\t\t| %#4x\n",
-		       SBRMI_READSIZE, buf);
+		       SBRMI_READSIZE, regs.readsize);
 
-	usleep(APML_SLEEP);
-	if (rev == 0x10) {
-		range = sizeof(thread_en_reg_v10);
-	} else if (rev == 0x20) {
-		range = sizeof(thread_en_reg_v20);
-	} else if (rev == 0x21) {
-		ret = esmi_get_processor_info(soc_num, &plat_info);
-		if (ret)
-			return ret;
-		if (plat_info.family == 0x1A && plat_info.model >= 0x10
-		    && plat_info.model <= 0x1F) {
-			is_brhdn = true;
-			range = ARRAY_SIZE(thread_en_reg_v21_dense);
-		} else {
-			range = sizeof(thread_en_reg_v20);
-		}
-	} else {
-		range = sizeof(thread_en_reg_v20);
-	}
-
-	buffer = malloc(range * sizeof(uint8_t));
-	if (read_sbrmi_multithreadenablestatus(soc_num,
-					       buffer) == 0) {
+	if (regs.valid & BIT(SBRMI_REGS_THREAD_EN)) {
 		printf("_RMI_THREADENSTATUS \t\t\t\t|\n");
-		for (i = 0; i < range; i++)
+		for (i = 0; i < regs.thread_en_count; i++)
 			printf("\t[0x%x] Thread[%d:%d]	\t\t| %#4x\n",
 			       (is_brhdn ? thread_en_reg_v21_dense[i] : thread_en_reg_v20[i]),
-			       (i * 8) + 7, i * 8, buffer[i]);
+			       (i * 8) + 7, i * 8, regs.thread_en[i]);
 	}
-	free(buffer);
-	buffer = NULL;
 
 	if (rev == 0x20) {
 		ret = esmi_get_processor_info(soc_num, &plat_info);
@@ -688,191 +654,150 @@ static oob_status_t get_apml_rmi_access(uint8_t soc_num)
 			is_rsdn = true;
 	}
 
-	usleep(APML_SLEEP);
-	if (is_brhdn)
-		range = ARRAY_SIZE(alert_status_v21_dense);
-	else
-		range = MAX_ALERT_REG;
-	buffer = malloc(range * sizeof(uint8_t));
-	if (!buffer)
-		return OOB_NO_MEMORY;
-	if (read_sbrmi_alert_status(soc_num, range, &buffer) == 0) {
-			printf("_RMI_ALERTSTATUS [0x%x ~ 0x%x] [0x%x ~ 0x%x] \t|\n",
-				SBRMI_ALERTSTATUS0, SBRMI_ALERTSTATUS15,
-				SBRMI_ALERTSTATUS16, SBRMI_ALERTSTATUS31);
-			if (is_brhdn)
-				printf("\t\t [0x%x ~ 0x%x] \t\t|\n",
-					SBRMI_ALERTSTATUS32, SBRMI_ALERTSTATUS47);
-			for (i = 0; i < range; i++) {
-				printf("\t[ ");
-				if ( i < MAX_ALERT_REG) {
-					for (int j = 15; j >= 0; j--) {
-						switch (j % 16) {
-						case 4 ... 7:
-							if (i / 16)
-								printf("%3d ", 16 * (j % 16) + (i - 16));
-							break;
-						case 12 ... 15:
-							if (i / 16 && rev != 0x10)
-								if ((rev == 0x20 && is_rsdn)
-								     || rev == 0x21)
-									printf("%3d ",
-										16 * (j % 16) + (i - 16));
-							break;
-						case 0 ... 3:
-							if (i / 16 == 0)
-								printf("%3d ", 16 * (j % 16) + i);
-							break;
-						case 8 ... 11:
-							if (i / 16 == 0 && rev != 0x10)
-								printf("%3d ", 16 * (j % 16) + i);
-							break;
-						}
-					}
-				} else {
-					for (int j = 7; j >= 0; j--)
-						printf("%3d ", 16 * j + (256 + (i - MAX_ALERT_REG)));
+	range = regs.valid & BIT(SBRMI_REGS_ALERT_STATUS) ?
+		regs.alert_count : 0;
+	buffer = regs.alert_status;
+	if (range)
+		printf("_RMI_ALERTSTATUS [0x%x ~ 0x%x] [0x%x ~ 0x%x] \t|\n",
+			SBRMI_ALERTSTATUS0, SBRMI_ALERTSTATUS15,
+			SBRMI_ALERTSTATUS16, SBRMI_ALERTSTATUS31);
+	if (range && is_brhdn)
+		printf("\t\t [0x%x ~ 0x%x] \t\t|\n",
+			SBRMI_ALERTSTATUS32, SBRMI_ALERTSTATUS47);
+	for (i = 0; i < range; i++) {
+		printf("\t[ ");
+		if ( i < MAX_ALERT_REG) {
+			for (int j = 15; j >= 0; j--) {
+				switch (j % 16) {
+				case 4 ... 7:
+					if (i / 16)
+						printf("%3d ", 16 * (j % 16) + (i - 16));
+					break;
+				case 12 ... 15:
+					if (i / 16 && rev != 0x10)
+						if ((rev == 0x20 && is_rsdn)
+						     || rev == 0x21)
+							printf("%3d ",
+								16 * (j % 16) + (i - 16));
+					break;
+				case 0 ... 3:
+					if (i / 16 == 0)
+						printf("%3d ", 16 * (j % 16) + i);
+					break;
+				case 8 ... 11:
+					if (i / 16 == 0 && rev != 0x10)
+						printf("%3d ", 16 * (j % 16) + i);
+					break;
 				}
-				if (rev != 0x10)
-					if  (i > 15 && (!is_rsdn && rev !=0x21))
-						printf("] \t\t\t| %#4x\n", buffer[i]);
-					else
-						printf("] \t| %#4x\n", buffer[i]);
-				else
-					printf("]        \t\t| %#4x\n", buffer[i]);
 			}
-	}
-	free(buffer);
-	buffer = NULL;
-
-	usleep(APML_SLEEP);
-	if (is_brhdn)
-		range = ARRAY_SIZE(alert_mask_v21_dense);
-	else
-		range = sizeof(alert_mask);
-	buffer = malloc(range * sizeof(uint8_t));
-	if (!buffer)
-		return OOB_NO_MEMORY;
-	if (read_sbrmi_alert_mask(soc_num, range, &buffer) == 0) {
-			printf("_RMI_ALERTMASK [0x%x ~ 0x%x] [0x%x ~ 0x%x] \t|\n",
-			       SBRMI_ALERTMASK0, SBRMI_ALERTMASK15,
-			       SBRMI_ALERTMASK16, SBRMI_ALERTMASK31);
-			if (is_brhdn)
-				printf("\t       [0x%x ~ 0x%x] \t\t\t|\n",
-					SBRMI_ALERTMASK32, SBRMI_ALERTMASK47);
-			for (i = 0; i < range; i++) {
-				printf("\t[ ");
-				if (i < sizeof(alert_mask)) {
-					for (int j = 15; j >= 0; j--) {
-						switch (j % 16) {
-						case 4 ... 7:
-							if (i / 16)
-								printf("%3d ", 16 * (j % 16) + (i - 16));
-							break;
-						case 12 ... 15:
-							if (i / 16 && rev != 0x10)
-								if ((rev == 0x20 && is_rsdn)
-								     || rev == 0x21)
-									printf("%3d ",
-										16 * (j % 16) + (i - 16));
-							break;
-						case 0 ... 3:
-							if (i / 16 == 0)
-								printf("%3d ", 16 * (j % 16) + i);
-							break;
-						case 8 ... 11:
-							if (i / 16 == 0 && rev != 0x10)
-								printf("%3d ", 16 * (j % 16) + i);
-							break;
-						}
-					}
-				} else {
-					for (int j = 7; j >= 0; j--) {
-						printf("%3u ", 16 * j + (256 + (i - sizeof(alert_mask))));
-					}
+		} else {
+			for (int j = 7; j >= 0; j--)
+				printf("%3d ", 16 * j + (256 + (i - MAX_ALERT_REG)));
+		}
+		if (rev != 0x10)
+			if  (i > 15 && (!is_rsdn && rev !=0x21))
+				printf("] \t\t\t| %#4x\n", buffer[i]);
+			else
+				printf("] \t| %#4x\n", buffer[i]);
+		else
+			printf("]        \t\t| %#4x\n", buffer[i]);
+	}
+
+	range = regs.valid & BIT(SBRMI_REGS_ALERT_MASK) ?
+		regs.alert_count : 0;
+	buffer = regs.alert_mask;
+	if (range)
+		printf("_RMI_ALERTMASK [0x%x ~ 0x%x] [0x%x ~ 0x%x] \t|\n",
+		       SBRMI_ALERTMASK0, SBRMI_ALERTMASK15,
+		       SBRMI_ALERTMASK16, SBRMI_ALERTMASK31);
+	if (range && is_brhdn)
+		printf("\t       [0x%x ~ 0x%x] \t\t\t|\n",
+			SBRMI_ALERTMASK32, SBRMI_ALERTMASK47);
+	for (i = 0; i < range; i++) {
+		printf("\t[ ");
+		if (i < sizeof(alert_mask)) {
+			for (int j = 15; j >= 0; j--) {
+				switch (j % 16) {
+				case 4 ... 7:
+					if (i / 16)
+						printf("%3d ", 16 * (j % 16) + (i - 16));
+					break;
+				case 12 ... 15:
+					if (i / 16 && rev != 0x10)
+						if ((rev == 0x20 && is_rsdn)
+						     || rev == 0x21)
+							printf("%3d ",
+								16 * (j % 16) + (i - 16));
+					break;
+				case 0 ... 3:
+					if (i / 16 == 0)
+						printf("%3d ", 16 * (j % 16) + i);
+					break;
+				case 8 ... 11:
+					if (i / 16 == 0 && rev != 0x10)
+						printf("%3d ", 16 * (j % 16) + i);
+					break;
 				}
-				if (rev != 0x10)
-					if (i > 15 && (!is_rsdn && rev !=0x21))
-						printf("] \t\t\t| %#4x\n", buffer[i]);
-					else
-						printf("] \t| %#4x\n", buffer[i]);
-				else
-					printf("]        \t\t| %#4x\n", buffer[i]);
 			}
+		} else {
+			for (int j = 7; j >= 0; j--) {
+				printf("%3u ", 16 * j + (256 + (i - sizeof(alert_mask))));
+			}
+		}
+		if (rev != 0x10)
+			if (i > 15 && (!is_rsdn && rev !=0x21))
+				printf("] \t\t\t| %#4x\n", buffer[i]);
+			else
+				printf("] \t| %#4x\n", buffer[i]);
+		else
+			printf("]        \t\t| %#4x\n", buffer[i]);
 	}
-	free(buffer);
-	buffer = NULL;
 
-	usleep(APML_SLEEP);
-	range = SBRMI_OUTBNDMSG7 - SBRMI_OUTBNDMSG0 + 1;
-	buffer = malloc(range * sizeof(uint8_t));
-	if (!buffer)
-		return OOB_NO_MEMORY;
-	if (read_sbrmi_outbound_msg(soc_num, buffer) == 0) {
+	if (regs.valid & BIT(SBRMI_REGS_OUTBOUND)) {
 		printf("_RMI_OUTBOUNDMSG [0x%x ~ 0x%x]	\t\t|\n",
 		       SBRMI_OUTBNDMSG0, SBRMI_OUTBNDMSG7);
-		for (i = 0; i < range; i++)
-			printf("\tOUTBNDMSG[%d]	\t\t\t| %#4x\n", i, buffer[i]);
+		for (i = 0; i < SBRMI_MSG_REGS; i++)
+			printf("\tOUTBNDMSG[%d]	\t\t\t| %#4x\n", i,
+			       regs.outbound_msg[i]);
 	}
-	free(buffer);
-	buffer = NULL;
 
-	usleep(APML_SLEEP);
-	range = SBRMI_INBNDMSG7 - SBRMI_INBNDMSG0 + 1;
-	buffer = malloc(range * sizeof(uint8_t));
-	if (!buffer)
-		return OOB_NO_MEMORY;
-	if (read_sbrmi_inbound_msg(soc_num, buffer) == 0) {
+	if (regs.valid & BIT(SBRMI_REGS_INBOUND)) {
 		printf("_RMI_INBOUNDMSG [0x%x ~ 0x%x]	\t\t|\n",
 		       SBRMI_INBNDMSG0, SBRMI_INBNDMSG7);
-		for (i = 0; i < range; i++)
-			printf("\tINBNDMSG[%d]	\t\t\t| %#4x\n", i, buffer[i]);
+		for (i = 0; i < SBRMI_MSG_REGS; i++)
+			printf("\tINBNDMSG[%d]	\t\t\t| %#4x\n", i,
+			       regs.inbound_msg[i]);
 	}
-	free(buffer);
-	buffer = NULL;
 
-	usleep(APML_SLEEP);
-	if (read_sbrmi_swinterrupt(soc_num, &buf) == 0)
+	if (regs.valid & BIT(SBRMI_REGS_SW_INTERRUPT))
 		printf("_RMI_SWINTERRUPT [0x%x]	\t\t\t| %#4x\n",
-		       SBRMI_SOFTWAREINTERRUPT, buf);
+		       SBRMI_SOFTWAREINTERRUPT, regs.sw_interrupt);
 
-	usleep(APML_SLEEP);
-	if (rev == 0x10) {
-		if (read_sbrmi_threadnumber(soc_num, &buf) == 0)
-			printf("_RMI_THREADNUMEBER [0x%x]	\t\t| %#4x\n",
-			       SBRMI_THREADNUMBER, buf);
-	} else {
-		if (read_sbrmi_threadnumberlow(soc_num, &buf) == 0)
-			printf("_RMI_THREADNUMEBERLOW [0x%x]	\t\t| %#4x\n",
-			       SBRMI_THREADNUMBERLOW, buf);
-		if (read_sbrmi_threadnumberhi(soc_num, &buf) == 0)
-			printf("_RMI_THREADNUMEBERHIGH [0x%x]	\t\t| %#4x\n",
-			       SBRMI_THREADNUMBERHIGH, buf);
+	thread_num = regs.valid & BIT(SBRMI_REGS_THREAD_NUM);
+	if (thread_num && rev == 0x10) {
+		printf("_RMI_THREADNUMEBER [0x%x]	\t\t| %#4x\n",
+		       SBRMI_THREADNUMBER, regs.thread_number);
+	} else if (thread_num) {
+		printf("_RMI_THREADNUMEBERLOW [0x%x]	\t\t| %#4x\n",
+		       SBRMI_THREADNUMBERLOW, regs.thread_number_low);
+		printf("_RMI_THREADNUMEBERHIGH [0x%x]	\t\t| %#4x\n",
+		       SBRMI_THREADNUMBERHIGH, regs.thread_number_high);
 	}
 
-	usleep(APML_SLEEP);
-	if (read_sbrmi_thread_cs(soc_num, &buf) == 0)
+	if (regs.valid & BIT(SBRMI_REGS_THREAD_CS))
 		printf("_RMI_THREADCS [0x%x]	\t\t\t| %#4x\n",
-		       SBRMI_THREAD128CS, buf);
-
-	usleep(APML_SLEEP);
-	if (read_sbrmi_ras_status(soc_num, &buf) == 0)
+		       SBRMI_THREAD128CS, regs.thread_cs);
+	if (regs.valid & BIT(SBRMI_REGS_RAS_STATUS))
 		printf("_RMI_RASSTATUS [0x%x]	\t\t\t| %#4x\n",
-		       SBRMI_RASSTATUS, buf);
+		       SBRMI_RASSTATUS, regs.ras_status);
 
-	usleep(APML_SLEEP);
-	range = SBRMI_MP0OUTBNDMSG7 - SBRMI_MP0OUTBNDMSG0 + 1;
-	buffer = malloc(range * sizeof(uint8_t));
-	if (!buffer)
-		return OOB_NO_MEMORY;
-	if (read_sbrmi_mp0_msg(soc_num, buffer) == 0) {
+	if (regs.valid & BIT(SBRMI_REGS_MP0)) {
 		printf("_RMI_MP0 [0x%x ~ 0x%x]	\t\t\t|\n",
 		       SBRMI_MP0OUTBNDMSG0, SBRMI_MP0OUTBNDMSG7);
-		for (i = 0; i < range; i++)
-			printf("\tOUTBNDMSG[%d]	\t\t\t| %#4x\n", i, buffer[i]);
+		for (i = 0; i < SBRMI_MSG_REGS; i++)
+			printf("\tOUTBNDMSG[%d]	\t\t\t| %#4x\n", i,
+			       regs.mp0_msg[i]);
 	}
-	free(buffer);
-	buffer = NULL;
 	printf("------------------------------------------------------------"
 		"----\n");
 	return OOB_SUCCESS;
@@ -880,40 +805,19 @@ static oob_status_t get_apml_rmi_access(uint8_t soc_num)
 
 static oob_status_t get_apml_tsi_register_descriptions(uint8_t soc_num)
 {
-	float temp_value[3];
-	float dec;
-	float uprate;
-	uint8_t lowalert, hialert;
-	uint8_t al_mask, run_stop, read_ord, ara;
-	uint8_t timeout;
-	uint8_t intr;
-	int8_t intr_offset;
-	uint8_t id, buf;
-	bool is_sbtsi = false;
+	struct sbtsi_regs regs;
 	bool status = false;
 	oob_status_t ret;
 
 	ret = validate_apml_sbtsi_module(soc_num);
-	if (ret)
-		return ret;
-	intr = 0;
-	ret = read_sbtsi_max_hbm_temp_int(soc_num, &intr);
-	if (ret)
-		return ret;
-	if (intr)
-		status = true;
-	usleep(APML_SLEEP);
-	ret = sbtsi_get_cputemp(soc_num, &temp_value[0]);
 	if (ret)
 		return ret;
 
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_cpuinttemp(soc_num, &intr);
-	if (ret)
-		return ret;
-	ret = read_sbtsi_cputempdecimal(soc_num, &dec);
+	/* Every register once, through one device handle */
+	ret = sbtsi_read_all(soc_num, &regs);
 	if (ret)
 		return ret;
+	status = regs.hbm_valid;
 
 	printf("\n\t\t *** SB-TSI REGISTER SUMMARY ***\n");
 	printf("------------------------------------------------------------"
@@ -921,169 +825,90 @@ static oob_status_t get_apml_tsi_register_descriptions(uint8_t soc_num)
 	printf(" FUNCTION/Reg Name\t| Reg offset\t| Hexa(0x)\t| Value [Units]\n");
 	printf("------------------------------------------------------------"
 	       "-------------------------------\n");
-	printf("_PROCTEMP\t\t|\t\t|\t\t| %.3f °C\n", temp_value[0]);
+	printf("_PROCTEMP\t\t|\t\t|\t\t| %.3f °C\n", regs.cpu_temp);
 	printf("\tPROC_INT \t| 0x%x \t\t| 0x%-5x\t| %u °C\n", SBTSI_CPUTEMPINT,
-	       intr, intr);
+	       regs.cpu_temp_int, regs.cpu_temp_int);
 	printf("\tPROC_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n", SBTSI_CPUTEMPDEC,
-	       (uint8_t)(dec / TEMP_INC), dec);
+	       regs.cpu_temp_dec >> 5, (regs.cpu_temp_dec >> 5) * TEMP_INC);
 
-	usleep(APML_SLEEP);
-	ret = sbtsi_get_temp_status(soc_num, &lowalert, &hialert);
-	if (ret)
-		return ret;
 	printf("_STATUS\t\t\t| 0x%x \t\t|\t\t| \n", SBTSI_STATUS);
 	printf("\tPROC Temp Alert |\t\t|\t\t| ");
-	if (lowalert)
+	/* [4] temperature high alert, [3] temperature low alert */
+	if (regs.status & (1 << 3))
 		printf("PROC Temp Low Alert\n");
-	else if (hialert)
+	else if (regs.status & (1 << 4))
 		printf("PROC Temp Hi Alert\n");
 	else
 		printf("PROC No Temp Alert\n");
 
-	if (status) {
-		ret = get_hbm_temp_status(soc_num);
-		if (ret)
-			return ret;
-	}
-
-	usleep(APML_SLEEP);
-	ret = sbtsi_get_config(soc_num, &al_mask, &run_stop,
-			       &read_ord, &ara);
-	if (ret)
-		return ret;
+	if (status)
+		get_hbm_temp_status(regs.status);
 
 	printf("_CONFIG\t\t\t| 0x%x \t\t|\t\t| \n", SBTSI_CONFIGURATION);
-	printf("\tALERT_L pin\t|\t\t|\t\t| %s\n", al_mask ? "Disabled" : "Enabled");
-	printf("\tRunstop\t\t|\t\t|\t\t| %s\n", run_stop ? "Comparison Disabled" :
+	printf("\tALERT_L pin\t|\t\t|\t\t| %s\n",
+	       (regs.config & ALERTMASK_MASK) ? "Disabled" : "Enabled");
+	printf("\tRunstop\t\t|\t\t|\t\t| %s\n",
+	       (regs.config & RUNSTOP_MASK) ? "Comparison Disabled" :
 	       "Comparison Enabled");
-	printf("\tAtomic Rd order |\t\t|\t\t| %s\n", read_ord ? "Decimal Latches "
-	       "Integer" : "Integer latches Decimal");
+	printf("\tAtomic Rd order |\t\t|\t\t| %s\n",
+	       (regs.config & READORDER_MASK) ? "Decimal Latches Integer" :
+	       "Integer latches Decimal");
 	if (!status)
-		printf("\tARA response\t|\t\t|\t\t| %s\n", ara ? "Disabled"
-		       : "Enabled");
+		printf("\tARA response\t|\t\t|\t\t| %s\n",
+		       (regs.config & ARA_MASK) ? "Disabled" : "Enabled");
 
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_updaterate(soc_num, &uprate);
-	if (ret)
-		return ret;
 	printf("_TSI_UPDATERATE \t| 0x%x \t\t|\t\t| %.3f Hz\n", SBTSI_UPDATERATE,
-	       uprate);
+	       regs.update_rate_hz);
 
-	usleep(APML_SLEEP);
-	ret = sbtsi_get_hitemp_threshold(soc_num, &temp_value[1]);
-	if (ret)
-		return ret;
-
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_hitempint(soc_num, &intr);
-	if (ret)
-		return ret;
-
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_hitempdecimal(soc_num, &dec);
-	if (ret)
-		return ret;
-
-	printf("_HIGH_THRESHOLD_TEMP\t|\t\t|\t\t| %.3f °C\n", temp_value[1]);
+	printf("_HIGH_THRESHOLD_TEMP\t|\t\t|\t\t| %.3f °C\n",
+	       regs.hi_temp_thr);
 	printf("\tHIGH_INT \t| 0x%x \t\t| 0x%-5x\t| %u °C\n", SBTSI_HITEMPINT,
-	       intr, intr);
+	       regs.hi_temp_int, regs.hi_temp_int);
 	printf("\tHIGH_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n", SBTSI_HITEMPDEC,
-	       (uint8_t)(dec / TEMP_INC), dec);
+	       regs.hi_temp_dec >> 5, (regs.hi_temp_dec >> 5) * TEMP_INC);
 
-	usleep(APML_SLEEP);
-	ret = sbtsi_get_lotemp_threshold(soc_num, &temp_value[2]);
-	if (ret)
-		return ret;
-
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_lotempint(soc_num, &intr);
-	if (ret)
-		return ret;
-	ret = read_sbtsi_lotempdecimal(soc_num, &dec);
-	if (ret)
-		return ret;
-	printf("_LOW_THRESHOLD_TEMP\t|\t\t|\t\t| %.3f °C\n", temp_value[2]);
+	printf("_LOW_THRESHOLD_TEMP\t|\t\t|\t\t| %.3f °C\n", regs.lo_temp_thr);
 	printf("\tLOW_INT \t| 0x%x \t\t| 0x%-5x\t| %u °C\n", SBTSI_LOTEMPINT,
-	       intr, intr);
+	       regs.lo_temp_int, regs.lo_temp_int);
 	printf("\tLOW_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n", SBTSI_LOTEMPDEC,
-	       (uint8_t)(dec / TEMP_INC), dec);
+	       regs.lo_temp_dec >> 5, (regs.lo_temp_dec >> 5) * TEMP_INC);
 
 	if (status)
-	{
-		ret = get_apml_mi300_tsi_register_descriptions(soc_num);
-		if (ret)
-			return ret;
-	}
-
-	ret = read_sbtsi_cputempoffset(soc_num, &dec);
-	if (ret)
-		return ret;
-	printf("_TEMP_OFFSET\t\t|\t\t|\t\t| %.3f °C\n", dec);
-
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_cputempoffint(soc_num, &intr_offset);
-	if (ret)
-		return ret;
+		get_apml_mi300_tsi_register_descriptions(&regs);
 
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_cputempoffdec(soc_num, &dec);
-	if (ret)
-		return ret;
+	printf("_TEMP_OFFSET\t\t|\t\t|\t\t| %.3f °C\n", regs.temp_offset);
 	printf("\tOFF_INT \t| 0x%x \t\t| 0x%-5x\t| %u °C\n",
-	       SBTSI_CPUTEMPOFFINT, intr_offset, intr_offset);
+	       SBTSI_CPUTEMPOFFINT, (int8_t)regs.temp_off_int,
+	       (int8_t)regs.temp_off_int);
 	printf("\tOFF_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n",
-	       SBTSI_CPUTEMPOFFDEC, (uint8_t)(dec / TEMP_INC), dec);
+	       SBTSI_CPUTEMPOFFDEC, regs.temp_off_dec >> 5,
+	       (regs.temp_off_dec >> 5) * TEMP_INC);
 
-	usleep(APML_SLEEP);
-	if (!status) {
-		ret = sbtsi_get_timeout(soc_num, &timeout);
-		if (ret)
-			return ret;
+	if (!status)
 		printf("_TIMEOUT_CONFIG \t| 0x%x \t\t|\t\t| %s\n",
-		       SBTSI_TIMEOUTCONFIG, timeout ? "Enabled" : "Disabled");
-	}
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_alertthreshold(soc_num, &buf);
-	if (ret)
-		return ret;
+		       SBTSI_TIMEOUTCONFIG,
+		       (regs.timeout_config & (1 << 7)) ? "Enabled" :
+		       "Disabled");
 	printf("_THRESHOLD_SAMPLE\t| 0x%x \t\t|\t\t| \n",
 	       SBTSI_ALERTTHRESHOLD);
-	printf("\tPROC Alert TH \t|\t\t|\t\t| %u\n", buf);
-	if (status) {
-		ret = read_sbtsi_hbm_alertthreshold(soc_num, &buf);
-		if (ret)
-			return ret;
-		printf("\tHBM Alert TH \t|\t\t|\t\t| %u\n", buf);
-	}
+	printf("\tPROC Alert TH \t|\t\t|\t\t| %u\n", regs.alert_samples);
+	if (status)
+		printf("\tHBM Alert TH \t|\t\t|\t\t| %u\n",
+		       regs.hbm_alert_samples);
 
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_alertconfig(soc_num, &buf);
-	if (ret)
-		return ret;
 	printf("_TSI_ALERT_CONFIG\t| 0x%x \t\t|\t\t| \n",
 	       SBTSI_ALERTCONFIG);
+	/* [0] Alert comparator mode, [1] HBM alert config */
 	printf("\tPROC Alert CFG \t|\t\t|\t\t| %s\n",
-	       buf ? "Enabled" : "Disabled");
-	if (status) {
-		usleep(APML_SLEEP);
-		ret = get_sbtsi_hbm_alertconfig(soc_num, &buf);
-		if (ret)
-			return ret;
+	       (regs.alert_config & BIT(0)) ? "Enabled" : "Disabled");
+	if (status)
 		printf("\tHBM Alert CFG \t|\t\t|\t\t| %s\n",
-		       buf ? "Enabled" : "Disabled");
-	}
+		       (regs.alert_config & BIT(1)) ? "Enabled" : "Disabled");
 
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_manufid(soc_num, &id);
-	if (ret)
-		return ret;
-	printf("_TSI_MANUFACTURE_ID\t| 0x%x \t\t|\t\t| %#x\n", SBTSI_MANUFID, id);
-
-	usleep(APML_SLEEP);
-	ret = read_sbtsi_revision(soc_num, &id);
-	if (ret)
-		return ret;
-	printf("_TSI_REVISION \t\t| 0x%x \t\t|\t\t| %#x\n", SBTSI_REVISION, id);
+	printf("_TSI_MANUFACTURE_ID\t| 0x%x \t\t|\t\t| %#x\n", SBTSI_MANUFID,
+	       regs.manuf_id & 1);
+	printf("_TSI_REVISION \t\t| 0x%x \t\t|\t\t| %#x\n", SBTSI_REVISION,
+	       regs.revision);
 
 	printf("------------------------------------------------------------"
 	       "-----------------------\n");
@@ -1226,6 +1051,134 @@ static void apml_get_ras_mca_msr(uint8_t soc_num, struct mca_bank mca_dump)
 	printf("---------------------------------------\n");
 }
 
+static void apml_dump_mca_banks(uint8_t soc_num)
+{
+	struct apml_mca_regs regs;
+	struct apml_mca_info info;
+	struct apml_mca_dump *dump;
+	uint16_t bytespermca, numbanks;
+	uint8_t p_type;
+	uint32_t len, written, dwords, i, j;
+	oob_status_t ret;
+
+	ret = read_bmc_ras_mca_validity_check(soc_num,
+					      &bytespermca, &numbanks);
+	if (ret != OOB_SUCCESS) {
+		printf("Failed to get MCA banks with valid status "
+			"after a fatal error, Err[%d]:%s\n",
+			ret, esmi_get_err_msg(ret));
+		return;
+	}
+
+	len = sizeof(*dump) + (uint32_t)numbanks * bytespermca;
+	dump = malloc(len);
+	if (!dump) {
+		printf("Failed to allocate %u bytes\n", len);
+		return;
+	}
+	ret = apml_ras_dump_mca(soc_num, dump, len, &written);
+	if (ret != OOB_SUCCESS)
+		printf("Failed to dump MCA banks, %u of %u banks read, "
+		       "Err[%d]:%s\n", written < sizeof(*dump) ? 0 :
+		       dump->banks_done, numbanks, ret, esmi_get_err_msg(ret));
+	if (written >= sizeof(*dump) && dump->add_err)
+		printf("Bank %u additional error data 0x%x\n",
+		       dump->banks_done, dump->add_err_data);
+	if (written < sizeof(*dump) || !dump->banks_done) {
+		free(dump);
+		return;
+	}
+
+	dwords = dump->bytes_per_mca / sizeof(uint32_t);
+	printf("---------------------------------------\n");
+	printf("| Bank | Offset | Data                |\n");
+	printf("---------------------------------------\n");
+	for (i = 0; i < dump->banks_done; i++)
+		for (j = 0; j < dwords; j++)
+			printf("| %-4u | 0x%-4x | 0x%-17x |\n", i, j * 4,
+			       dump->data[i * dwords + j]);
+	printf("---------------------------------------\n");
+
+	if (get_proc_type(soc_num, &p_type)) {
+		free(dump);
+		return;
+	}
+	printf("-------------------------------------------------------"
+	       "----------------------\n");
+	printf("| Bank | Type\t\t\t\t  | Code   | Ext  | Flags      |\n");
+	printf("-------------------------------------------------------"
+	       "----------------------\n");
+	for (i = 0; i < dump->banks_done; i++) {
+		apml_mca_regs_from_dump(&dump->data[i * dwords],
+					dump->bytes_per_mca, &regs);
+		if (apml_mca_decode(p_type, &regs, &info))
+			break;
+		printf("| %-4u | %-32s | 0x%04x | 0x%02x | %s%s%s%s%s%s |\n",
+		       i, apml_mca_bank_name(info.type), info.error_code,
+		       info.error_code_ext, info.valid ? "V" : "-",
+		       info.uc ? "U" : "-", info.pcc ? "P" : "-",
+		       info.deferred ? "D" : "-", info.poison ? "X" : "-",
+		       info.overflow ? "O    " : "-    ");
+		if (info.addr_valid)
+			printf("|      | Address 0x%-16llx (lsb %u)\n",
+			       (unsigned long long)info.addr, info.addr_lsb);
+		if (info.synd_valid)
+			printf("|      | Syndrome 0x%-8x (%u bits)\n",
+			       info.syndrome, info.synd_len);
+	}
+	printf("-------------------------------------------------------"
+	       "----------------------\n");
+	free(dump);
+}
+
+static void apml_dump_df_errors(uint8_t soc_num)
+{
+	struct apml_df_check check;
+	struct apml_df_log *log;
+	uint32_t written, pos, i;
+	oob_status_t ret;
+	uint8_t *buf;
+
+	ret = apml_ras_df_check(soc_num, &check);
+	if (ret != OOB_SUCCESS) {
+		printf("Failed to read RAS DF validity check, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		return;
+	}
+	if (!check.size) {
+		printf("No DF error logs to report\n");
+		return;
+	}
+
+	buf = malloc(check.size);
+	if (!buf) {
+		printf("Failed to allocate %u bytes\n", check.size);
+		return;
+	}
+	ret = apml_ras_dump_df_until(soc_num, &check, buf, check.size,
+				     &written, NULL);
+	if (ret != OOB_SUCCESS)
+		printf("Failed to dump DF error logs, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+
+	printf("----------------------------------------------\n");
+	printf("| Block | Inst | Offset | Data               |\n");
+	printf("----------------------------------------------\n");
+	for (pos = 0; pos < written; pos += sizeof(*log) + log->len) {
+		log = (struct apml_df_log *)(buf + pos);
+		for (i = 0; i < log->len / 4; i++)
+			printf("| %-5u | %-4u | 0x%-4x | 0x%-16x |\n",
+			       log->block_id, log->instance, i * 4,
+			       log->data[i]);
+		if (log->add_err)
+			printf("| %-5u | %-4u | Additional error data 0x%-8x |\n",
+			       log->block_id, log->instance,
+			       log->add_err_data);
+	}
+	printf("----------------------------------------------\n");
+	free(buf);
+}
+
 static void apml_get_fch_reset_reason(uint8_t soc_num, uint32_t fchid)
 {
 	uint32_t buffer;
@@ -1725,6 +1678,60 @@ static void apml_get_core_energy(uint8_t soc_num, uint32_t thread)
 	printf("----------------------------------------------\n");
 }
 
+static void apml_show_core_power_map(uint8_t soc_num)
+{
+	struct rapl_core_energy *e0, *e1;
+	struct apml_thread_mask enabled;
+	struct timespec t0, t1;
+	uint32_t *cores, count = 0, i;
+	oob_status_t ret;
+	double secs;
+	int thread;
+
+	ret = sbrmi_get_thread_masks(soc_num, &enabled, NULL, NULL);
+	if (ret) {
+		printf("Failed to get the enabled threads, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		return;
+	}
+	cores = calloc(APML_THREAD_MASK_WORDS * 64, sizeof(*cores));
+	e0 = calloc(APML_THREAD_MASK_WORDS * 64, sizeof(*e0));
+	e1 = calloc(APML_THREAD_MASK_WORDS * 64, sizeof(*e1));
+	if (!cores || !e0 || !e1) {
+		printf("Failed to allocate the power map\n");
+		goto out;
+	}
+	apml_for_each_thread(thread, &enabled)
+		cores[count++] = thread;
+
+	/* Two sweeps one second apart */
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ret = read_rapl_core_energy_sweep(soc_num, cores, count, e0);
+	if (!ret) {
+		sleep(1);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		ret = read_rapl_core_energy_sweep(soc_num, cores, count, e1);
+	}
+	if (ret) {
+		printf("Failed to sweep core energy, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		goto out;
+	}
+	secs = t1.tv_sec - t0.tv_sec + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	printf("----------------------------------------------\n");
+	printf("| Core\t\t | Power (W)\t\t     |\n");
+	printf("----------------------------------------------\n");
+	for (i = 0; i < count; i++)
+		printf("| Core[%03u]\t | %-17.3f\t     |\n", cores[i],
+		       (e1[i].joules - e0[i].joules) / secs);
+	printf("----------------------------------------------\n");
+out:
+	free(cores);
+	free(e0);
+	free(e1);
+}
+
 static void apml_get_pkg_energy(uint8_t soc_num)
 {
 	double buffer;
@@ -2166,6 +2173,7 @@ static void apml_get_smt_status(uint8_t soc_num)
 
 static void apml_get_threads_per_core_and_soc(uint8_t soc_num)
 {
+	struct sbrmi_thread_summary summary;
 	uint32_t threads_per_core, threads_per_soc;
 	oob_status_t ret;
 
@@ -2186,6 +2194,13 @@ static void apml_get_threads_per_core_and_soc(uint8_t soc_num)
 	printf("-----------------------------------------------\n");
 	printf("| THREADS PER CORE \t | %17d  |\n", threads_per_core);
 	printf("| THREADS PER SOCKET \t | %17d  |\n", threads_per_soc);
+	if (!sbrmi_get_thread_summary(soc_num, &summary)) {
+		printf("| THREADS ONLINE \t | %17d  |\n", summary.online);
+		printf("| ALERTS PENDING \t | %17d  |\n",
+		       summary.alerts_pending);
+		printf("| ALERTS UNMASKED \t | %17d  |\n",
+		       summary.alerts_unmasked);
+	}
 	printf("-----------------------------------------------\n");
 }
 
@@ -2764,6 +2779,245 @@ static void apml_get_ch_dram_throttle(uint8_t soc_num, uint8_t dimm_addr)
         printf("-------------------------------------------------\n");
 }
 
+static void apml_show_mailbox_caps(uint8_t soc_num)
+{
+	struct apml_cap_map map;
+	oob_status_t ret;
+	uint32_t cmd;
+	int count = 0;
+
+	ret = apml_cap_probe(soc_num);
+	if (!ret)
+		ret = apml_cap_get_map(soc_num, &map);
+	if (ret) {
+		printf("Failed to probe mailbox capabilities, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		return;
+	}
+	ret = apml_cap_save(soc_num, NULL);
+	if (ret)
+		printf("Failed to save mailbox capabilities, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+
+	printf("-----------------------------------------------\n");
+	printf("| PPIN\t\t\t | 0x%-16llx |\n",
+	       (unsigned long long)map.ppin);
+	printf("| SMU FW VERSION\t | 0x%-16x |\n", map.smu_fw_ver);
+	printf("-----------------------------------------------\n");
+	printf("| Supported mailbox commands\t\t      |\n");
+	for (cmd = 0; cmd < APML_CAP_CMD_MAX; cmd++) {
+		if (apml_cap_get(soc_num, cmd) != APML_CAP_SUPPORTED)
+			continue;
+		printf("%s 0x%02x", (count % 8) ? "" : "\n|", cmd);
+		count++;
+	}
+	printf("\n-----------------------------------------------\n");
+}
+
+/* Average time in us of count reads of temperature and power */
+static void bench_read_path(uint8_t soc_num, uint32_t count,
+			    double *temp_us, double *power_us)
+{
+	struct timespec start, end;
+	uint32_t i, power;
+	float temp;
+
+	*temp_us = -1;
+	*power_us = -1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; i++)
+		if (sbtsi_get_cputemp(soc_num, &temp))
+			break;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (i == count)
+		*temp_us = ((end.tv_sec - start.tv_sec) * 1e6 +
+			    (end.tv_nsec - start.tv_nsec) / 1e3) / count;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; i++)
+		if (read_socket_power(soc_num, &power))
+			break;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (i == count)
+		*power_us = ((end.tv_sec - start.tv_sec) * 1e6 +
+			     (end.tv_nsec - start.tv_nsec) / 1e3) / count;
+}
+
+static void apml_bench_hwmon(uint8_t soc_num, uint32_t count)
+{
+	double hw_temp, hw_power, io_temp, io_power;
+	oob_status_t ret;
+
+	if (!count)
+		count = 100;
+
+	ret = apml_hwmon_open();
+	if (ret) {
+		printf("Failed to open hwmon backend, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		return;
+	}
+	bench_read_path(soc_num, count, &hw_temp, &hw_power);
+	apml_hwmon_close();
+	bench_read_path(soc_num, count, &io_temp, &io_power);
+
+	printf("-----------------------------------------------\n");
+	printf("| Avg read time (us)\t | hwmon\t | ioctl\t|\n");
+	printf("-----------------------------------------------\n");
+	printf("| Temperature\t\t | %-9.1f | %-9.1f |\n",
+	       hw_temp, io_temp);
+	printf("| Power\t\t\t | %-9.1f | %-9.1f |\n",
+	       hw_power, io_power);
+	printf("-----------------------------------------------\n");
+	printf("Reads: %u, -1.0 marks a failed or unavailable path\n", count);
+
+	/* Restore the backend for the remaining options */
+	apml_hwmon_open();
+}
+
+static void apml_sample_temp(uint8_t soc_num, uint32_t count)
+{
+	struct apml_temp_sample smp;
+	uint64_t period_us;
+	oob_status_t ret;
+	uint32_t n, i = 0, idle = 0;
+	double start = 0;
+
+	if (!count)
+		count = 10;
+
+	ret = apml_sampler_start(soc_num, NULL);
+	if (!ret)
+		ret = apml_sampler_period(soc_num, &period_us);
+	if (ret) {
+		printf("Failed to start thermal sampler, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		return;
+	}
+
+	printf("-----------------------------------------------\n");
+	printf("| Sample\t | Time (s)\t | Temp (°C)\t|\n");
+	printf("-----------------------------------------------\n");
+	while (i < count) {
+		ret = apml_sampler_read(soc_num, &smp, 1, &n);
+		if (ret)
+			break;
+		if (!n) {
+			/* Polled every half period */
+			if (++idle > 2 * SAMPLE_IDLE_PERIODS) {
+				printf("No sample in %d update periods\n",
+				       SAMPLE_IDLE_PERIODS);
+				break;
+			}
+			usleep(period_us / 2);
+			continue;
+		}
+		idle = 0;
+		if (!i)
+			start = smp.ts.tv_sec + smp.ts.tv_nsec / 1e9;
+		printf("| %-9llu\t | %-9.3f\t | %-9.3f\t|\n",
+		       (unsigned long long)smp.seq,
+		       smp.ts.tv_sec + smp.ts.tv_nsec / 1e9 - start, smp.temp);
+		i++;
+	}
+	printf("-----------------------------------------------\n");
+	printf("Sampling period: %llu us\n", (unsigned long long)period_us);
+	apml_sampler_stop(soc_num);
+}
+
+static void apml_show_core_freq(uint8_t soc_num)
+{
+	struct apml_freq_snapshot *snap;
+	oob_status_t ret;
+	uint32_t i, wait;
+
+	snap = malloc(sizeof(*snap));
+	if (!snap) {
+		printf("Failed to allocate the frequency snapshot\n");
+		return;
+	}
+	ret = apml_freq_start(soc_num, NULL);
+	if (ret) {
+		printf("Failed to start frequency sampler, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		free(snap);
+		return;
+	}
+	/* Two sweeps are needed for the first deltas */
+	for (wait = 0; wait < 20; wait++) {
+		ret = apml_freq_read(soc_num, snap);
+		if (ret != OOB_TRY_AGAIN)
+			break;
+		usleep(500000);
+	}
+	apml_freq_stop(soc_num);
+	if (ret) {
+		printf("Failed to read frequency snapshot, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		free(snap);
+		return;
+	}
+
+	printf("-----------------------------------------------------\n");
+	printf("| CCX\t | Threads\t | Freq (MHz)\t | C0 (%%)\t|\n");
+	printf("-----------------------------------------------------\n");
+	for (i = 0; i < snap->ccx_count; i++) {
+		if (!snap->ccx[i].threads)
+			continue;
+		printf("| %-5u\t | %-9u\t | %-9u\t | %-9.1f\t|\n", i,
+		       snap->ccx[i].threads, snap->ccx[i].freq_mhz,
+		       snap->ccx[i].c0 * 100);
+	}
+	printf("-----------------------------------------------------\n");
+	printf("Threads sampled: %u of %u, period: %u us, MPERF: %u MHz\n",
+	       apml_thread_mask_count(&snap->valid), snap->threads,
+	       snap->period_us, snap->ref_mhz);
+	free(snap);
+}
+
+static void apml_show_topology(uint8_t soc_num)
+{
+	const struct apml_topo_ccx *ccx;
+	const struct apml_topo_core *core;
+	struct apml_topo *topo;
+	oob_status_t ret;
+	uint32_t d, x, c, s;
+
+	topo = malloc(sizeof(*topo));
+	if (!topo) {
+		printf("Failed to allocate the topology map\n");
+		return;
+	}
+	ret = apml_topo_build(soc_num, topo);
+	if (ret) {
+		printf("Failed to build the topology map, Err[%d]:%s\n",
+		       ret, esmi_get_err_msg(ret));
+		free(topo);
+		return;
+	}
+
+	printf("CCDs: %u%s, CCXs: %u, cores: %u, threads: %u\n",
+	       topo->ccds, topo->ccd_from_cpuid ? "" : " (one CCX per CCD)",
+	       topo->ccxs, topo->cores, topo->threads);
+	for (d = 0; d < topo->ccds; d++) {
+		printf("CCD %u\n", d);
+		for (x = 0; x < topo->ccd[d].ccxs; x++) {
+			ccx = &topo->ccx[topo->ccd[d].first_ccx + x];
+			printf("  CCX %u:", topo->ccd[d].first_ccx + x);
+			for (c = 0; c < ccx->cores; c++) {
+				core = &topo->core[ccx->first_core + c];
+				printf(" [");
+				for (s = 0; s < core->threads; s++)
+					printf(s ? " %u" : "%u",
+					       core->thread[s]);
+				printf("]");
+			}
+			printf("\n");
+		}
+	}
+	free(topo);
+}
+
 static void show_usage(char *exe_name)
 {
 	printf("Usage: %s [soc_num] [Option<s> / [--help] "
@@ -2825,6 +3079,8 @@ static void fam_19_mod_10_mailbox_commands(void)
 	       "  --showrasmcamsr\t\t\t  [MCA_BANK_INDEX][OFFSET]"
 	       "\t\t Show 32 bit data from specified MCA bank and "
 	       "offset\n"
+	       "  --dumpmcabanks\t\t\t\t\t\t\t\t "
+	       "Dump every MCA bank with valid status\n"
 	       "  --showfchresetreason\t\t\t  [FCHID(0 or 1)]\t\t"
 	       "\t Show previous reset reason from FCH register\n"
 	       "  --showdimmtemprangeandrefreshrate\t  [DIMM_ADDR]"
@@ -2892,6 +3148,10 @@ static void fam_19_mod_10_mailbox_commands(void)
 	       "Override delay reset cpu on sync flood\n"
 	       "  --rasresetonsyncflood\t\t\t \t\t\t\t\t "
 	       "Request warm reset after sync flood\n"
+	       "  --dumpdferrors\t\t\t\t\t\t\t\t "
+	       "Dump every DF error log\n"
+	       "  --showcorepowermap\t\t\t\t\t\t\t "
+	       "Show the power of every core over one second\n"
 	       "  --showrasdferrvaliditycheck\t\t  [DF_BLOCK_ID]\t\t\t\t "
 	       "Show RAS DF error validity check for a given blockID\n"
 	       "  --showrasdferrdump\t\t\t  [OFFSET][BLK_ID][BLK_INST]\t\t "
@@ -2983,7 +3243,9 @@ static void get_common_mailbox_commands(char *exe_name)
 	       "  --showddrbandwidth\t\t\t\t\t\t\t\t Show "
 	       "DDR Bandwidth of a system\n"
 	       "  --showpowerconsumed\t\t\t  \t\t\t\t\t "
-	       "Show consumed power\n", exe_name);
+	       "Show consumed power\n"
+	       "  --showmailboxcaps\t\t\t  \t\t\t\t\t "
+	       "Probe and cache supported mailbox commands\n", exe_name);
 }
 
 static void get_rmi_commands(char *exe_name)
@@ -3028,7 +3290,13 @@ static void get_tsi_commands(char *exe_name)
 	       "  --setreadorder\t\t	  [VALUE]\t\t\t\t "
 	       "Set/Reset APML processor read order, VALUE = 0 or 1\n"
 	       "  --setara\t\t\t	  [VALUE]\t\t\t\t "
-	       "Set/Reset APML processor ARA, VALUE = 0 or 1\n", exe_name);
+	       "Set/Reset APML processor ARA, VALUE = 0 or 1\n"
+	       "  --benchhwmon\t\t\t	  [COUNT]\t\t\t\t "
+	       "Compare hwmon and ioctl read times over COUNT reads, "
+	       "COUNT is required\n"
+	       "  --sampletemp\t\t\t	  [COUNT]\t\t\t\t "
+	       "Sample COUNT temperatures at the sensor update rate\n",
+	       exe_name);
 }
 
 static void get_reg_access_commands(char *exe_name)
@@ -3051,7 +3319,11 @@ static void get_reg_access_commands(char *exe_name)
 	       "  --readmsrregister\t\t\t  [REGISTER(hex)]"
 	       "[thread]\t\t\t Read MSR register\n"
 	       "  --readcpuidregister\t\t\t  [FUN(hex)]"
-	       "[EXT_FUN(hex)][thread]\t\t Read CPUID register\n", exe_name);
+	       "[EXT_FUN(hex)][thread]\t\t Read CPUID register\n"
+	       "  --showcorefreq\t\t\t\t\t\t\t\t "
+	       "Show CCX effective frequency from APERF/MPERF\n"
+	       "  --showtopology\t\t\t\t\t\t\t\t "
+	       "Show CCD, CCX, core and thread hierarchy\n", exe_name);
 }
 
 static void get_cpuid_access_commands(char *exe_name)
@@ -3559,6 +3831,8 @@ static oob_status_t parseesb_args(int argc, char **argv)
 		{"setrunstop",		required_argument,	&flag,	1209},
 		{"setreadorder",	required_argument,	&flag,	1210},
 		{"setara",		required_argument,	&flag,	1211},
+		{"benchhwmon",		required_argument,	&flag,	1212},
+		{"sampletemp",		required_argument,	&flag,	1213},
 		{"setdimmpower",			required_argument,	0,	'P'},
 		{"setdimmthermalsensor",		required_argument,	0,	'T'},
 		{"showdimmpower",			required_argument,	0,	'O'},
@@ -3634,6 +3908,12 @@ static oob_status_t parseesb_args(int argc, char **argv)
 		{"getdfcenable",		no_argument,		&flag,	62},
                 {"getavgdramthrottle",          no_argument,            &flag,  63},
                 {"getchdramthrottle",           required_argument,      &flag,  64},
+		{"showmailboxcaps",		no_argument,		&flag,	65},
+		{"dumpmcabanks",		no_argument,		&flag,	66},
+		{"dumpdferrors",		no_argument,		&flag,	67},
+		{"showcorefreq",		no_argument,		&flag,	68},
+		{"showtopology",		no_argument,		&flag,	69},
+		{"showcorepowermap",		no_argument,		&flag,	70},
 		{0,			0,			0,	0},
 	};
 
@@ -3759,7 +4039,9 @@ static oob_status_t parseesb_args(int argc, char **argv)
 			 (*long_options[long_index].flag) == 1208 ||
 			 (*long_options[long_index].flag) == 1209 ||
 			 (*long_options[long_index].flag) == 1210 ||
-			 (*long_options[long_index].flag) == 1211)) {
+			 (*long_options[long_index].flag) == 1211 ||
+			 (*long_options[long_index].flag) == 1212 ||
+			 (*long_options[long_index].flag) == 1213)) {
 		// make sure optind is valid  ... or another option
 		if ((optind - 1) >= argc) {
 			printf("\nOption '-%c' require an argument"
@@ -4310,6 +4592,30 @@ static oob_status_t parseesb_args(int argc, char **argv)
 			dimm_addr = strtoul(argv[optind - 1], &end, 16);
                         apml_get_ch_dram_throttle(soc_num, dimm_addr);
                         break;
+		} else if (*(long_options[long_index].flag) == 65) {
+			/* Probe and cache the supported mailbox commands */
+			apml_show_mailbox_caps(soc_num);
+			break;
+		} else if (*(long_options[long_index].flag) == 66) {
+			/* Dump every valid MCA bank in one batch */
+			apml_dump_mca_banks(soc_num);
+			break;
+		} else if (*(long_options[long_index].flag) == 67) {
+			/* Dump every DF error log in batches */
+			apml_dump_df_errors(soc_num);
+			break;
+		} else if (*(long_options[long_index].flag) == 68) {
+			/* Sample APERF/MPERF of every enabled thread */
+			apml_show_core_freq(soc_num);
+			break;
+		} else if (*(long_options[long_index].flag) == 69) {
+			/* Map the threads to cores, CCXs and CCDs */
+			apml_show_topology(soc_num);
+			break;
+		} else if (*(long_options[long_index].flag) == 70) {
+			/* Sweep the RAPL counters of every enabled core */
+			apml_show_core_power_map(soc_num);
+			break;
 		} else if (*(long_options[long_index].flag) == 1201) {
 			uprate = atof(argv[optind - 1]);
 			set_and_verify_apml_socket_uprate(soc_num, uprate);
@@ -4358,6 +4664,14 @@ static oob_status_t parseesb_args(int argc, char **argv)
 			set_tsi_config(soc_num, value,
 				       *long_options[long_index].flag);
 			break;
+		} else if (*(long_options[long_index].flag) == 1212) {
+			value = atoi(argv[optind - 1]);
+			apml_bench_hwmon(soc_num, value);
+			break;
+		} else if (*(long_options[long_index].flag) == 1213) {
+			value = atoi(argv[optind - 1]);
+			apml_sample_temp(soc_num, value);
+			break;
 		}
 		break;
 	case 'Y':
@@ -4578,6 +4892,7 @@ static void rerun_sudo(int argc, char **argv)
  */
 int main(int argc, char **argv)
 {
+	struct apml_init_opts opts = {0};
 	uint32_t soc_num;
 	oob_status_t ret;
 
@@ -4586,8 +4901,18 @@ int main(int argc, char **argv)
 
 	show_smi_message();
 
+	/*
+	 * Discover sockets on first use, backed by the inventory cache,
+	 * and read temperature and power from hwmon when available
+	 */
+	opts.mode = APML_INIT_LAZY;
+	opts.use_cache_file = true;
+	opts.use_hwmon = true;
+	apml_init(&opts);
+
 	/* Parse command arguments */
 	ret = parseesb_args(argc, argv);
+	apml_fini();
 	if (ret)
 		return ret;
 
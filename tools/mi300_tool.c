@@ -59,14 +59,8 @@
 static int flag;
 #define APML_SLEEP 10000
 
-oob_status_t get_hbm_temp_status(uint8_t soc_num)
+void get_hbm_temp_status(uint8_t reg_val)
 {
-	uint8_t reg_val;
-	oob_status_t ret;
-
-	ret = read_sbtsi_status(soc_num, &reg_val);
-	if (ret)
-		return ret;
 	printf("\tMem Temp Alert  |\t\t|\t\t|");
 	if (reg_val >> 6 & 1)
 		printf(" HBM High Temp Alert\n");
@@ -76,8 +70,6 @@ oob_status_t get_hbm_temp_status(uint8_t soc_num)
 		printf(" No HBM Temp Alert\n");
 	else
 		printf("HBM High and Low Temp Alert\n");
-
-	return ret;
 }
 
 static void apml_get_hbm_throttle(uint8_t soc_num)
@@ -1217,70 +1209,41 @@ void get_mi300_tsi_commands(char *exec_name)
 	       "Set/Reset APML processor read order, VALUE = 0 or 1\n", exec_name);
 }
 
-oob_status_t get_apml_mi300_tsi_register_descriptions(uint8_t soc_num) {
-	float temp_value = 0;
-	oob_status_t ret;
-
-	ret = read_sbtsi_hbm_hi_temp_th(soc_num, &temp_value);
-	if (ret)
-		return ret;
-
+void get_apml_mi300_tsi_register_descriptions(const struct sbtsi_regs *regs)
+{
 	printf("_HBM_HIGH_THRESHOLD_TEMP|\t\t|\t\t| %.3f °C\n",
-	       temp_value);
+	       regs->hbm_hi_temp_thr);
 	printf("\tHIGH_INT  \t| 0x%x \t\t| 0x%-5x\t| %u °C\n",
 	       SBTSI_HBM_HITEMPINT_LIMIT,
-	       (int)(temp_value), (int)(temp_value));
+	       regs->hbm_hi_temp_int, regs->hbm_hi_temp_int);
 	printf("\tHIGH_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n",
-	       SBTSI_HBM_HITEMPDEC_LIMIT,
-	       (uint8_t)((temp_value - floor(temp_value)) / TEMP_INC),
-	       temp_value - floor(temp_value));
+	       SBTSI_HBM_HITEMPDEC_LIMIT, regs->hbm_hi_temp_dec >> 5,
+	       (regs->hbm_hi_temp_dec >> 5) * TEMP_INC);
 
-	temp_value = 0;
-	ret = read_sbtsi_hbm_lo_temp_th(soc_num, &temp_value);
-	if (ret)
-		return ret;
-
-	printf("_HBM_LOW_THRESHOLD_TEMP |\t\t|\t\t| %.3f °C\n", temp_value);
+	printf("_HBM_LOW_THRESHOLD_TEMP |\t\t|\t\t| %.3f °C\n",
+	       regs->hbm_lo_temp_thr);
 	printf("\tLOW_INT  \t| 0x%x \t\t| 0x%-5x\t| %u °C\n",
-	       SBTSI_HBM_LOTEMPINT_LIMIT, (int)(temp_value),
-	       (int)(temp_value));
+	       SBTSI_HBM_LOTEMPINT_LIMIT, regs->hbm_lo_temp_int,
+	       regs->hbm_lo_temp_int);
 	printf("\tLOW_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n",
-	       SBTSI_HBM_LOTEMPDEC_LIMIT,
-	       (uint8_t)((temp_value - floor(temp_value)) / TEMP_INC),
-	       temp_value - floor(temp_value));
-	usleep(APML_SLEEP);
-
-	temp_value = 0;
-	ret = read_sbtsi_max_hbm_temp(soc_num, &temp_value);
-	if (ret)
-		return ret;
+	       SBTSI_HBM_LOTEMPDEC_LIMIT, regs->hbm_lo_temp_dec >> 5,
+	       (regs->hbm_lo_temp_dec >> 5) * TEMP_INC);
 
-	printf("_HBM_MAX_TEMP \t\t|\t\t|\t\t| %.3f °C\n", temp_value);
+	printf("_HBM_MAX_TEMP \t\t|\t\t|\t\t| %.3f °C\n",
+	       regs->hbm_max_temp);
 	printf("\tMAX_INT  \t| 0x%x \t\t| 0x%-5x\t| %u °C\n",
-	       SBTSI_MAX_HBMTEMPINT, (int)(temp_value),
-	       (int)(temp_value));
+	       SBTSI_MAX_HBMTEMPINT, regs->hbm_max_temp_int,
+	       regs->hbm_max_temp_int);
 	printf("\tMAX_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n",
-	       SBTSI_MAX_HBMTEMPDEC,
-	       (uint8_t)((temp_value - floor(temp_value)) / TEMP_INC),
-	       temp_value - floor(temp_value));
-	usleep(APML_SLEEP);
+	       SBTSI_MAX_HBMTEMPDEC, regs->hbm_max_temp_dec >> 5,
+	       (regs->hbm_max_temp_dec >> 5) * TEMP_INC);
 
-	temp_value = 0;
-	ret = read_sbtsi_hbm_temp(soc_num, &temp_value);
-	if (ret)
-		return ret;
-
-	printf("_HBM_TEMP \t\t|\t\t|\t\t| %.3f °C\n", temp_value);
+	printf("_HBM_TEMP \t\t|\t\t|\t\t| %.3f °C\n", regs->hbm_temp);
 	printf("\tHBM_INT  \t| 0x%x \t\t| 0x%-5x\t| %u °C\n",
-	       SBTSI_HBMTEMPINT, (int)(temp_value),
-	       (int)(temp_value));
+	       SBTSI_HBMTEMPINT, regs->hbm_temp_int, regs->hbm_temp_int);
 	printf("\tHBM_DEC \t| 0x%x \t\t| 0x%-5x\t| %.3f °C\n",
-	       SBTSI_HBMTEMPDEC,
-	       (uint8_t)((temp_value - floor(temp_value)) / TEMP_INC),
-	       temp_value - floor(temp_value));
-	usleep(APML_SLEEP);
-
-	return ret;
+	       SBTSI_HBMTEMPDEC, regs->hbm_temp_dec >> 5,
+	       (regs->hbm_temp_dec >> 5) * TEMP_INC);
 }
 
 static oob_status_t apml_set_hbm_alert_threshold(uint8_t soc_num, uint8_t value)
@@ -41,6 +41,8 @@
 
 #include <stdint.h>
 
+#include <esmi_oob/esmi_tsi.h>
+
 /**
  *  @brief Displays the list of MI300 commands available for the module.
  *
@@ -82,18 +84,15 @@ oob_status_t parseesb_mi300_args(int argc, char **argv, uint8_t soc_num);
 void get_mi300_mailbox_commands(char *exe_name);
 
 /**
- *  @brief Get the mi300 specific tsi register descriptions.
+ *  @brief Print the mi300 specific tsi register descriptions.
  *
  *  @details This function will print mi300 specific tsi register
- *  descriptions.
- *
- *  @param[in] soc_num socket number.
+ *  descriptions from a register snapshot.
  *
- *  @retval ::OOB_SUCCESS is returned upon successful call.
- *  @retval None-zero is returned upon failure.
+ *  @param[in] regs snapshot read by sbtsi_read_all().
  *
  */
-oob_status_t get_apml_mi300_tsi_register_descriptions(uint8_t soc_num);
+void get_apml_mi300_tsi_register_descriptions(const struct sbtsi_regs *regs);
 
 /**
  *  @brief Get the mi300 mailbox commands summary.
@@ -109,14 +108,11 @@ oob_status_t get_apml_mi300_tsi_register_descriptions(uint8_t soc_num);
  */
 void get_mi_300_mailbox_cmds_summary(uint8_t soc_num);
 /**
- *  @brief Get the HBM temperature status.
+ *  @brief Print the HBM temperature status.
  *
- *  @details This function will HBM temperature status.
+ *  @details This function will print the HBM temperature status.
  *
- *  @param[in] soc_num socket number.
- *
- *  @retval ::OOB_SUCCESS is returned upon successful call.
- *  @retval None-zero is returned upon failure.
+ *  @param[in] reg_val SBTSI::Status value.
  *
  */
-oob_status_t get_hbm_temp_status(uint8_t soc_num);
+void get_hbm_temp_status(uint8_t reg_val);